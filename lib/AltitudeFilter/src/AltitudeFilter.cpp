@@ -0,0 +1,104 @@
+#include "AltitudeFilter.h"
+
+AltitudeFilter::AltitudeFilter(float measurementNoise, float processNoise)
+    : _r(measurementNoise * measurementNoise), _q(processNoise)
+{
+  reset();
+}
+
+void AltitudeFilter::reset()
+{
+  _initialized = false;
+  for (int i = 0; i < 3; i++)
+  {
+    _x[i] = 0;
+    for (int j = 0; j < 3; j++)
+    {
+      _p[i][j] = 0;
+    }
+  }
+}
+
+void AltitudeFilter::update(float altitude, uint32_t timeUs)
+{
+  uint32_t elapsedUs = timeUs - _lastTimeUs;
+
+  if (!_initialized || elapsedUs > maxGapUs)
+  {
+    // unknown speed and acceleration, start with a wide uncertainty
+    reset();
+    _x[0] = altitude;
+    _p[0][0] = _r;
+    _p[1][1] = 100;
+    _p[2][2] = 100;
+    _lastTimeUs = timeUs;
+    _initialized = true;
+    return;
+  }
+
+  _lastTimeUs = timeUs;
+  if (elapsedUs > 0)
+  {
+    predict(elapsedUs * 1e-6f);
+  }
+  correct(altitude);
+}
+
+void AltitudeFilter::predict(float dt)
+{
+  float dt2 = dt * dt;
+  float dt3 = dt2 * dt;
+
+  // x = F x with F = [1 dt dt²/2; 0 1 dt; 0 0 1]
+  _x[0] += _x[1] * dt + _x[2] * dt2 / 2;
+  _x[1] += _x[2] * dt;
+
+  // P = F P F'
+  float fp[3][3];
+  for (int j = 0; j < 3; j++)
+  {
+    fp[0][j] = _p[0][j] + dt * _p[1][j] + dt2 / 2 * _p[2][j];
+    fp[1][j] = _p[1][j] + dt * _p[2][j];
+    fp[2][j] = _p[2][j];
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    _p[i][0] = fp[i][0] + dt * fp[i][1] + dt2 / 2 * fp[i][2];
+    _p[i][1] = fp[i][1] + dt * fp[i][2];
+    _p[i][2] = fp[i][2];
+  }
+
+  // P += Q for white jerk noise
+  _p[0][0] += _q * dt3 * dt2 / 20;
+  _p[0][1] += _q * dt2 * dt2 / 8;
+  _p[0][2] += _q * dt3 / 6;
+  _p[1][0] += _q * dt2 * dt2 / 8;
+  _p[1][1] += _q * dt3 / 3;
+  _p[1][2] += _q * dt2 / 2;
+  _p[2][0] += _q * dt3 / 6;
+  _p[2][1] += _q * dt2 / 2;
+  _p[2][2] += _q * dt;
+}
+
+void AltitudeFilter::correct(float altitude)
+{
+  // only the altitude is measured, so the gain is the first column of P scaled by the innovation variance
+  float innovation = altitude - _x[0];
+  float s = _p[0][0] + _r;
+  float k[3] = {_p[0][0] / s, _p[1][0] / s, _p[2][0] / s};
+
+  for (int i = 0; i < 3; i++)
+  {
+    _x[i] += k[i] * innovation;
+  }
+
+  // P = (I - K H) P
+  float p0[3] = {_p[0][0], _p[0][1], _p[0][2]};
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      _p[i][j] -= k[i] * p0[j];
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef ALTITUDEFILTER_H
+#define ALTITUDEFILTER_H
+
+#include <stdint.h>
+
+// Kalman filter with altitude, vertical speed and vertical acceleration as state.
+// The model assumes constant acceleration between samples driven by white jerk
+// noise. Each update costs the same fixed number of float operations and uses no
+// heap, the time step comes from the microsecond timestamps of the samples.
+class AltitudeFilter
+{
+  public:
+    // measurementNoise: standard deviation of one altitude measurement in m
+    // processNoise: spectral density of the jerk in m^2/s^5, higher reacts faster to exit and deployment
+    AltitudeFilter(float measurementNoise = 0.4, float processNoise = 50.0);
+
+    // forget the state, the next update starts from that measurement
+    void reset();
+    void update(float altitude, uint32_t timeUs);
+
+    bool initialized() const { return _initialized; }
+    float altitude() const { return _x[0]; }
+    // m/s, positive when climbing
+    float verticalSpeed() const { return _x[1]; }
+    // m/s^2
+    float acceleration() const { return _x[2]; }
+
+  private:
+    void predict(float dt);
+    void correct(float altitude);
+
+    // longest gap between samples before the filter starts over, in us
+    static const uint32_t maxGapUs = 2000000;
+
+    float _r;
+    float _q;
+    bool _initialized = false;
+    uint32_t _lastTimeUs = 0;
+    float _x[3];
+    float _p[3][3];
+};
+
+#endif // end of ALTITUDEFILTER_H
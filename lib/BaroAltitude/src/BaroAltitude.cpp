@@ -0,0 +1,72 @@
+#include "BaroAltitude.h"
+#include <math.h>
+
+namespace
+{
+  // compile time ln() and exp() to build the table, plain series are accurate enough in double
+
+  constexpr double constLog(double x)
+  {
+    // ln(x) = 2 atanh((x - 1) / (x + 1))
+    double z = (x - 1) / (x + 1);
+    double z2 = z * z;
+    double term = z;
+    double sum = 0;
+    for (int k = 1; k < 200; k += 2)
+    {
+      sum += term / k;
+      term *= z2;
+    }
+    return 2 * sum;
+  }
+
+  constexpr double constExp(double x)
+  {
+    double sum = 1;
+    double term = 1;
+    for (int k = 1; k < 40; k++)
+    {
+      term *= x / k;
+      sum += term;
+    }
+    return sum;
+  }
+
+  constexpr double altitudeFromRatio(double ratio)
+  {
+    return 44330 * (1 - constExp(0.1903 * constLog(ratio)));
+  }
+
+  struct AltitudeTable
+  {
+    float altitude[BaroAltitude::segments + 1];
+
+    constexpr AltitudeTable() : altitude()
+    {
+      for (int i = 0; i <= BaroAltitude::segments; i++)
+      {
+        altitude[i] = altitudeFromRatio(BaroAltitude::minRatio + (double)(BaroAltitude::maxRatio - BaroAltitude::minRatio) * i / BaroAltitude::segments);
+      }
+    }
+  };
+
+  constexpr AltitudeTable table;
+  constexpr float segmentsPerRatio = BaroAltitude::segments / (BaroAltitude::maxRatio - BaroAltitude::minRatio);
+}
+
+float BaroAltitude::fromRatio(float ratio)
+{
+  float position = (ratio - minRatio) * segmentsPerRatio;
+  if (!(position >= 0) || position >= segments)
+  {
+    return fromRatioExact(ratio);
+  }
+  int index = position;
+  float fraction = position - index;
+  return table.altitude[index] + (table.altitude[index + 1] - table.altitude[index]) * fraction;
+}
+
+float BaroAltitude::fromRatioExact(float ratio)
+{
+  return 44330 * (1.0 - pow(ratio, 0.1903));
+}
@@ -0,0 +1,29 @@
+#ifndef BAROALTITUDE_H
+#define BAROALTITUDE_H
+
+// Barometric altitude without pow() per sample.
+//
+// altitude = 44330 * (1 - (p / p0)^0.1903), the formula of Adafruit_BMP280::readAltitude(),
+// is tabulated over the pressure ratio p / p0 at compile time and interpolated linearly.
+// The table covers ratios 0.25 to 1.25, that is 300 to 1100 hPa for any ground reference
+// between 880 and 1100 hPa (dropzones from sea level to about 1200 m elevation).
+//
+// Error bound against the pow() formula, from the curvature of the formula and the
+// 1/256 table step: below 0.16 m over the whole table (worst at ratio 0.25, about 10 km),
+// below 0.07 m for ratios above 0.4 (below 7 km) and below 0.02 m for ratios above 0.9
+// (the last 900 m). Outside the table the exact formula is used.
+class BaroAltitude
+{
+  public:
+    static const int segments = 256;
+    static constexpr float minRatio = 0.25f;
+    static constexpr float maxRatio = 1.25f;
+
+    // pressure and referencePressure in the same unit
+    static float fromPressure(float pressure, float referencePressure) { return fromRatio(pressure / referencePressure); }
+    static float fromRatio(float ratio);
+    // reference implementation with pow()
+    static float fromRatioExact(float ratio);
+};
+
+#endif // end of BAROALTITUDE_H
@@ -0,0 +1,77 @@
+#include "BatteryMonitor.h"
+
+namespace
+{
+  // single cell at rest, from full to empty
+  struct CurvePoint
+  {
+    uint16_t millivolts;
+    uint8_t percent;
+  };
+
+  const CurvePoint curve[] = {
+      {4200, 100}, {4150, 95}, {4110, 90}, {4080, 85}, {4020, 80}, {3980, 75}, {3950, 70},
+      {3910, 65},  {3870, 60}, {3850, 55}, {3840, 50}, {3820, 45}, {3800, 40}, {3790, 35},
+      {3770, 30},  {3750, 25}, {3730, 20}, {3710, 15}, {3690, 10}, {3610, 5},  {3270, 0},
+  };
+  const uint8_t curvePoints = sizeof(curve) / sizeof(curve[0]);
+}
+
+esp_adc_cal_value_t BatteryMonitor::begin()
+{
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  // 11 dB: about 150 to 2450 mV at the pin, a full cell behind a 1:2 divider is 2100 mV
+  adc1_config_channel_atten(_channel, ADC_ATTEN_DB_11);
+  esp_adc_cal_value_t type = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &_calibration);
+
+  uint16_t mv = readBurst();
+  for (uint8_t i = 0; i < window; i++)
+  {
+    _values[i] = mv;
+  }
+  _sumMv = (uint32_t)mv * window;
+  _next = 0;
+  return type;
+}
+
+bool BatteryMonitor::update()
+{
+  uint16_t mv = readBurst();
+  _sumMv += mv - _values[_next];
+  _values[_next] = mv;
+  _next = (_next + 1) % window;
+  return _next == 0;
+}
+
+uint16_t BatteryMonitor::readBurst()
+{
+  uint32_t raw = 0;
+  for (uint8_t i = 0; i < burst; i++)
+  {
+    raw += adc1_get_raw(_channel);
+  }
+  // the rounded average, the calibration takes a 12 bit reading
+  uint32_t pinMv = esp_adc_cal_raw_to_voltage((raw + burst / 2) / burst, &_calibration);
+  return pinMv * _dividerRatio;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+uint8_t BatteryMonitor::percentAt(uint16_t millivolts)
+{
+  if (millivolts >= curve[0].millivolts)
+  {
+    return 100;
+  }
+  for (uint8_t i = 1; i < curvePoints; i++)
+  {
+    if (millivolts >= curve[i].millivolts)
+    {
+      const CurvePoint &upper = curve[i - 1];
+      const CurvePoint &lower = curve[i];
+      return lower.percent + (uint32_t)(millivolts - lower.millivolts) * (upper.percent - lower.percent) /
+                                 (upper.millivolts - lower.millivolts);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef BATTERYMONITOR_H
+#define BATTERYMONITOR_H
+
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+// LiPo voltage through a resistor divider on an ADC1 pin, and what it means for the charge.
+//
+// The raw readings are turned into mV with the calibration burnt into the eFuse (two point
+// or Vref, whatever the chip has). Every update() reads a short burst and averages it, and
+// the voltage is the moving average over the last bursts, so the ADC noise of a few LSB
+// drops below 1 mV while a single update stays short enough to run between two jobs.
+//
+// The charge left comes from the rest voltage curve of a single LiPo cell. Under the load
+// of the altimeter (a few 10 mA) the cell sits only some mV below its rest voltage.
+class BatteryMonitor
+{
+  public:
+    static const uint8_t burst = 8;  // raw readings per update, about 10 us each
+    static const uint8_t window = 8; // updates in the average
+
+    BatteryMonitor(adc1_channel_t channel, float dividerRatio, uint16_t capacityMah)
+        : _channel(channel), _dividerRatio(dividerRatio), _capacityMah(capacityMah) {}
+
+    // configures the ADC and fills the average; returns the kind of calibration used
+    esp_adc_cal_value_t begin();
+    // one burst; returns true once per window, when all values in the average are new
+    bool update();
+
+    uint16_t millivolts() const { return _sumMv / window; }
+    uint8_t percent() const { return percentAt(millivolts()); }
+    // 0 to steps, e.g. for a battery symbol
+    uint8_t level(uint8_t steps) const { return (percent() * steps + 50) / 100; }
+    uint16_t remainingMah() const { return (uint32_t)_capacityMah * percent() / 100; }
+
+    // LiPo rest voltage curve, linear between the points
+    static uint8_t percentAt(uint16_t millivolts);
+
+  private:
+    uint16_t readBurst();
+
+    adc1_channel_t _channel;
+    float _dividerRatio;
+    uint16_t _capacityMah;
+    esp_adc_cal_characteristics_t _calibration;
+    uint16_t _values[window] = {};
+    uint32_t _sumMv = 0;
+    uint8_t _next = 0;
+};
+
+#endif // end of BATTERYMONITOR_H
@@ -0,0 +1,227 @@
+#include "Bmp280.h"
+
+#define BMP280_REGISTER_CALIBRATION 0x88
+#define BMP280_REGISTER_CHIPID 0xD0
+#define BMP280_REGISTER_CONTROL 0xF4
+#define BMP280_REGISTER_CONFIG 0xF5
+#define BMP280_REGISTER_PRESSUREDATA 0xF7
+
+// value of a data register while its measurement is skipped
+#define BMP280_SKIPPED 0x80000
+
+Bmp280::Bmp280(TwoWire &wire) : _wire(wire)
+{
+}
+
+bool Bmp280::begin(uint8_t address)
+{
+  if (!attach(address))
+  {
+    return false;
+  }
+  // same settings as Adafruit_BMP280::begin()
+  if (!setSampling(SAMPLING_X2, SAMPLING_X16, FILTER_X16, STANDBY_MS_500))
+  {
+    return false;
+  }
+  // the data registers are invalid until the first conversion finished
+  delayMicroseconds(conversionTimeUs());
+  return read();
+}
+
+bool Bmp280::attach(uint8_t address)
+{
+  uint8_t id;
+  uint8_t buffer[24];
+
+  _address = address;
+  if (!readRegisters(BMP280_REGISTER_CHIPID, &id, 1) || id != chipId)
+  {
+    return false;
+  }
+  if (!readRegisters(BMP280_REGISTER_CALIBRATION, buffer, sizeof(buffer)))
+  {
+    return false;
+  }
+  // little endian words
+  uint16_t words[12];
+  for (int i = 0; i < 12; i++)
+  {
+    words[i] = buffer[2 * i] | (buffer[2 * i + 1] << 8);
+  }
+  _calibration.T1 = words[0];
+  _calibration.T2 = words[1];
+  _calibration.T3 = words[2];
+  _calibration.P1 = words[3];
+  _calibration.P2 = words[4];
+  _calibration.P3 = words[5];
+  _calibration.P4 = words[6];
+  _calibration.P5 = words[7];
+  _calibration.P6 = words[8];
+  _calibration.P7 = words[9];
+  _calibration.P8 = words[10];
+  _calibration.P9 = words[11];
+  return true;
+}
+
+bool Bmp280::setSampling(Oversampling temperature, Oversampling pressure, Filter filter, Standby standby)
+{
+  _temperatureSampling = temperature;
+  _pressureSampling = pressure;
+  _filter = filter;
+  _standby = standby;
+
+  // config writes are only reliable in sleep mode, so sleep, configure and restart in one transaction
+  _wire.beginTransmission(_address);
+  _wire.write(BMP280_REGISTER_CONTROL);
+  _wire.write(0x00);
+  _wire.write(BMP280_REGISTER_CONFIG);
+  _wire.write((standby << 5) | (filter << 2));
+  _wire.write(BMP280_REGISTER_CONTROL);
+  _wire.write((temperature << 5) | (pressure << 2) | 0x03);
+  return _wire.endTransmission() == 0;
+}
+
+uint32_t Bmp280::conversionTimeUs() const
+{
+  // 1.25 ms + 2.3 ms per temperature and pressure oversampling step + 0.575 ms pressure setup
+  uint32_t temperatureSteps = _temperatureSampling ? 1 << (_temperatureSampling - 1) : 0;
+  uint32_t pressureSteps = _pressureSampling ? 1 << (_pressureSampling - 1) : 0;
+  return 1250 + 2300 * temperatureSteps + 2300 * pressureSteps + (pressureSteps ? 575 : 0);
+}
+
+uint32_t Bmp280::measurementPeriodUs() const
+{
+  static const uint32_t standbyUs[] = {500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000};
+  return conversionTimeUs() + standbyUs[_standby];
+}
+
+float Bmp280::noisePa() const
+{
+  // 2.62 Pa for a single conversion, every doubling of the oversampling halves the variance
+  static const float samplingNoise[] = {0, 2.62, 1.85, 1.31, 0.93, 0.66};
+  // an IIR filter with coefficient c keeps 1 / (2c - 1) of the noise variance
+  static const float filterFactor[] = {1, 0.577, 0.378, 0.258, 0.180};
+  return samplingNoise[_pressureSampling] * filterFactor[_filter];
+}
+
+bool Bmp280::read()
+{
+  uint8_t data[6];
+
+  if (!readRegisters(BMP280_REGISTER_PRESSUREDATA, data, sizeof(data)))
+  {
+    return false;
+  }
+  int32_t adcP = ((uint32_t)data[0] << 12) | ((uint32_t)data[1] << 4) | (data[2] >> 4);
+  int32_t adcT = ((uint32_t)data[3] << 12) | ((uint32_t)data[4] << 4) | (data[5] >> 4);
+  if (adcT == BMP280_SKIPPED || adcP == BMP280_SKIPPED)
+  {
+    return false;
+  }
+  _temperature = compensateTemperature(_calibration, adcT, _tFine);
+  _pressure = compensatePressure(_calibration, adcP, _tFine);
+  return true;
+}
+
+bool Bmp280::sleep()
+{
+  _wire.beginTransmission(_address);
+  _wire.write(BMP280_REGISTER_CONTROL);
+  _wire.write(0x00);
+  _wire.write(BMP280_REGISTER_CONFIG);
+  _wire.write(0x00);
+  return _wire.endTransmission() == 0;
+}
+
+bool Bmp280::readForced(Oversampling temperature, Oversampling pressure)
+{
+  _temperatureSampling = temperature;
+  _pressureSampling = pressure;
+  _filter = FILTER_OFF;
+
+  // a filter left from normal mode would mix the new conversion with the old ones
+  _wire.beginTransmission(_address);
+  _wire.write(BMP280_REGISTER_CONTROL);
+  _wire.write(0x00);
+  _wire.write(BMP280_REGISTER_CONFIG);
+  _wire.write(_standby << 5);
+  _wire.write(BMP280_REGISTER_CONTROL);
+  _wire.write((temperature << 5) | (pressure << 2) | 0x01);
+  if (_wire.endTransmission() != 0)
+  {
+    return false;
+  }
+  delayMicroseconds(conversionTimeUs());
+  return read();
+}
+
+int32_t Bmp280::rawPressure(float pressure) const
+{
+  // the compensated pressure falls with the raw reading, bisect for the smallest raw value at or below pressure
+  uint32_t target = pressure * 256;
+  int32_t low = 0;
+  int32_t high = 0xFFFFF;
+  while (low < high)
+  {
+    int32_t mid = (low + high) / 2;
+    if (compensatePressure(_calibration, mid, _tFine) > target)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+int32_t Bmp280::compensateTemperature(const Calibration &c, int32_t adcT, int32_t &tFine)
+{
+  int32_t var1 = ((((adcT >> 3) - ((int32_t)c.T1 << 1))) * ((int32_t)c.T2)) >> 11;
+  int32_t var2 = (((((adcT >> 4) - ((int32_t)c.T1)) * ((adcT >> 4) - ((int32_t)c.T1))) >> 12) * ((int32_t)c.T3)) >> 14;
+  tFine = var1 + var2;
+  return (tFine * 5 + 128) >> 8;
+}
+
+uint32_t Bmp280::compensatePressure(const Calibration &c, int32_t adcP, int32_t tFine)
+{
+  int64_t var1 = ((int64_t)tFine) - 128000;
+  int64_t var2 = var1 * var1 * (int64_t)c.P6;
+  var2 = var2 + ((var1 * (int64_t)c.P5) << 17);
+  var2 = var2 + (((int64_t)c.P4) << 35);
+  var1 = ((var1 * var1 * (int64_t)c.P3) >> 8) + ((var1 * (int64_t)c.P2) << 12);
+  var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)c.P1) >> 33;
+  if (var1 == 0)
+  {
+    // avoid division by zero
+    return 0;
+  }
+  int64_t p = 1048576 - adcP;
+  p = (((p << 31) - var2) * 3125) / var1;
+  var1 = (((int64_t)c.P9) * (p >> 13) * (p >> 13)) >> 25;
+  var2 = (((int64_t)c.P8) * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + (((int64_t)c.P7) << 4);
+  return (uint32_t)p;
+}
+
+bool Bmp280::readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length)
+{
+  _wire.beginTransmission(_address);
+  _wire.write(reg);
+  // repeated start, the register pointer auto increments during the burst
+  if (_wire.endTransmission(false) != 0)
+  {
+    return false;
+  }
+  if (_wire.requestFrom(_address, length) != length)
+  {
+    return false;
+  }
+  for (uint8_t i = 0; i < length; i++)
+  {
+    buffer[i] = _wire.read();
+  }
+  return true;
+}
@@ -0,0 +1,113 @@
+#ifndef BMP280_H
+#define BMP280_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Minimal BMP280 driver: pressure and temperature come from one 6 byte burst
+// read and are compensated with the 32/64 bit integer formulas of the Bosch
+// datasheet, so a sample costs a single I2C transaction and no float math.
+class Bmp280
+{
+  public:
+    static const uint8_t chipId = 0x58;
+
+    // register values of osrs_t / osrs_p
+    enum Oversampling : uint8_t
+    {
+      SAMPLING_SKIPPED = 0,
+      SAMPLING_X1,
+      SAMPLING_X2,
+      SAMPLING_X4,
+      SAMPLING_X8,
+      SAMPLING_X16
+    };
+
+    // IIR filter coefficient
+    enum Filter : uint8_t
+    {
+      FILTER_OFF = 0,
+      FILTER_X2,
+      FILTER_X4,
+      FILTER_X8,
+      FILTER_X16
+    };
+
+    // inactive time between two conversions in normal mode
+    enum Standby : uint8_t
+    {
+      STANDBY_MS_1 = 0, // 0.5 ms
+      STANDBY_MS_63,    // 62.5 ms
+      STANDBY_MS_125,
+      STANDBY_MS_250,
+      STANDBY_MS_500,
+      STANDBY_MS_1000,
+      STANDBY_MS_2000,
+      STANDBY_MS_4000
+    };
+
+    // trimming parameters from registers 0x88 to 0x9F
+    struct Calibration
+    {
+      uint16_t T1;
+      int16_t T2;
+      int16_t T3;
+      uint16_t P1;
+      int16_t P2;
+      int16_t P3;
+      int16_t P4;
+      int16_t P5;
+      int16_t P6;
+      int16_t P7;
+      int16_t P8;
+      int16_t P9;
+    };
+
+    Bmp280(TwoWire &wire = Wire);
+    bool begin(uint8_t address);
+    // checks the chip id and reads the trimming parameters, the sensor keeps its mode and settings
+    bool attach(uint8_t address);
+    // switches to normal mode with the given settings
+    bool setSampling(Oversampling temperature, Oversampling pressure, Filter filter, Standby standby);
+    // burst read of the raw data registers, updates pressure and temperature
+    bool read();
+    // stops conversions and clears the IIR filter, a forced measurement afterwards is unfiltered
+    bool sleep();
+    // one unfiltered conversion in forced mode: starts it, waits for it and reads it, the sensor sleeps afterwards
+    bool readForced(Oversampling temperature, Oversampling pressure);
+
+    // maximum duration of one conversion with the current oversampling (datasheet 3.8.1)
+    uint32_t conversionTimeUs() const;
+    // time between two conversions in normal mode, the sensor has no new data more often than that
+    uint32_t measurementPeriodUs() const;
+    // expected RMS pressure noise in Pa with the current oversampling and IIR filter
+    float noisePa() const;
+
+    // Pa
+    float pressure() const { return _pressure / 256.0f; }
+    // °C, cached from the last read()
+    float temperature() const { return _temperature / 100.0f; }
+    // 20 bit raw reading that compensates to the given pressure in Pa at the temperature of the last read()
+    int32_t rawPressure(float pressure) const;
+
+    // datasheet section 8.2, temperature in 0.01 °C and tFine for the pressure formula
+    static int32_t compensateTemperature(const Calibration &calibration, int32_t adcT, int32_t &tFine);
+    // datasheet section 8.2, pressure in Pa as unsigned Q24.8
+    static uint32_t compensatePressure(const Calibration &calibration, int32_t adcP, int32_t tFine);
+
+  private:
+    bool readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length);
+
+    TwoWire &_wire;
+    uint8_t _address = 0;
+    Calibration _calibration;
+    Oversampling _temperatureSampling = SAMPLING_SKIPPED;
+    Oversampling _pressureSampling = SAMPLING_SKIPPED;
+    Filter _filter = FILTER_OFF;
+    Standby _standby = STANDBY_MS_1;
+    uint32_t _pressure = 0;
+    int32_t _temperature = 0;
+    int32_t _tFine = 0;
+};
+
+#endif // end of BMP280_H
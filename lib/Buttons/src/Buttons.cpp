@@ -0,0 +1,149 @@
+#include "Buttons.h"
+#include <driver/gpio.h>
+
+void Buttons::begin(TaskHandle_t consumer, uint32_t notifyBits)
+{
+  _consumer = consumer;
+  _notifyBits = notifyBits;
+
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    Button &button = _buttons[i];
+    button.owner = this;
+    button.pin = _pins[i];
+    button.index = i;
+    pinMode(button.pin, INPUT_PULLUP);
+
+    esp_timer_create_args_t args = {};
+    args.arg = &button;
+    args.callback = onDebounced;
+    args.name = "debounce";
+    esp_timer_create(&args, &button.debounceTimer);
+    args.callback = onLongPress;
+    args.name = "long press";
+    esp_timer_create(&args, &button.longPressTimer);
+
+    // held since the wakeup: no PRESS, but the long press counts from now
+    button.pressed = digitalRead(button.pin) == LOW;
+    button.pressUs = esp_timer_get_time();
+    if (button.pressed)
+    {
+      esp_timer_start_once(button.longPressTimer, longPressMs * 1000);
+    }
+    attachInterruptArg(button.pin, onEdge, &button, CHANGE);
+  }
+}
+
+void Buttons::clear()
+{
+  Event event;
+  while (_events.pop(event))
+  {
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void IRAM_ATTR Buttons::onEdge(void *arg)
+{
+  startDebounce(*(Button *)arg);
+}
+
+void IRAM_ATTR Buttons::startDebounce(Button &button)
+{
+  if (!button.bouncing)
+  {
+    button.edgeUs = esp_timer_get_time();
+    button.bouncing = true;
+  }
+  // every further edge moves the end of the debounce
+  esp_timer_stop(button.debounceTimer);
+  esp_timer_start_once(button.debounceTimer, debounceMs * 1000);
+}
+
+void Buttons::onDebounced(void *arg)
+{
+  Button &button = *(Button *)arg;
+  button.bouncing = false;
+  bool down = digitalRead(button.pin) == LOW;
+  if (down == button.pressed)
+  {
+    // bounced back to where it was
+    return;
+  }
+  button.pressed = down;
+
+  if (down)
+  {
+    button.pressUs = button.edgeUs;
+    button.longPresses = 0;
+    button.owner->push(button, PRESS, button.pressUs);
+    int64_t untilUs = button.pressUs + longPressMs * 1000 - esp_timer_get_time();
+    esp_timer_start_once(button.longPressTimer, untilUs > 0 ? untilUs : 0);
+  }
+  else
+  {
+    esp_timer_stop(button.longPressTimer);
+    button.owner->push(button, RELEASE, button.edgeUs);
+  }
+}
+
+void Buttons::onLongPress(void *arg)
+{
+  Button &button = *(Button *)arg;
+  button.longPresses++;
+  button.owner->push(button, LONG_PRESS, button.pressUs + (int64_t)button.longPresses * longPressMs * 1000);
+  // counted from the press, a late callback does not move the next one
+  int64_t untilUs = button.pressUs + (int64_t)(button.longPresses + 1) * longPressMs * 1000 - esp_timer_get_time();
+  esp_timer_start_once(button.longPressTimer, untilUs > 0 ? untilUs : 0);
+}
+
+void Buttons::push(const Button &button, Type type, int64_t timeUs)
+{
+  Event event;
+  event.button = button.index;
+  event.type = type;
+  event.heldMs = type == PRESS ? 0 : (timeUs - button.pressUs) / 1000;
+  event.timeMs = timeUs / 1000;
+  _events.push(event);
+  if (_consumer)
+  {
+    xTaskNotify(_consumer, _notifyBits, eSetBits);
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+bool Buttons::prepareSleep()
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_buttons[i].pressed || _buttons[i].bouncing)
+    {
+      return false;
+    }
+  }
+  // the wakeup needs a level interrupt, which would fire over and over while the button is held
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    gpio_intr_disable((gpio_num_t)_buttons[i].pin);
+    gpio_wakeup_enable((gpio_num_t)_buttons[i].pin, GPIO_INTR_LOW_LEVEL);
+  }
+  return true;
+}
+
+void Buttons::resumeSleep()
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    Button &button = _buttons[i];
+    gpio_wakeup_disable((gpio_num_t)button.pin);
+    gpio_set_intr_type((gpio_num_t)button.pin, GPIO_INTR_ANYEDGE);
+    gpio_intr_enable((gpio_num_t)button.pin);
+    // the edge that woke the chip came while the interrupt was off
+    if ((digitalRead(button.pin) == LOW) != button.pressed)
+    {
+      startDebounce(button);
+    }
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <Arduino.h>
+#include <SampleRing.h>
+#include <esp_timer.h>
+
+// Push buttons to ground on GPIOs with pull-ups, driven by pin interrupts instead of polling.
+//
+// Every edge (re)starts a one-shot debounce timer of the button, the level is only read
+// once it was quiet for debounceMs. A changed level becomes a PRESS or RELEASE event,
+// and while a button is held a LONG_PRESS follows every longPressMs. The times count
+// from the first edge of the bounce, not from the end of the debounce.
+//
+// The ISR only restarts the timer. The timer callbacks all run in the esp_timer task,
+// the only producer of the event ring, and notify the consumer task for every event.
+class Buttons
+{
+  public:
+    static const uint8_t maxButtons = 4;
+    static const uint32_t debounceMs = 25;
+    static const uint32_t longPressMs = 1000;
+
+    enum Type : uint8_t
+    {
+      PRESS,
+      LONG_PRESS, // heldMs = n * longPressMs
+      RELEASE,
+    };
+
+    struct Event
+    {
+      uint8_t button; // index into the pins given to the constructor
+      Type type;
+      uint32_t heldMs; // since the press, 0 for PRESS
+      uint32_t timeMs; // millis() of the edge or the long press
+    };
+
+    Buttons(const uint8_t *pins, uint8_t count) : _pins(pins), _count(count < maxButtons ? count : maxButtons) {}
+
+    // the consumer task gets notifyBits (eSetBits) with every event
+    void begin(TaskHandle_t consumer, uint32_t notifyBits);
+    bool read(Event &event) { return _events.pop(event); }
+    bool available() const { return _events.available() > 0; }
+    // drops the events nobody read, e.g. after a mode change
+    void clear();
+    // debounced state
+    bool pressed(uint8_t button) const { return _buttons[button].pressed; }
+    uint32_t dropped() const { return _events.dropped(); }
+
+    // light sleep: false while a button is held or bouncing, otherwise each pin wakes the chip
+    // on low level with its interrupt off, resumeSleep() switches back and catches the press
+    // that ended the sleep
+    bool prepareSleep();
+    void resumeSleep();
+
+  private:
+    struct Button
+    {
+      Buttons *owner;
+      uint8_t pin;
+      uint8_t index;
+      esp_timer_handle_t debounceTimer;
+      esp_timer_handle_t longPressTimer;
+      volatile bool bouncing;
+      volatile int64_t edgeUs; // first edge since the level was last read
+      bool pressed;
+      int64_t pressUs;
+      uint32_t longPresses;
+    };
+
+    static void IRAM_ATTR onEdge(void *arg);
+    static void onDebounced(void *arg);
+    static void onLongPress(void *arg);
+    static void IRAM_ATTR startDebounce(Button &button);
+    void push(const Button &button, Type type, int64_t timeUs);
+
+    const uint8_t *_pins;
+    uint8_t _count;
+    Button _buttons[maxButtons] = {};
+    SampleRing<Event, 16> _events;
+    TaskHandle_t _consumer = NULL;
+    uint32_t _notifyBits = 0;
+};
+
+#endif // end of BUTTONS_H
@@ -0,0 +1,142 @@
+#include "DebugLog.h"
+
+#include <stdarg.h>
+
+DebugLog debugLog;
+
+static const char levelLetters[] = "-EWID";
+
+void DebugLog::begin(Print &output, BaseType_t core)
+{
+  _output = &output;
+  // below the Arduino loop and the sensor task, it only runs when both wait
+  xTaskCreatePinnedToCore(taskMain, "log", 3072, this, tskIDLE_PRIORITY + 1, &_task, core);
+}
+
+bool DebugLog::print(uint8_t level, const char *format, ...)
+{
+  char text[maxText + 1];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0)
+  {
+    return false;
+  }
+  return write(level, text, (size_t)length < maxText ? length : maxText);
+}
+
+bool DebugLog::write(uint8_t level, const char *text, size_t length)
+{
+  return push(TEXT, level, text, length < maxText ? length : maxText);
+}
+
+bool DebugLog::values(uint8_t level, const char *format, int32_t a, int32_t b, int32_t c, int32_t d)
+{
+  Values record = {format, {a, b, c, d}};
+  return push(VALUES, level, &record, sizeof(record));
+}
+
+void DebugLog::flush()
+{
+  if (_task == NULL)
+  {
+    return;
+  }
+  while (_tail.load(std::memory_order_acquire) != _head.load(std::memory_order_acquire))
+  {
+    xTaskNotifyGive(_task);
+    vTaskDelay(1);
+  }
+  _output->flush();
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+bool DebugLog::push(Type type, uint8_t level, const void *payload, size_t length)
+{
+  Header header = {type, level, (uint16_t)length, (uint32_t)millis()};
+  uint32_t head = _head.load(std::memory_order_relaxed);
+  if (head - _tail.load(std::memory_order_acquire) + sizeof(header) + length > size)
+  {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  copyIn(head, &header, sizeof(header));
+  copyIn(head + sizeof(header), payload, length);
+  _head.store(head + sizeof(header) + length, std::memory_order_release);
+  if (_task != NULL)
+  {
+    xTaskNotifyGive(_task);
+  }
+  return true;
+}
+
+// records wrap around the end of the buffer
+void DebugLog::copyIn(uint32_t position, const void *data, size_t length)
+{
+  size_t offset = position & (size - 1);
+  size_t first = length < size - offset ? length : size - offset;
+  memcpy(_buffer + offset, data, first);
+  memcpy(_buffer, (const uint8_t *)data + first, length - first);
+}
+
+void DebugLog::copyOut(uint32_t position, void *data, size_t length)
+{
+  size_t offset = position & (size - 1);
+  size_t first = length < size - offset ? length : size - offset;
+  memcpy(data, _buffer + offset, first);
+  memcpy((uint8_t *)data + first, _buffer, length - first);
+}
+
+void DebugLog::drain()
+{
+  uint32_t tail = _tail.load(std::memory_order_relaxed);
+  while (tail != _head.load(std::memory_order_acquire))
+  {
+    Header header;
+    char line[maxText + 24];
+    copyOut(tail, &header, sizeof(header));
+    int prefix = snprintf(line, sizeof(line), "[%7lu %c] ", (unsigned long)header.timeMs, levelLetters[header.level <= LOG_LEVEL_DEBUG ? header.level : 0]);
+    int length = prefix;
+    if (header.type == VALUES)
+    {
+      Values record;
+      copyOut(tail + sizeof(header), &record, sizeof(record));
+      length += snprintf(line + prefix, sizeof(line) - prefix, record.format, (int)record.values[0], (int)record.values[1],
+                         (int)record.values[2], (int)record.values[3]);
+    }
+    else
+    {
+      copyOut(tail + sizeof(header), line + prefix, header.length);
+      length += header.length;
+    }
+    tail += sizeof(header) + header.length;
+    _tail.store(tail, std::memory_order_release);
+
+    length = length < (int)sizeof(line) - 2 ? length : sizeof(line) - 2;
+    line[length++] = '\r';
+    line[length++] = '\n';
+    _output->write((const uint8_t *)line, length);
+  }
+
+  uint32_t dropped = _dropped.load(std::memory_order_relaxed);
+  if (dropped != _reportedDropped)
+  {
+    char line[48];
+    int length = snprintf(line, sizeof(line), "[log] %lu records dropped\r\n", (unsigned long)(dropped - _reportedDropped));
+    _output->write((const uint8_t *)line, length);
+    _reportedDropped = dropped;
+  }
+}
+
+void DebugLog::taskMain(void *arg)
+{
+  DebugLog *self = (DebugLog *)arg;
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    self->drain();
+  }
+}
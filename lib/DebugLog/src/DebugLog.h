@@ -0,0 +1,107 @@
+#ifndef DEBUGLOG_H
+#define DEBUGLOG_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// log levels, a message is compiled in if its level is at most LOG_LEVEL
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// messages above LOG_LEVEL compile to nothing, their arguments are not evaluated
+#define LOG_AT(level, ...)                       \
+  do                                             \
+  {                                              \
+    if ((level) <= LOG_LEVEL)                    \
+    {                                            \
+      debugLog.print((level), __VA_ARGS__);      \
+    }                                            \
+  } while (0)
+#define LOG_VALUES_AT(level, ...)                \
+  do                                             \
+  {                                              \
+    if ((level) <= LOG_LEVEL)                    \
+    {                                            \
+      debugLog.values((level), __VA_ARGS__);     \
+    }                                            \
+  } while (0)
+
+#define logError(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define logWarning(...) LOG_AT(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define logInfo(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define logDebug(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// Deferred log sink: callers put records into a lock-free ring and return right away,
+// a low priority task writes them to the output. A full ring drops the record and
+// counts it instead of waiting, so logging never blocks the caller.
+//
+// Records are either text, formatted by the caller, or binary: a format string and up
+// to four integers that the drain task formats. Binary records skip the formatting on
+// the caller's side, their format has to stay valid until it is printed (a literal).
+//
+// One writer task only, like SampleRing: the firmware logs from setup() and loop().
+class DebugLog
+{
+  public:
+    static const size_t size = 2048;
+    static const size_t maxText = 120;
+
+    // starts the drain task, records logged before are kept and printed then
+    void begin(Print &output, BaseType_t core);
+
+    // printf into a text record, cut at maxText characters
+    bool print(uint8_t level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+    bool write(uint8_t level, const char *text, size_t length);
+    // binary record, format may only use int conversions (%d, %u, %x)
+    bool values(uint8_t level, const char *format, int32_t a = 0, int32_t b = 0, int32_t c = 0, int32_t d = 0);
+
+    // waits until the drain task printed everything, before deep sleep
+    void flush();
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  private:
+    enum Type : uint8_t
+    {
+      TEXT,
+      VALUES
+    };
+
+    struct Header
+    {
+      Type type;
+      uint8_t level;
+      uint16_t length; // of the payload behind the header
+      uint32_t timeMs;
+    };
+
+    struct Values
+    {
+      const char *format;
+      int32_t values[4];
+    };
+
+    bool push(Type type, uint8_t level, const void *payload, size_t length);
+    void copyIn(uint32_t position, const void *data, size_t length);
+    void copyOut(uint32_t position, void *data, size_t length);
+    void drain();
+    static void taskMain(void *arg);
+
+    uint8_t _buffer[size];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+    uint32_t _reportedDropped = 0;
+    Print *_output = NULL;
+    TaskHandle_t _task = NULL;
+};
+
+extern DebugLog debugLog;
+
+#endif // end of DEBUGLOG_H
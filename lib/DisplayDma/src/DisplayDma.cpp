@@ -0,0 +1,274 @@
+#include "DisplayDma.h"
+#include <driver/gpio.h>
+#include <esp_timer.h>
+
+#define DISPLAY_FRAME_SIZE (128 * 64 / 8)
+
+// spi_transaction_t::user: bit 0 is the level of the data/command line, polling transactions are
+// not counted by postTransfer() because they never went through queue()
+#define TRANSACTION_DATA 1
+#define TRANSACTION_POLLING 2
+
+DisplayDma *DisplayDma::_instance = NULL;
+
+// the SPI DMA reads from here, the framebuffer of U8g2 is free again as soon as it is copied
+DMA_ATTR static uint8_t dmaFrame[DISPLAY_FRAME_SIZE];
+
+DisplayDma::DisplayDma(const u8g2_cb_t *rotation, uint8_t clock, uint8_t data, uint8_t cs, uint8_t dc, uint8_t reset)
+    : U8G2(), _clock(clock), _data(data), _cs(cs), _dc(dc)
+{
+  _instance = this;
+  u8g2_Setup_ssd1309_128x64_noname2_f(&u8g2, rotation, byteCallback, u8x8_gpio_and_delay_arduino);
+  // CS and DC are driven by the SPI driver, the GPIO callback only handles reset
+  u8x8_SetPin_4Wire_HW_SPI(getU8x8(), U8X8_PIN_NONE, U8X8_PIN_NONE, reset);
+}
+
+void DisplayDma::sendBuffer()
+{
+  const uint8_t *buffer = getBufferPtr();
+  uint8_t tileWidth = getBufferTileWidth();
+  uint16_t sent = 0;
+
+  wait();
+  for (uint8_t row = 0; row < getBufferTileHeight(); row++)
+  {
+    const uint8_t *tiles = buffer + row * tileWidth * 8;
+    const uint8_t *shown = dmaFrame + row * tileWidth * 8;
+    int8_t first = -1;
+    int8_t last = -1;
+
+    for (uint8_t tile = 0; tile <= tileWidth; tile++)
+    {
+      bool changed = tile < tileWidth && memcmp(tiles + tile * 8, shown + tile * 8, 8) != 0;
+      if (changed)
+      {
+        first = first < 0 ? tile : first;
+        last = tile;
+      }
+      // a run ends at the end of the row or after more than maxTileGap unchanged tiles
+      if (first >= 0 && !changed && (tile == tileWidth || tile - last > maxTileGap))
+      {
+        copyArea(first, row, last - first + 1, 1);
+        U8G2::updateDisplayArea(first, row, last - first + 1, 1);
+        sent += (last - first + 1) * 8;
+        first = -1;
+      }
+    }
+  }
+  _lastFrameBytes = sent;
+  _bytesSent += sent;
+  _bytesSaved += sizeof(dmaFrame) - sent;
+}
+
+void DisplayDma::updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th)
+{
+  wait();
+  copyArea(tx, ty, tw, th);
+  U8G2::updateDisplayArea(tx, ty, tw, th);
+}
+
+void DisplayDma::clearDisplay()
+{
+  clearBuffer();
+  sendBuffer();
+}
+
+void DisplayDma::wait()
+{
+  while (_collected < _queued)
+  {
+    collect(portMAX_DELAY);
+  }
+}
+
+void DisplayDma::copyArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th)
+{
+  uint8_t *buffer = getBufferPtr();
+  uint16_t rowSize = getBufferTileWidth() * 8;
+
+  for (uint8_t row = ty; row < ty + th; row++)
+  {
+    uint16_t offset = row * rowSize + tx * 8;
+    memcpy(dmaFrame + offset, buffer + offset, tw * 8);
+  }
+}
+
+bool DisplayDma::beginBus()
+{
+  spi_bus_config_t bus;
+  spi_device_interface_config_t device;
+
+  memset(&bus, 0, sizeof(bus));
+  bus.mosi_io_num = _data;
+  bus.miso_io_num = -1;
+  bus.sclk_io_num = _clock;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = sizeof(dmaFrame);
+
+  memset(&device, 0, sizeof(device));
+  device.clock_speed_hz = clockHz;
+  device.mode = 0;
+  device.spics_io_num = _cs;
+  device.queue_size = transactionCount;
+  device.pre_cb = preTransfer;
+  device.post_cb = postTransfer;
+
+  gpio_set_direction((gpio_num_t)_dc, GPIO_MODE_OUTPUT);
+  // 18/23/5 are the native VSPI pins, DMA channel 2
+  return spi_bus_initialize(VSPI_HOST, &bus, 2) == ESP_OK && spi_bus_add_device(VSPI_HOST, &device, &_device) == ESP_OK;
+}
+
+// replaces the byte level SPI callback of U8g2: commands and frame data become queued DMA transactions
+uint8_t DisplayDma::byteCallback(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr)
+{
+  DisplayDma *self = _instance;
+
+  switch (msg)
+  {
+  case U8X8_MSG_BYTE_INIT:
+    return self->beginBus();
+  case U8X8_MSG_BYTE_SET_DC:
+    if (arg_int != self->_dataMode)
+    {
+      self->flushCommands();
+      self->_dataMode = arg_int;
+    }
+    return 1;
+  case U8X8_MSG_BYTE_SEND:
+    if (self->_dataMode)
+    {
+      self->send((const uint8_t *)arg_ptr, arg_int);
+      return 1;
+    }
+    for (uint8_t i = 0; i < arg_int; i++)
+    {
+      if (self->_commandLength == sizeof(self->_commands))
+      {
+        self->flushCommands();
+      }
+      self->_commands[self->_commandLength++] = ((const uint8_t *)arg_ptr)[i];
+    }
+    return 1;
+  case U8X8_MSG_BYTE_START_TRANSFER:
+    return 1;
+  case U8X8_MSG_BYTE_END_TRANSFER:
+    self->flushCommands();
+    return 1;
+  }
+  return 0;
+}
+
+void DisplayDma::send(const uint8_t *data, size_t length)
+{
+  const uint8_t *buffer = getBufferPtr();
+  spi_transaction_t *transaction;
+
+  if (_device == NULL)
+  {
+    return;
+  }
+  if (data >= buffer && data + length <= buffer + sizeof(dmaFrame))
+  {
+    // tile data of the framebuffer: sent from the copy in DMA memory, which only
+    // sendBuffer() and updateDisplayArea() update (begin() sends the cleared buffer,
+    // the copy starts zeroed as well)
+    transaction = nextTransaction();
+    transaction->tx_buffer = dmaFrame + (data - buffer);
+    transaction->length = length * 8;
+    transaction->user = (void *)TRANSACTION_DATA;
+    queue(transaction);
+    return;
+  }
+  // anything else (clearDisplay, init) lives on the caller's stack, send it before returning
+  spi_transaction_t polling;
+  memset(&polling, 0, sizeof(polling));
+  polling.tx_buffer = data;
+  polling.length = length * 8;
+  polling.user = (void *)(TRANSACTION_DATA | TRANSACTION_POLLING);
+  wait();
+  spi_device_polling_transmit(_device, &polling);
+}
+
+void DisplayDma::flushCommands()
+{
+  if (_commandLength == 0 || _device == NULL)
+  {
+    _commandLength = 0;
+    return;
+  }
+  spi_transaction_t *transaction = nextTransaction();
+  transaction->flags = SPI_TRANS_USE_TXDATA;
+  memcpy(transaction->tx_data, _commands, _commandLength);
+  transaction->length = _commandLength * 8;
+  transaction->user = (void *)0; // command
+  queue(transaction);
+  _commandLength = 0;
+}
+
+spi_transaction_t *DisplayDma::nextTransaction()
+{
+  // all slots queued: the oldest one has to come back first
+  if (_queued - _collected >= transactionCount)
+  {
+    collect(portMAX_DELAY);
+  }
+  spi_transaction_t *transaction = &_transactions[_queued % transactionCount];
+  memset(transaction, 0, sizeof(*transaction));
+  return transaction;
+}
+
+void DisplayDma::queue(spi_transaction_t *transaction)
+{
+  if (_queued == _done)
+  {
+    _frameStartUs = esp_timer_get_time();
+  }
+  _queued++;
+  if (spi_device_queue_trans(_device, transaction, portMAX_DELAY) != ESP_OK)
+  {
+    // never reaches the bus, count it as done so wait() does not hang
+    _done++;
+    _collected++;
+  }
+}
+
+void DisplayDma::collect(TickType_t ticks)
+{
+  spi_transaction_t *transaction;
+  if (spi_device_get_trans_result(_device, &transaction, ticks) == ESP_OK)
+  {
+    _collected++;
+  }
+}
+
+void IRAM_ATTR DisplayDma::preTransfer(spi_transaction_t *transaction)
+{
+  gpio_set_level((gpio_num_t)_instance->_dc, (intptr_t)transaction->user & TRANSACTION_DATA);
+}
+
+void IRAM_ATTR DisplayDma::postTransfer(spi_transaction_t *transaction)
+{
+  DisplayDma *self = _instance;
+  if ((intptr_t)transaction->user & TRANSACTION_POLLING)
+  {
+    return;
+  }
+  self->_done++;
+  if (self->_done != self->_queued)
+  {
+    return;
+  }
+  // bus idle: the frame is on the display
+  self->_framesSent++;
+  self->_lastFrameUs = esp_timer_get_time() - self->_frameStartUs;
+  if (self->_completionTask)
+  {
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->_completionTask, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken)
+    {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
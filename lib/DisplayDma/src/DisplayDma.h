@@ -0,0 +1,87 @@
+#ifndef DISPLAYDMA_H
+#define DISPLAYDMA_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include <driver/spi_master.h>
+
+// SSD1309 128x64 on the VSPI peripheral with DMA, a drop-in for
+// U8G2_SSD1309_128X64_NONAME2_F_4W_SW_SPI on the same pins.
+//
+// The DMA memory holds a copy of what the panel shows. sendBuffer() compares
+// the framebuffer with it tile by tile (8x8 pixels) and only sends the runs of
+// changed tiles: one SPI transaction for the column/page commands and one for
+// the tile data per run, queued and then left to the DMA. The data/command line
+// is switched by the SPI driver before each transaction. The next sendBuffer()
+// only waits if the previous frame is still on the bus.
+class DisplayDma : public U8G2
+{
+  public:
+    static const uint32_t clockHz = 8000000;
+
+    DisplayDma(const u8g2_cb_t *rotation, uint8_t clock, uint8_t data, uint8_t cs, uint8_t dc, uint8_t reset = U8X8_PIN_NONE);
+
+    // queue the changed tiles and return right away, the framebuffer can be drawn on again immediately
+    void sendBuffer();
+    void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+    void clearDisplay();
+
+    // a frame is still being transferred
+    bool busy() { return _done != _queued; }
+    void wait();
+    // the task gets a notification whenever a frame has been transferred
+    void setCompletionTask(TaskHandle_t task) { _completionTask = task; }
+    uint32_t framesSent() { return _framesSent; }
+    // time the last frame took on the bus
+    uint32_t lastFrameUs() { return _lastFrameUs; }
+    // tile bytes of the last sendBuffer() and in total, saved = unchanged tiles not sent
+    uint16_t lastFrameBytes() { return _lastFrameBytes; }
+    uint32_t bytesSent() { return _bytesSent; }
+    uint32_t bytesSaved() { return _bytesSaved; }
+
+  private:
+    static const uint8_t transactionCount = 24;
+    // unchanged tiles between two changed ones that are sent anyway, cheaper than another pair of transactions
+    static const uint8_t maxTileGap = 1;
+
+    static uint8_t byteCallback(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr);
+    static void IRAM_ATTR preTransfer(spi_transaction_t *transaction);
+    static void IRAM_ATTR postTransfer(spi_transaction_t *transaction);
+
+    bool beginBus();
+    void send(const uint8_t *data, size_t length);
+    void flushCommands();
+    void queue(spi_transaction_t *transaction);
+    spi_transaction_t *nextTransaction();
+    void collect(TickType_t ticks);
+    void copyArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+
+    static DisplayDma *_instance;
+
+    uint8_t _clock;
+    uint8_t _data;
+    uint8_t _cs;
+    uint8_t _dc;
+    spi_device_handle_t _device = NULL;
+
+    // command bytes are collected and sent together as one transaction
+    bool _dataMode = false;
+    uint8_t _commands[4];
+    uint8_t _commandLength = 0;
+
+    spi_transaction_t _transactions[transactionCount];
+    // transactions handed to the driver, finished on the bus and taken back from the driver
+    volatile uint32_t _queued = 0;
+    volatile uint32_t _done = 0;
+    uint32_t _collected = 0;
+    volatile uint32_t _framesSent = 0;
+    volatile uint32_t _lastFrameUs = 0;
+    volatile int64_t _frameStartUs = 0;
+    TaskHandle_t _completionTask = NULL;
+
+    uint16_t _lastFrameBytes = 0;
+    uint32_t _bytesSent = 0;
+    uint32_t _bytesSaved = 0;
+};
+
+#endif // end of DISPLAYDMA_H
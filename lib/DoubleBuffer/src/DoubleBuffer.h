@@ -0,0 +1,88 @@
+#ifndef DOUBLEBUFFER_H
+#define DOUBLEBUFFER_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Lock-free single producer / single consumer hand-over of the newest value.
+// write() may only be called from one task and read() from one other task.
+//
+// The writer alternates between two slots and never waits. Every slot has a
+// version that is odd while it is written; the reader copies the newest slot and
+// tries again if the version changed meanwhile, which only happens when two
+// writes come in while it copies one. Every slot also keeps the number of the
+// write it holds, so a reader that finds a newer value than it expected knows
+// which one it got. Values the reader never saw because a newer one replaced
+// them are counted as skipped.
+template <typename T>
+class DoubleBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "DoubleBuffer copies its values with memcpy");
+
+  public:
+    void write(const T &item)
+    {
+      uint32_t written = _written.load(std::memory_order_relaxed) + 1;
+      Slot &slot = _slots[written & 1];
+      uint32_t version = slot.version.load(std::memory_order_relaxed);
+      slot.version.store(version + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      memcpy(&slot.item, &item, sizeof(T));
+      slot.written.store(written, std::memory_order_relaxed);
+      slot.version.store(version + 2, std::memory_order_release);
+      _written.store(written, std::memory_order_release);
+    }
+
+    // the newest value if the reader did not see it yet
+    bool read(T &item)
+    {
+      for (;;)
+      {
+        uint32_t written = _written.load(std::memory_order_acquire);
+        uint32_t read = _read.load(std::memory_order_relaxed);
+        if (written == read)
+        {
+          return false;
+        }
+        Slot &slot = _slots[written & 1];
+        uint32_t version = slot.version.load(std::memory_order_acquire);
+        if (version & 1)
+        {
+          continue;
+        }
+        memcpy(&item, &slot.item, sizeof(T));
+        // two more writes since _written was loaded leave a newer value in the slot
+        uint32_t copied = slot.written.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version)
+        {
+          continue;
+        }
+        _skipped.fetch_add(copied - read - 1, std::memory_order_relaxed);
+        _read.store(copied, std::memory_order_release);
+        return true;
+      }
+    }
+
+    // a value was written that the reader did not read yet
+    bool pending() const { return _written.load(std::memory_order_acquire) != _read.load(std::memory_order_acquire); }
+    uint32_t written() const { return _written.load(std::memory_order_relaxed); }
+    uint32_t skipped() const { return _skipped.load(std::memory_order_relaxed); }
+
+  private:
+    struct Slot
+    {
+      T item;
+      std::atomic<uint32_t> written{0}; // the write that filled it
+      std::atomic<uint32_t> version{0};
+    };
+
+    Slot _slots[2];
+    std::atomic<uint32_t> _written{0};
+    std::atomic<uint32_t> _read{0};
+    std::atomic<uint32_t> _skipped{0};
+};
+
+#endif // end of DOUBLEBUFFER_H
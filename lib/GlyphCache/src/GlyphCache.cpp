@@ -0,0 +1,126 @@
+#include "GlyphCache.h"
+
+static const char glyphs[] = "0123456789-.";
+
+GlyphCache::GlyphCache(const uint8_t *font, int16_t baseline) : _font(font), _baseline(baseline)
+{
+}
+
+int8_t GlyphCache::glyphIndex(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  return c == '-' ? 10 : c == '.' ? 11 : -1;
+}
+
+void GlyphCache::format(char *text, size_t size, long value, uint8_t decimals)
+{
+  unsigned long scale = 1;
+  unsigned long magnitude = value < 0 ? -(unsigned long)value : value;
+
+  if (decimals == 0)
+  {
+    snprintf(text, size, "%ld", value);
+    return;
+  }
+  for (uint8_t i = 0; i < decimals; i++)
+  {
+    scale *= 10;
+  }
+  snprintf(text, size, "%s%lu.%0*lu", value < 0 ? "-" : "", magnitude / scale, decimals, magnitude % scale);
+}
+
+bool GlyphCache::begin(U8G2 &display)
+{
+  uint8_t *buffer = display.getBufferPtr();
+  uint16_t width = display.getBufferTileWidth() * 8;
+  uint8_t pages = display.getBufferTileHeight();
+  bool found = false;
+
+  if (pages > maxPages)
+  {
+    return false;
+  }
+  display.setFontDirection(0);
+  display.setFont(_font);
+  for (uint8_t i = 0; i < glyphCount; i++)
+  {
+    int16_t first = -1;
+    int16_t last = -1;
+
+    display.clearBuffer();
+    _advance[i] = display.drawGlyph(margin, _baseline, glyphs[i]);
+    for (uint8_t page = 0; page < pages; page++)
+    {
+      for (uint16_t column = 0; column < width; column++)
+      {
+        if (buffer[page * width + column])
+        {
+          first = first < 0 || column < first ? column : first;
+          last = column > last ? column : last;
+          _firstPage = !found || page < _firstPage ? page : _firstPage;
+          _lastPage = !found || page > _lastPage ? page : _lastPage;
+          found = true;
+        }
+      }
+    }
+    // pixels on an edge of the display may have been clipped
+    if (first == 0 || last == width - 1 || last - first + 1 > maxWidth)
+    {
+      display.clearBuffer();
+      return false;
+    }
+    _offset[i] = first < 0 ? 0 : first - margin;
+    _width[i] = first < 0 ? 0 : last - first + 1;
+    for (uint8_t page = 0; page < pages; page++)
+    {
+      memcpy(_tiles[i][page], buffer + page * width + margin + _offset[i], _width[i]);
+    }
+  }
+  display.clearBuffer();
+  _ready = found;
+  return _ready;
+}
+
+int16_t GlyphCache::print(U8G2 &display, int16_t x, long value, uint8_t decimals)
+{
+  char text[24];
+
+  format(text, sizeof(text), value, decimals);
+  if (!_ready)
+  {
+    // glyphs the cache can't hold: let U8g2 draw them
+    display.setFont(_font);
+    display.setCursor(x, _baseline);
+    display.print(text);
+    return (int16_t)display.getCursorX();
+  }
+
+  uint8_t *buffer = display.getBufferPtr();
+  int16_t width = display.getBufferTileWidth() * 8;
+  for (const char *c = text; *c; c++)
+  {
+    int8_t i = glyphIndex(*c);
+    if (i < 0)
+    {
+      continue;
+    }
+    // clip at both display edges
+    int16_t left = x + _offset[i];
+    int16_t first = left < 0 ? -left : 0;
+    int16_t last = left + _width[i] > width ? width - left : _width[i];
+    for (uint8_t page = _firstPage; page <= _lastPage; page++)
+    {
+      uint8_t *row = buffer + page * width + left;
+      const uint8_t *tiles = _tiles[i][page];
+      for (int16_t column = first; column < last; column++)
+      {
+        row[column] |= tiles[column];
+      }
+    }
+    x += _advance[i];
+  }
+  return x;
+}
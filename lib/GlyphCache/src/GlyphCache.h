@@ -0,0 +1,55 @@
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+// Digits of one large font with the minus sign and the decimal point, decoded once
+// into the display's tile format.
+//
+// U8g2 decodes the run length compressed glyph data pixel by pixel on every
+// frame. The cache draws each glyph once through U8g2 at the baseline it is
+// always used with and keeps the resulting framebuffer bytes (8 vertical pixels
+// per byte, one row per 8 pixel page). print() then only ORs these bytes into the
+// framebuffer, which gives exactly the pixels of setFont() + setCursor() + print().
+// A glyph keeps the columns it really covers, which may start left of the cursor
+// or reach past its advance (oblique fonts).
+class GlyphCache
+{
+  public:
+    static const uint8_t glyphCount = 12; // 0-9, the minus sign and the decimal point
+    static const uint8_t maxWidth = 40;
+    static const uint8_t maxPages = 8;
+    // room left of the cursor while a glyph is rendered
+    static const uint8_t margin = 16;
+
+    GlyphCache(const uint8_t *font, int16_t baseline);
+
+    // renders the glyphs through U8g2 and clears the framebuffer afterwards, once at
+    // startup. Fails for glyphs wider than maxWidth or not fully on the display at
+    // the margin.
+    bool begin(U8G2 &display);
+    bool ready() { return _ready; }
+
+    // draws value with its left edge at x and returns the x after the last glyph, with the
+    // last decimals digits after a decimal point. Without a successful begin() U8g2 draws it.
+    int16_t print(U8G2 &display, int16_t x, long value, uint8_t decimals = 0);
+
+  private:
+    static int8_t glyphIndex(char c);
+    static void format(char *text, size_t size, long value, uint8_t decimals);
+
+    const uint8_t *_font;
+    int16_t _baseline;
+    bool _ready = false;
+    // pages that hold pixels of any glyph
+    uint8_t _firstPage = 0;
+    uint8_t _lastPage = 0;
+    uint8_t _advance[glyphCount];
+    // first column with pixels relative to the cursor, and the number of columns
+    int8_t _offset[glyphCount];
+    uint8_t _width[glyphCount];
+    uint8_t _tiles[glyphCount][maxPages][maxWidth];
+};
+
+#endif // end of GLYPHCACHE_H
@@ -0,0 +1,264 @@
+#include "JobScheduler.h"
+#include <esp_sleep.h>
+#include <esp_timer.h>
+
+JobScheduler::JobScheduler()
+{
+  memset(_slots, none, sizeof(_slots));
+}
+
+int JobScheduler::add(const char *name, uint32_t periodMs, Callback callback)
+{
+  if (_count == maxJobs)
+  {
+    return none;
+  }
+  int job = _count++;
+  memset(&_jobs[job], 0, sizeof(Job));
+  _jobs[job].name = name;
+  _jobs[job].callback = callback;
+  _jobs[job].enabled = true;
+  _jobs[job].next = none;
+  setPeriod(job, periodMs);
+  return job;
+}
+
+void JobScheduler::setPeriod(int job, uint32_t periodMs)
+{
+  unlink(job);
+  _jobs[job].periodUs = periodMs * 1000;
+  _jobs[job].dueUs = esp_timer_get_time() + _jobs[job].periodUs;
+  if (_jobs[job].periodUs)
+  {
+    link(job);
+  }
+}
+
+void JobScheduler::enable(int job, bool enabled)
+{
+  if (_jobs[job].enabled == enabled)
+  {
+    return;
+  }
+  _jobs[job].enabled = enabled;
+  if (enabled && _jobs[job].periodUs)
+  {
+    _jobs[job].dueUs = esp_timer_get_time() + _jobs[job].periodUs;
+    link(job);
+  }
+  else if (!enabled)
+  {
+    unlink(job);
+  }
+}
+
+void JobScheduler::trigger(int job)
+{
+  unlink(job);
+  _jobs[job].dueUs = esp_timer_get_time();
+  link(job);
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void JobScheduler::link(int job)
+{
+  Job &entry = _jobs[job];
+  if (entry.linked || !entry.enabled)
+  {
+    return;
+  }
+  // a deadline behind the wheel goes into the current slot, the next runDue() finds it there
+  int64_t tick = entry.dueUs / tickUs;
+  entry.slot = (tick > _cursorTick ? tick : _cursorTick) % slots;
+  entry.next = _slots[entry.slot];
+  _slots[entry.slot] = job;
+  entry.linked = true;
+}
+
+void JobScheduler::unlink(int job)
+{
+  Job &entry = _jobs[job];
+  if (!entry.linked)
+  {
+    return;
+  }
+  int8_t *link = &_slots[entry.slot];
+  while (*link != job)
+  {
+    link = &_jobs[*link].next;
+  }
+  *link = entry.next;
+  entry.next = none;
+  entry.linked = false;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void JobScheduler::runDue()
+{
+  int64_t nowUs = esp_timer_get_time();
+  int64_t nowTick = nowUs / tickUs;
+  int8_t due[maxJobs];
+  uint8_t dueCount = 0;
+
+  // every slot the wheel passed since the last call, all of them after a long job
+  int64_t lastTick = nowTick - _cursorTick >= slots ? _cursorTick + slots - 1 : nowTick;
+  for (int64_t tick = _cursorTick; tick <= lastTick; tick++)
+  {
+    for (int8_t job = _slots[tick % slots]; job != none; job = _jobs[job].next)
+    {
+      if (_jobs[job].dueUs > nowUs)
+      {
+        continue;
+      }
+      // insertion sort by deadline, there are only a few jobs
+      uint8_t i = dueCount++;
+      while (i > 0 && _jobs[due[i - 1]].dueUs > _jobs[job].dueUs)
+      {
+        due[i] = due[i - 1];
+        i--;
+      }
+      due[i] = job;
+    }
+  }
+  _cursorTick = nowTick;
+
+  for (uint8_t i = 0; i < dueCount; i++)
+  {
+    // an earlier job of this round may have moved or disabled it
+    if (_jobs[due[i]].linked && _jobs[due[i]].dueUs <= nowUs)
+    {
+      run(due[i]);
+    }
+  }
+}
+
+void JobScheduler::run(int job)
+{
+  Job &entry = _jobs[job];
+  int64_t startUs = esp_timer_get_time();
+  uint32_t lateness = startUs - entry.dueUs;
+
+  unlink(job);
+  entry.callback();
+  int64_t endUs = esp_timer_get_time();
+
+  uint32_t runtime = endUs - startUs;
+  entry.stats.runs++;
+  entry.stats.runtimeTotalUs += runtime;
+  entry.stats.runtimeMaxUs = runtime > entry.stats.runtimeMaxUs ? runtime : entry.stats.runtimeMaxUs;
+  entry.stats.latenessTotalUs += lateness;
+  entry.stats.latenessMaxUs = lateness > entry.stats.latenessMaxUs ? lateness : entry.stats.latenessMaxUs;
+
+  // the callback may have set a new period itself, otherwise keep the cadence and skip missed periods
+  if (!entry.linked && entry.enabled && entry.periodUs)
+  {
+    do
+    {
+      entry.dueUs += entry.periodUs;
+    } while (entry.dueUs <= endUs);
+    link(job);
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+int64_t JobScheduler::nextDueUs()
+{
+  // first occupied slot from the cursor on, with a deadline in this turn of the wheel
+  for (int64_t tick = _cursorTick; tick < _cursorTick + slots; tick++)
+  {
+    int64_t next = INT64_MAX;
+    for (int8_t job = _slots[tick % slots]; job != none; job = _jobs[job].next)
+    {
+      if (_jobs[job].dueUs / tickUs <= tick && _jobs[job].dueUs < next)
+      {
+        next = _jobs[job].dueUs;
+      }
+    }
+    if (next != INT64_MAX)
+    {
+      return next;
+    }
+  }
+
+  // nothing due within one turn, only long periods left
+  int64_t next = INT64_MAX;
+  for (uint8_t job = 0; job < _count; job++)
+  {
+    if (_jobs[job].linked && _jobs[job].dueUs < next)
+    {
+      next = _jobs[job].dueUs;
+    }
+  }
+  return next;
+}
+
+void JobScheduler::idle()
+{
+  int64_t nowUs = esp_timer_get_time();
+  int64_t untilUs = nextDueUs();
+  // work that came in while the jobs ran, before it could wait for the end of a light sleep
+  if (untilUs <= nowUs || takeNotification(0))
+  {
+    return;
+  }
+
+  if (!_timerWakeup && untilUs - nowUs >= minLightSleepUs && lightSleep(nowUs, untilUs))
+  {
+    return;
+  }
+  _timerWakeup = false;
+
+  // rounded up, a notification ends the wait early
+  uint32_t tickPeriodUs = portTICK_PERIOD_MS * 1000;
+  TickType_t ticks = untilUs == INT64_MAX ? portMAX_DELAY : (untilUs - nowUs + tickPeriodUs - 1) / tickPeriodUs;
+  takeNotification(ticks);
+  _idleUs += esp_timer_get_time() - nowUs;
+}
+
+bool JobScheduler::takeNotification(TickType_t ticks)
+{
+  uint32_t bits = 0;
+  if (xTaskNotifyWait(0, UINT32_MAX, &bits, ticks) != pdTRUE)
+  {
+    return false;
+  }
+  for (uint8_t job = 0; job < _count; job++)
+  {
+    if (_jobs[job].notifyBits & bits)
+    {
+      trigger(job);
+    }
+  }
+  return true;
+}
+
+bool JobScheduler::lightSleep(int64_t nowUs, int64_t untilUs)
+{
+  // the timer wakeup also ends the sleep for esp_timer alarms, the tasks waiting on them stay on time
+  int64_t alarmUs = esp_timer_get_next_alarm();
+  bool forAlarm = alarmUs < untilUs;
+  untilUs = forAlarm ? alarmUs : untilUs;
+  if (untilUs - nowUs < minLightSleepUs || !_prepareSleep || !_prepareSleep())
+  {
+    return false;
+  }
+
+  esp_sleep_enable_timer_wakeup(untilUs - nowUs);
+  esp_light_sleep_start();
+  // the timer is a wakeup source of deep sleep too
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+  if (_resumeSleep)
+  {
+    _resumeSleep();
+  }
+
+  uint64_t sleptUs = esp_timer_get_time() - nowUs;
+  _lightSleeps++;
+  _lightSleepUs += sleptUs;
+  _idleUs += sleptUs;
+  _timerWakeup = forAlarm;
+  return true;
+}
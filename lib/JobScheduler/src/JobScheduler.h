@@ -0,0 +1,113 @@
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include <Arduino.h>
+
+// Cooperative scheduler for the Arduino loop: periodic jobs with deadlines on a
+// hashed timer wheel, and the loop task idles in between instead of polling.
+//
+// The wheel has one slot per tick, a job sits in the slot of its deadline and is
+// only looked at when the wheel passes that slot. Deadlines more than one turn
+// ahead share the slot with nearer ones and are skipped until their turn comes.
+//
+// idle() blocks the loop task until the next deadline or a task notification,
+// a notification (eSetBits) runs every job set up for one of its bits with
+// notifyOn(). If the light sleep
+// check allows it and the gap is long enough, the chip sleeps instead: woken by
+// the timer at the next deadline or the next esp_timer alarm, whichever comes
+// first, or by the GPIO wakeup sources the caller enabled.
+//
+// Per job the runs, the time the callback took and how late it started after its
+// deadline are counted.
+class JobScheduler
+{
+  public:
+    typedef void (*Callback)();
+
+    static const uint8_t maxJobs = 8;
+    static const uint8_t slots = 64;
+    static const uint32_t tickUs = 4000;
+    // below this the chip does not go to light sleep, entry and wakeup would cost more than it saves
+    static const uint32_t minLightSleepUs = 5000;
+
+    struct Stats
+    {
+      uint32_t runs;
+      uint32_t runtimeMaxUs;
+      uint64_t runtimeTotalUs;
+      uint32_t latenessMaxUs;
+      uint64_t latenessTotalUs;
+    };
+
+    JobScheduler();
+
+    // returns the job id, -1 if all jobs are taken; the first run is one period from now,
+    // a job with period 0 only runs when triggered
+    int add(const char *name, uint32_t periodMs, Callback callback);
+    // the next run is one period from now
+    void setPeriod(int job, uint32_t periodMs);
+    void enable(int job, bool enabled);
+    // runs the job with the next runDue() without moving its period
+    void trigger(int job);
+    // a notification with any of these bits triggers the job, 0 for none
+    void notifyOn(int job, uint32_t bits) { _jobs[job].notifyBits = bits; }
+    // prepare returns true if the chip may sleep now, resume undoes what prepare did
+    void setLightSleepCheck(bool (*prepare)(), void (*resume)())
+    {
+      _prepareSleep = prepare;
+      _resumeSleep = resume;
+    }
+
+    // runs every job whose deadline passed, in the order of their deadlines
+    void runDue();
+    // waits until the next deadline
+    void idle();
+
+    // esp_timer time of the next deadline, INT64_MAX without enabled jobs
+    int64_t nextDueUs();
+
+    uint8_t jobs() const { return _count; }
+    const char *name(int job) const { return _jobs[job].name; }
+    uint32_t periodMs(int job) const { return _jobs[job].periodUs / 1000; }
+    const Stats &stats(int job) const { return _jobs[job].stats; }
+    uint64_t idleUs() const { return _idleUs; }
+    uint64_t lightSleepUs() const { return _lightSleepUs; }
+    uint32_t lightSleeps() const { return _lightSleeps; }
+
+  private:
+    static const int8_t none = -1;
+
+    struct Job
+    {
+      const char *name;
+      Callback callback;
+      uint32_t periodUs;
+      int64_t dueUs;
+      bool enabled;
+      bool linked;
+      uint8_t slot;
+      int8_t next; // in the same slot
+      uint32_t notifyBits;
+      Stats stats;
+    };
+
+    void link(int job);
+    void unlink(int job);
+    void run(int job);
+    bool lightSleep(int64_t nowUs, int64_t untilUs);
+    bool takeNotification(TickType_t ticks);
+
+    Job _jobs[maxJobs];
+    int8_t _slots[slots];
+    uint8_t _count = 0;
+    int64_t _cursorTick = 0;
+    bool (*_prepareSleep)() = NULL;
+    void (*_resumeSleep)() = NULL;
+    uint64_t _idleUs = 0;
+    uint64_t _lightSleepUs = 0;
+    uint32_t _lightSleeps = 0;
+    // the last light sleep ended for an esp_timer alarm, its callback is about to wake a task
+    bool _timerWakeup = false;
+};
+
+#endif // end of JOBSCHEDULER_H
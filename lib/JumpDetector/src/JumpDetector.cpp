@@ -0,0 +1,96 @@
+#include "JumpDetector.h"
+#include <math.h>
+
+// from, to, event, speed m/s, acceleration m/s^2, altitude m, hold ms
+const JumpDetector::Rule JumpDetector::defaultRules[] = {
+    {AIRCRAFT, FREEFALL, EXIT, -INFINITY, -11, -INFINITY, -6, INFINITY, 0},           // falling at close to 1 g, faster than any plane descends
+    {AIRCRAFT, FREEFALL, EXIT, -INFINITY, -15, -INFINITY, INFINITY, INFINITY, 0},     // a slow exit the acceleration missed
+    {AIRCRAFT, LANDED, LANDING, -1, 1, -INFINITY, INFINITY, 30, 3000},                // the plane landed with the jumper on board
+    {FREEFALL, CANOPY, DEPLOYMENT, -INFINITY, INFINITY, 12, INFINITY, INFINITY, 300}, // the opening brakes at several g
+    {FREEFALL, CANOPY, DEPLOYMENT, -15, INFINITY, -2, INFINITY, INFINITY, 0},         // canopy speed, and no longer speeding up like right after the exit
+    {CANOPY, LANDED, LANDING, -1, 1, -INFINITY, INFINITY, 4, 300},                    // stopped on the ground of the reference
+    {CANOPY, LANDED, LANDING, -0.7, 0.7, -INFINITY, INFINITY, 300, 3000},             // stopped higher, on another field or after the weather moved
+};
+const uint8_t JumpDetector::defaultRuleCount = sizeof(defaultRules) / sizeof(defaultRules[0]);
+
+JumpDetector::JumpDetector(const Rule *rules, uint8_t count) : _rules(rules), _count(count < maxRules ? count : maxRules)
+{
+  reset();
+}
+
+void JumpDetector::reset(Phase phase)
+{
+  _phase = phase;
+  for (uint8_t i = 0; i < maxRules; i++)
+  {
+    _pending[i] = Pending();
+  }
+  for (uint8_t i = 0; i < EVENT_TYPES; i++)
+  {
+    _events[i] = Event();
+  }
+}
+
+bool JumpDetector::holds(const Rule &rule, bool pending, float altitude, float verticalSpeed, float acceleration) const
+{
+  // INFINITY stays INFINITY with the hysteresis added
+  float speedMargin = pending ? speedHysteresis : 0;
+  float accelerationMargin = pending ? accelerationHysteresis : 0;
+  float altitudeMargin = pending ? altitudeHysteresis : 0;
+  return verticalSpeed >= rule.minSpeed - speedMargin && verticalSpeed <= rule.maxSpeed + speedMargin &&
+         acceleration >= rule.minAcceleration - accelerationMargin && acceleration <= rule.maxAcceleration + accelerationMargin &&
+         altitude <= rule.maxAltitude + altitudeMargin;
+}
+
+JumpDetector::EventType JumpDetector::update(float altitude, float verticalSpeed, float acceleration, uint32_t timeUs)
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    const Rule &rule = _rules[i];
+    Pending &pending = _pending[i];
+    if (rule.from != _phase)
+    {
+      continue;
+    }
+    if (!holds(rule, pending.active, altitude, verticalSpeed, acceleration))
+    {
+      pending.active = false;
+      continue;
+    }
+    if (!pending.active)
+    {
+      pending.active = true;
+      pending.sinceUs = timeUs;
+      pending.altitude = altitude;
+    }
+    if (timeUs - pending.sinceUs < (uint32_t)rule.holdMs * 1000)
+    {
+      continue;
+    }
+
+    // the onset of a rule that was pending longer is the better estimate, e.g. the acceleration
+    // rule of an exit that the speed rule confirmed
+    Event &event = _events[rule.event];
+    event.type = rule.event;
+    event.onsetUs = pending.sinceUs;
+    event.altitude = pending.altitude;
+    for (uint8_t j = 0; j < _count; j++)
+    {
+      if (_pending[j].active && _rules[j].from == _phase && _rules[j].event == rule.event &&
+          (int32_t)(_pending[j].sinceUs - event.onsetUs) < 0)
+      {
+        event.onsetUs = _pending[j].sinceUs;
+        event.altitude = _pending[j].altitude;
+      }
+    }
+    event.detectedUs = timeUs;
+
+    _phase = rule.to;
+    for (uint8_t j = 0; j < maxRules; j++)
+    {
+      _pending[j] = Pending();
+    }
+    return rule.event;
+  }
+  return NONE;
+}
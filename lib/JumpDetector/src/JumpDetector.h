@@ -0,0 +1,96 @@
+#ifndef JUMPDETECTOR_H
+#define JUMPDETECTOR_H
+
+#include <stdint.h>
+
+// Exit, deployment and landing from the filtered altitude, vertical speed and acceleration.
+//
+// The phases only follow each other along a table of rules, so the events of a jump come in
+// order and a deployment can't be found before an exit. A rule fires once all its ranges held
+// for holdMs. While it is pending the ranges widen by the hysteresis, so a value that wobbles
+// around a limit neither restarts the hold time nor leaves the rule pending at every other
+// sample. Several rules may lead out of a phase, the first to fire wins.
+//
+// Every event keeps the time and altitude at the onset of its rule, which is closer to the
+// real exit or deployment than the sample that confirmed it, and the time it was detected.
+class JumpDetector
+{
+  public:
+    static const uint8_t maxRules = 8;
+    static constexpr float speedHysteresis = 0.5f;        // m/s
+    static constexpr float accelerationHysteresis = 1.0f; // m/s^2
+    static constexpr float altitudeHysteresis = 1.0f;     // m
+
+    enum Phase : uint8_t
+    {
+      AIRCRAFT, // from the climb until the exit, or until the plane landed with the jumper
+      FREEFALL,
+      CANOPY,
+      LANDED,
+    };
+
+    enum EventType : uint8_t
+    {
+      NONE,
+      EXIT,
+      DEPLOYMENT,
+      LANDING,
+      EVENT_TYPES,
+    };
+
+    struct Rule
+    {
+      Phase from;
+      Phase to;
+      EventType event;
+      // all of them hold, -INFINITY and INFINITY for no limit
+      float minSpeed; // m/s, positive when climbing
+      float maxSpeed;
+      float minAcceleration; // m/s^2
+      float maxAcceleration;
+      float maxAltitude; // m above the ground reference
+      uint16_t holdMs;
+    };
+
+    struct Event
+    {
+      EventType type;
+      uint32_t onsetUs; // first sample of the rule that fired
+      uint32_t detectedUs;
+      float altitude; // at the onset
+    };
+
+    // the skydiving rules
+    static const Rule defaultRules[];
+    static const uint8_t defaultRuleCount;
+
+    JumpDetector(const Rule *rules = defaultRules, uint8_t count = defaultRuleCount);
+
+    // forget the pending rules and the events, e.g. when the climb starts
+    void reset(Phase phase = AIRCRAFT);
+    // one filtered sample, returns the event it completed or NONE
+    EventType update(float altitude, float verticalSpeed, float acceleration, uint32_t timeUs);
+
+    Phase phase() const { return _phase; }
+    // the last event of that type since reset(), type NONE if there was none
+    const Event &event(EventType type) const { return _events[type]; }
+    bool happened(EventType type) const { return _events[type].type != NONE; }
+
+  private:
+    bool holds(const Rule &rule, bool pending, float altitude, float verticalSpeed, float acceleration) const;
+
+    struct Pending
+    {
+      bool active;
+      uint32_t sinceUs;
+      float altitude;
+    };
+
+    const Rule *_rules;
+    uint8_t _count;
+    Phase _phase = AIRCRAFT;
+    Pending _pending[maxRules] = {};
+    Event _events[EVENT_TYPES] = {};
+};
+
+#endif // end of JUMPDETECTOR_H
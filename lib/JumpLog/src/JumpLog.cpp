@@ -1,16 +1,245 @@
 #include "Arduino.h"
 #include "JumpLog.h"
 
+#define JUMPLOG_MAGIC 0x4A4C4F47 // "JLOG"
+
+static_assert(sizeof(JumpRecord) == 32, "JumpRecord must stay 32 bytes, the flash layout depends on it");
+
 JumpLog::JumpLog()
 {
 }
 
-void JumpLog::start()
+bool JumpLog::begin(const char *label)
+{
+  SectorHeader header;
+  bool found = false;
+
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if (_partition == NULL)
+  {
+    return false;
+  }
+  _sectors = _partition->size / sectorSize;
+
+  // newest sector = valid header with the highest sequence number
+  for (uint32_t sector = 0; sector < _sectors; sector++)
+  {
+    if (readHeader(sector, header) && (!found || header.sequence > _sequence))
+    {
+      found = true;
+      _sector = sector;
+      _sequence = header.sequence;
+      _sectorFirstJump = header.firstJumpNumber;
+    }
+  }
+  if (!found)
+  {
+    // empty or never formatted logbook
+    _lastJumpNumber = 0;
+    return startSector(0, 1);
+  }
+
+  // records are written in order, so the used slots are a prefix of the sector
+  uint32_t low = 0;
+  uint32_t high = recordsPerSector;
+  while (low < high)
+  {
+    uint32_t mid = (low + high) / 2;
+    if (slotErased(_sector, mid))
+    {
+      high = mid;
+    }
+    else
+    {
+      low = mid + 1;
+    }
+  }
+  _nextSlot = low;
+  // a slot torn by a power loss still counts, its jump number is used up
+  _lastJumpNumber = _sectorFirstJump + _nextSlot - 1;
+  return true;
+}
+
+void JumpLog::start(uint32_t date, int exitAltitude)
+{
+  memset(&_current, 0, sizeof(_current));
+  _current.date = date;
+  _current.exitAltitude = exitAltitude;
+  _exitMillis = millis();
+  _deploymentMillis = 0;
+  _active = true;
+}
+
+void JumpLog::canopy(int deploymentAltitude)
 {
+  if (!_active)
+  {
+    return;
+  }
+  _current.deploymentAltitude = deploymentAltitude;
+  _deploymentMillis = millis();
+  _current.freefallTime = (_deploymentMillis - _exitMillis) / 1000;
 }
-void JumpLog::canopy()
+
+void JumpLog::verticalSpeed(int speed)
+{
+  if (_active && speed < _current.maxVerticalSpeed)
+  {
+    _current.maxVerticalSpeed = speed;
+  }
+}
+
+void JumpLog::sensorFault(uint8_t sensor)
 {
+  if (_active && sensor < sizeof(_current.sensorFaults) && _current.sensorFaults[sensor] < UINT8_MAX)
+  {
+    _current.sensorFaults[sensor]++;
+  }
 }
+
 void JumpLog::stop()
 {
-}
\ No newline at end of file
+  if (!_active)
+  {
+    return;
+  }
+  if (_deploymentMillis)
+  {
+    _current.canopyTime = (millis() - _deploymentMillis) / 1000;
+  }
+  _active = false;
+  append(_current);
+}
+
+bool JumpLog::append(JumpRecord &record)
+{
+  if (_partition == NULL)
+  {
+    return false;
+  }
+  if (_nextSlot >= recordsPerSector)
+  {
+    // the oldest sector follows the newest one in the ring
+    if (!startSector((_sector + 1) % _sectors, _lastJumpNumber + 1))
+    {
+      return false;
+    }
+  }
+  record.jumpNumber = _lastJumpNumber + 1;
+  record.crc = crc32(&record, offsetof(JumpRecord, crc));
+  esp_err_t result = esp_partition_write(_partition, slotAddress(_sector, _nextSlot), &record, sizeof(record));
+  // even a failed write may have programmed some bits, the slot is never used again
+  _nextSlot++;
+  _lastJumpNumber++;
+  return result == ESP_OK;
+}
+
+uint32_t JumpLog::firstJumpNumber()
+{
+  SectorHeader header;
+  // the sector after the newest one is the oldest, unless the ring has not wrapped yet
+  for (uint32_t i = 1; i <= _sectors; i++)
+  {
+    if (readHeader((_sector + i) % _sectors, header))
+    {
+      return header.firstJumpNumber;
+    }
+  }
+  return 1;
+}
+
+bool JumpLog::read(uint32_t jumpNumber, JumpRecord &record)
+{
+  if (_partition == NULL || jumpNumber == 0 || jumpNumber > _lastJumpNumber)
+  {
+    return false;
+  }
+  // sectors hold consecutive jumps, walk back from the newest one
+  uint32_t sector = _sector;
+  uint32_t firstJump = _sectorFirstJump;
+  SectorHeader header;
+  for (uint32_t i = 0; jumpNumber < firstJump; i++)
+  {
+    if (i + 1 >= _sectors)
+    {
+      return false;
+    }
+    sector = (sector + _sectors - 1) % _sectors;
+    if (!readHeader(sector, header))
+    {
+      return false;
+    }
+    firstJump = header.firstJumpNumber;
+  }
+  if (esp_partition_read(_partition, slotAddress(sector, jumpNumber - firstJump), &record, sizeof(record)) != ESP_OK)
+  {
+    return false;
+  }
+  return record.jumpNumber == jumpNumber && record.crc == crc32(&record, offsetof(JumpRecord, crc));
+}
+
+bool JumpLog::readHeader(uint32_t sector, SectorHeader &header)
+{
+  if (esp_partition_read(_partition, sector * sectorSize, &header, sizeof(header)) != ESP_OK)
+  {
+    return false;
+  }
+  return header.magic == JUMPLOG_MAGIC && header.crc == crc32(&header, offsetof(SectorHeader, crc));
+}
+
+bool JumpLog::slotErased(uint32_t sector, uint32_t slot)
+{
+  uint32_t words[sizeof(JumpRecord) / 4];
+  if (esp_partition_read(_partition, slotAddress(sector, slot), words, sizeof(words)) != ESP_OK)
+  {
+    return false;
+  }
+  for (uint32_t word : words)
+  {
+    if (word != 0xFFFFFFFF)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool JumpLog::startSector(uint32_t sector, uint32_t firstJumpNumber)
+{
+  SectorHeader header;
+
+  if (esp_partition_erase_range(_partition, sector * sectorSize, sectorSize) != ESP_OK)
+  {
+    return false;
+  }
+  memset(&header, 0xFF, sizeof(header));
+  header.magic = JUMPLOG_MAGIC;
+  header.sequence = _sequence + 1;
+  header.firstJumpNumber = firstJumpNumber;
+  header.crc = crc32(&header, offsetof(SectorHeader, crc));
+  if (esp_partition_write(_partition, sector * sectorSize, &header, sizeof(header)) != ESP_OK)
+  {
+    return false;
+  }
+  _sector = sector;
+  _sequence = header.sequence;
+  _sectorFirstJump = firstJumpNumber;
+  _nextSlot = 0;
+  return true;
+}
+
+// CRC-32 (IEEE 802.3), bitwise because it only runs when a jump is saved or read
+uint32_t JumpLog::crc32(const void *data, size_t length)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--)
+  {
+    crc ^= *bytes++;
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
@@ -2,16 +2,90 @@
 #define JUMPLOG_H
 
 #include <Arduino.h>
+#include <esp_partition.h>
 
+// one logbook entry, fixed size so the position of a jump never has to be searched
+struct JumpRecord
+{
+  uint32_t jumpNumber;
+  uint32_t date;              // seconds since 2000-01-01 at exit
+  int16_t exitAltitude;       // m
+  int16_t deploymentAltitude; // m
+  uint16_t freefallTime;      // s
+  uint16_t canopyTime;        // s
+  int16_t maxVerticalSpeed;   // m/s, negative in freefall
+  uint8_t plane;
+  uint8_t dropzone;
+  uint8_t sensorFaults[2]; // faults per pressure sensor during the jump, see SensorFusion
+  uint8_t reserved[6];
+  uint32_t crc;
+};
+
+// Append-only logbook in the "jumplog" flash partition.
+//
+// The partition is a ring of 4 KB sectors. Every sector starts with a header
+// holding a sequence number and the number of its first jump, followed by
+// fixed size CRC protected records. A jump is always written to the next free
+// slot of the newest sector, when that one is full the oldest sector is erased
+// and becomes the newest, so every sector is erased equally often.
+// begin() only reads the sector headers and bisects the newest sector for its
+// first free slot, it never scans the whole log.
 class JumpLog
 {
   public:
+    static const uint32_t sectorSize = 4096;
+    static const uint32_t recordsPerSector = sectorSize / sizeof(JumpRecord) - 1;
+
     JumpLog();
-    void start();
-    void canopy();
+    bool begin(const char *label = "jumplog");
+
+    // exit, deployment and landing of the current jump, stop() writes the record
+    void start(uint32_t date, int exitAltitude);
+    void canopy(int deploymentAltitude);
     void stop();
+    // keeps the fastest descent of the current jump
+    void verticalSpeed(int speed);
+    // counts a fault of one of the pressure sensors during the current jump
+    void sensorFault(uint8_t sensor);
+
+    bool active() { return _active; }
+    uint32_t lastJumpNumber() { return _lastJumpNumber; }
+    // oldest jump still in the ring
+    uint32_t firstJumpNumber();
+    bool read(uint32_t jumpNumber, JumpRecord &record);
+    bool append(JumpRecord &record);
+
+    // CRC-32 (IEEE 802.3) of the flash structures
+    static uint32_t crc32(const void *data, size_t length);
+
   private:
-    
+    struct SectorHeader
+    {
+      uint32_t magic;
+      uint32_t sequence;
+      uint32_t firstJumpNumber;
+      uint8_t reserved[sizeof(JumpRecord) - 16];
+      uint32_t crc;
+    };
+
+    bool readHeader(uint32_t sector, SectorHeader &header);
+    bool slotErased(uint32_t sector, uint32_t slot);
+    bool startSector(uint32_t sector, uint32_t firstJumpNumber);
+    uint32_t slotAddress(uint32_t sector, uint32_t slot) { return sector * sectorSize + (slot + 1) * sizeof(JumpRecord); }
+
+    const esp_partition_t *_partition = NULL;
+    uint32_t _sectors = 0;
+    // newest sector, its sequence number and first jump
+    uint32_t _sector = 0;
+    uint32_t _sequence = 0;
+    uint32_t _sectorFirstJump = 1;
+    uint32_t _nextSlot = 0;
+    uint32_t _lastJumpNumber = 0;
+
+    bool _active = false;
+    JumpRecord _current;
+    unsigned long _exitMillis = 0;
+    unsigned long _deploymentMillis = 0;
 };
 
-#endif // end of JUMPLOG_H
\ No newline at end of file
+#endif // end of JUMPLOG_H
@@ -0,0 +1,104 @@
+#include "Arduino.h"
+#include "JumpLog.h"
+#include "JumpTrack.h"
+
+#define JUMPTRACK_MAGIC 0x4A54524B // "JTRK"
+
+JumpTrack::JumpTrack() : _encoder(_buffer, sizeof(_buffer))
+{
+  static_assert(sizeof(SlotHeader) == slotSize - bufferSize, "slot header and buffer must fill the slot");
+}
+
+bool JumpTrack::begin(const char *label)
+{
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if (_partition == NULL)
+  {
+    return false;
+  }
+  _slots = _partition->size / slotSize;
+  return _slots > 0;
+}
+
+void JumpTrack::start()
+{
+  _encoder.reset();
+  _elapsedUs = 0;
+  _recording = true;
+}
+
+void JumpTrack::add(uint32_t timeUs, float altitude, float verticalSpeed)
+{
+  TrackSample sample;
+
+  if (!_recording)
+  {
+    return;
+  }
+  // the microsecond timestamps wrap after 71 minutes, only their differences count
+  if (_encoder.samples())
+  {
+    _elapsedUs += (uint32_t)(timeUs - _lastTimeUs);
+  }
+  _lastTimeUs = timeUs;
+
+  sample.timeMs = _elapsedUs / 1000;
+  sample.altitude = lroundf(altitude * 10);
+  sample.verticalSpeed = lroundf(verticalSpeed * 10);
+  _encoder.add(sample);
+}
+
+bool JumpTrack::save(uint32_t jumpNumber)
+{
+  SlotHeader header;
+
+  if (_partition == NULL || _encoder.samples() == 0)
+  {
+    return false;
+  }
+  uint32_t address = slotAddress(jumpNumber);
+  // only the sectors the track needs, a short track costs fewer erases
+  uint32_t used = (sizeof(header) + _encoder.length() + sectorSize - 1) / sectorSize * sectorSize;
+  if (esp_partition_erase_range(_partition, address, used) != ESP_OK)
+  {
+    return false;
+  }
+  memset(&header, 0xFF, sizeof(header));
+  header.magic = JUMPTRACK_MAGIC;
+  header.jumpNumber = jumpNumber;
+  header.samples = _encoder.samples();
+  header.length = _encoder.length();
+  header.dataCrc = JumpLog::crc32(_buffer, _encoder.length());
+  header.crc = JumpLog::crc32(&header, offsetof(SlotHeader, crc));
+  // data first, a valid header then means a complete track
+  if (esp_partition_write(_partition, address + sizeof(header), _buffer, _encoder.length()) != ESP_OK)
+  {
+    return false;
+  }
+  return esp_partition_write(_partition, address, &header, sizeof(header)) == ESP_OK;
+}
+
+bool JumpTrack::load(uint32_t jumpNumber, uint8_t *data, size_t size, size_t &length, uint32_t &samples)
+{
+  SlotHeader header;
+
+  if (_partition == NULL)
+  {
+    return false;
+  }
+  uint32_t address = slotAddress(jumpNumber);
+  if (esp_partition_read(_partition, address, &header, sizeof(header)) != ESP_OK ||
+      header.magic != JUMPTRACK_MAGIC || header.crc != JumpLog::crc32(&header, offsetof(SlotHeader, crc)) ||
+      header.jumpNumber != jumpNumber || header.length > size)
+  {
+    return false;
+  }
+  if (esp_partition_read(_partition, address + sizeof(header), data, header.length) != ESP_OK ||
+      header.dataCrc != JumpLog::crc32(data, header.length))
+  {
+    return false;
+  }
+  length = header.length;
+  samples = header.samples;
+  return true;
+}
@@ -0,0 +1,65 @@
+#ifndef JUMPTRACK_H
+#define JUMPTRACK_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "TrackCodec.h"
+
+// Altitude and vertical speed of a jump from exit to landing at the rate of the
+// sensor task (25 Hz in freefall, 10 Hz under canopy).
+//
+// Samples are delta encoded into a fixed RAM buffer while jumping, so adding
+// one never touches flash. save() writes the whole track after landing into a
+// fixed slot of the "tracks" partition, the slot of a jump is its number
+// modulo the number of slots, so the partition keeps the last tracks.
+class JumpTrack
+{
+  public:
+    static const uint32_t sectorSize = 4096;
+    static const uint32_t slotSize = 6 * sectorSize;
+    // about 8000 samples, 6 minutes of canopy after a full altitude freefall
+    static const uint32_t bufferSize = slotSize - 32;
+
+    JumpTrack();
+    bool begin(const char *label = "tracks");
+
+    void start();
+    // timeUs: timestamp of the sensor sample, altitude in m, vertical speed in m/s
+    void add(uint32_t timeUs, float altitude, float verticalSpeed);
+    void stop() { _recording = false; }
+    bool save(uint32_t jumpNumber);
+
+    bool recording() { return _recording; }
+    uint32_t samples() { return _encoder.samples(); }
+    size_t length() { return _encoder.length(); }
+    // the buffer filled up before landing, the end of the jump is missing
+    bool truncated() { return _encoder.full(); }
+
+    // copies the encoded track of a jump into data, false if the slot holds another jump
+    bool load(uint32_t jumpNumber, uint8_t *data, size_t size, size_t &length, uint32_t &samples);
+
+  private:
+    struct SlotHeader
+    {
+      uint32_t magic;
+      uint32_t jumpNumber;
+      uint32_t samples;
+      uint32_t length;
+      uint32_t dataCrc;
+      uint8_t reserved[8];
+      uint32_t crc;
+    };
+
+    uint32_t slotAddress(uint32_t jumpNumber) { return (jumpNumber % _slots) * slotSize; }
+
+    const esp_partition_t *_partition = NULL;
+    uint32_t _slots = 0;
+
+    bool _recording = false;
+    uint32_t _lastTimeUs = 0;
+    uint64_t _elapsedUs = 0;
+    uint8_t _buffer[bufferSize];
+    TrackEncoder _encoder;
+};
+
+#endif // end of JUMPTRACK_H
@@ -0,0 +1,133 @@
+#ifndef TRACKCODEC_H
+#define TRACKCODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// one point of a jump track, in the fixed point units it is stored with
+struct TrackSample
+{
+  uint32_t timeMs;       // since exit
+  int32_t altitude;      // dm
+  int32_t verticalSpeed; // dm/s
+};
+
+// Track samples are stored as the difference to the previous sample: time as
+// unsigned varint, altitude and vertical speed zigzag encoded as signed varints
+// (LEB128, 7 bits per byte). Between two samples at 10-25 Hz all three deltas
+// fit into one byte even in freefall, so a sample takes about three bytes.
+// Plain C++ without Arduino dependencies, the native sim and the host tools
+// decode flash dumps with the same code.
+class TrackEncoder
+{
+  public:
+    // longest encoding of one sample: 5 bytes per 32 bit varint
+    static const size_t maxSampleSize = 15;
+
+    TrackEncoder(uint8_t *buffer, size_t size) : _buffer(buffer), _size(size) {}
+
+    void reset()
+    {
+      _length = 0;
+      _samples = 0;
+      _full = false;
+      memset(&_last, 0, sizeof(_last));
+    }
+
+    // false once the buffer is full, a sample is never stored partially
+    bool add(const TrackSample &sample)
+    {
+      uint8_t encoded[maxSampleSize];
+      size_t length = 0;
+
+      length += putVarint(encoded + length, sample.timeMs - _last.timeMs);
+      length += putVarint(encoded + length, zigzag(sample.altitude - _last.altitude));
+      length += putVarint(encoded + length, zigzag(sample.verticalSpeed - _last.verticalSpeed));
+      if (_full || _length + length > _size)
+      {
+        _full = true;
+        return false;
+      }
+      memcpy(_buffer + _length, encoded, length);
+      _length += length;
+      _samples++;
+      _last = sample;
+      return true;
+    }
+
+    size_t length() const { return _length; }
+    uint32_t samples() const { return _samples; }
+    bool full() const { return _full; }
+
+    static uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+
+    static size_t putVarint(uint8_t *out, uint32_t value)
+    {
+      size_t length = 0;
+      while (value >= 0x80)
+      {
+        out[length++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+      }
+      out[length++] = value;
+      return length;
+    }
+
+  private:
+    uint8_t *_buffer;
+    size_t _size;
+    size_t _length = 0;
+    uint32_t _samples = 0;
+    bool _full = false;
+    TrackSample _last = {0, 0, 0};
+};
+
+class TrackDecoder
+{
+  public:
+    TrackDecoder(const uint8_t *data, size_t length) : _data(data), _length(length) {}
+
+    // false at the end of the data or on a varint cut off by the end
+    bool next(TrackSample &sample)
+    {
+      uint32_t time;
+      uint32_t altitude;
+      uint32_t verticalSpeed;
+
+      if (!getVarint(time) || !getVarint(altitude) || !getVarint(verticalSpeed))
+      {
+        return false;
+      }
+      _last.timeMs += time;
+      _last.altitude += unzigzag(altitude);
+      _last.verticalSpeed += unzigzag(verticalSpeed);
+      sample = _last;
+      return true;
+    }
+
+    static int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+  private:
+    bool getVarint(uint32_t &value)
+    {
+      value = 0;
+      for (int shift = 0; shift < 35 && _position < _length; shift += 7)
+      {
+        uint8_t byte = _data[_position++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    const uint8_t *_data;
+    size_t _length;
+    size_t _position = 0;
+    TrackSample _last = {0, 0, 0};
+};
+
+#endif // end of TRACKCODEC_H
@@ -0,0 +1,72 @@
+#ifndef JUMPMODES_H
+#define JUMPMODES_H
+
+#include <Arduino.h>
+#include <Bmp280.h>
+#include <JumpDetector.h>
+
+// The work modes of the altimeter, the pressure sensor settings of each and the
+// mode changes of a jump. main.cpp runs on these, and the host benchmarks replay
+// a jump with the same rates, filters and transitions.
+
+#define MODE_FREEFALL 0
+#define MODE_CANOPY 1
+#define MODE_AIRPLANE 2
+#define MODE_GROUND 3
+#define MODE_MENU 4
+#define MODE_UPDATE 5
+
+const unsigned long sleepTime = 30;    // s on the ground without action before the deep sleep
+const unsigned long sleepForTime = 10; // s between two wakeups that check for a climb
+const int climbAltitude = 50;          // m above the ground reference that count as a climb
+
+// pressure sensor settings per mode, indexed by MODE_*
+struct SensorProfile
+{
+  Bmp280::Oversampling temperatureSampling;
+  Bmp280::Oversampling pressureSampling;
+  Bmp280::Filter filter;
+  Bmp280::Standby standby;
+  uint16_t samplePeriod; // in ms between two pressure samples, at least the measurement period or a conversion is read twice
+
+  // a new reading moves the filtered pressure by 1 / coefficient of its difference
+  uint8_t filterCoefficient() const { return 1 << filter; }
+};
+
+const SensorProfile sensorProfiles[] = {
+    {Bmp280::SAMPLING_X1, Bmp280::SAMPLING_X4, Bmp280::FILTER_X2, Bmp280::STANDBY_MS_1, 40},        // freefall: 25 Hz, barely filtered
+    {Bmp280::SAMPLING_X1, Bmp280::SAMPLING_X8, Bmp280::FILTER_X4, Bmp280::STANDBY_MS_1, 100},       // canopy: 10 Hz
+    {Bmp280::SAMPLING_X2, Bmp280::SAMPLING_X16, Bmp280::FILTER_X2, Bmp280::STANDBY_MS_63, 250},     // airplane: 4 Hz, X4 would delay the exit by 0.5 s
+    {Bmp280::SAMPLING_X2, Bmp280::SAMPLING_X16, Bmp280::FILTER_X16, Bmp280::STANDBY_MS_500, 1000},  // ground: 1 Hz, a new conversion every 543 ms
+    {Bmp280::SAMPLING_X2, Bmp280::SAMPLING_X16, Bmp280::FILTER_X16, Bmp280::STANDBY_MS_500, 1000},  // menu
+    {Bmp280::SAMPLING_X2, Bmp280::SAMPLING_X16, Bmp280::FILTER_X16, Bmp280::STANDBY_MS_500, 1000},  // update
+};
+
+// the mode of the jump detector's phase
+inline uint8_t jumpMode(JumpDetector::Phase phase)
+{
+  static const uint8_t modes[] = {MODE_AIRPLANE, MODE_FREEFALL, MODE_CANOPY, MODE_GROUND};
+  return modes[phase];
+}
+
+// the mode to change to after a sample, altitude in m above the ground reference. The
+// detector only counts from the climb on, changing to MODE_AIRPLANE has to reset it.
+inline uint8_t nextMode(uint8_t mode, const JumpDetector &detector, float altitude)
+{
+  switch (mode)
+  {
+  case MODE_GROUND:
+    return altitude > climbAltitude ? MODE_AIRPLANE : MODE_GROUND;
+  case MODE_AIRPLANE:
+    return detector.happened(JumpDetector::EXIT)      ? MODE_FREEFALL
+           : detector.happened(JumpDetector::LANDING) ? MODE_GROUND
+                                                      : MODE_AIRPLANE;
+  case MODE_FREEFALL:
+    return detector.happened(JumpDetector::DEPLOYMENT) ? MODE_CANOPY : MODE_FREEFALL;
+  case MODE_CANOPY:
+    return detector.happened(JumpDetector::LANDING) ? MODE_GROUND : MODE_CANOPY;
+  }
+  return mode;
+}
+
+#endif // end of JUMPMODES_H
@@ -0,0 +1,89 @@
+#include "PowerManager.h"
+#include <esp_timer.h>
+
+void PowerManager::begin(Usage *usage, uint8_t modes)
+{
+  _usage = usage;
+  _modes = modes;
+  // the time since the boot counts to the mode of the first apply()
+  _lastUs = 0;
+  _lastIdleUs = _scheduler.idleUs();
+  _lastLightSleepUs = _scheduler.lightSleepUs();
+
+  esp_pm_config_esp32_t config = {};
+  config.max_freq_mhz = maxMhz;
+  config.min_freq_mhz = minMhz;
+  config.light_sleep_enable = false;
+  if (esp_pm_configure(&config) == ESP_OK && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "mode", &_lock) != ESP_OK)
+  {
+    _lock = NULL;
+  }
+}
+
+void PowerManager::apply(uint8_t mode, const Profile &profile)
+{
+  if (_mode == noMode)
+  {
+    // the boot ran in the first mode: nothing was accounted to any mode yet
+    _mode = mode;
+    _profile = profile;
+  }
+  account();
+  _mode = mode;
+  _profile = profile;
+
+  if (_lock == NULL)
+  {
+    setCpuFrequencyMhz(profile.cpuMhz);
+    return;
+  }
+  bool full = profile.cpuMhz >= maxMhz;
+  if (full && !_locked)
+  {
+    esp_pm_lock_acquire(_lock);
+  }
+  else if (!full && _locked)
+  {
+    esp_pm_lock_release(_lock);
+  }
+  _locked = full;
+}
+
+void PowerManager::account()
+{
+  int64_t nowUs = esp_timer_get_time();
+  uint64_t idleUs = _scheduler.idleUs() - _lastIdleUs;
+  uint64_t lightSleepUs = _scheduler.lightSleepUs() - _lastLightSleepUs;
+  uint64_t elapsedUs = nowUs - _lastUs;
+  _lastUs = nowUs;
+  _lastIdleUs = _scheduler.idleUs();
+  _lastLightSleepUs = _scheduler.lightSleepUs();
+  if (_usage == NULL || _mode >= _modes)
+  {
+    return;
+  }
+
+  uint64_t activeUs = elapsedUs - idleUs;
+  uint64_t waitUs = idleUs - lightSleepUs;
+
+  Usage &usage = _usage[_mode];
+  usage.activeUs += activeUs;
+  usage.idleUs += waitUs;
+  usage.lightSleepUs += lightSleepUs;
+  usage.chargeNc += (activeUs * activeUa(_profile.cpuMhz) + waitUs * idleUa(_profile.cpuMhz) + lightSleepUs * lightSleepUa) / 1000;
+  usage.fullClockChargeNc += elapsedUs * activeUa(maxMhz) / 1000;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+// ESP32 datasheet, modem sleep with the radio off: the upper end of the range with the CPU
+// running, the lower end with it waiting
+uint32_t PowerManager::activeUa(uint16_t mhz)
+{
+  return mhz >= 240 ? 68000 : mhz >= 160 ? 44000 : 31000;
+}
+
+uint32_t PowerManager::idleUa(uint16_t mhz)
+{
+  return mhz >= 240 ? 30000 : mhz >= 160 ? 27000 : 20000;
+}
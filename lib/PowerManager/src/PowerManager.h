@@ -0,0 +1,74 @@
+#ifndef POWERMANAGER_H
+#define POWERMANAGER_H
+
+#include <Arduino.h>
+#include <JobScheduler.h>
+#include <esp_pm.h>
+
+// CPU clock per work mode, and what the CPU draws in each mode.
+//
+// With power management in the SDK, DFS runs the CPU between minMhz and maxMhz and
+// a profile at maxMhz holds a CPU_FREQ_MAX lock. Drivers take their own APB locks for
+// transfers. Without it, the CPU clock is set directly. Light sleep between jobs is
+// left to the scheduler: the Arduino core has no tickless idle for the automatic one.
+//
+// Time in every mode is split into the CPU running, waiting for the next job
+// (JobScheduler::idleUs()) and light sleep. The charge is estimated from the modem
+// sleep currents of the ESP32 datasheet. The usage lives in RTC memory of the caller
+// and adds up over all boots until power off.
+class PowerManager
+{
+  public:
+    static const uint16_t maxMhz = 240;
+    static const uint16_t minMhz = 80;
+
+    struct Profile
+    {
+      uint16_t cpuMhz;
+      bool lightSleep; // between jobs, see JobScheduler::setLightSleepCheck()
+    };
+
+    struct Usage
+    {
+      uint64_t activeUs;
+      uint64_t idleUs; // without light sleep
+      uint64_t lightSleepUs;
+      uint64_t chargeNc;          // nC = mA * us
+      uint64_t fullClockChargeNc; // the same time running at maxMhz without a break
+    };
+
+    PowerManager(JobScheduler &scheduler) : _scheduler(scheduler) {}
+
+    // usage holds one entry per mode and is only cleared by the caller
+    void begin(Usage *usage, uint8_t modes);
+    // accounts the time since the last change to the previous mode, then switches the clock
+    void apply(uint8_t mode, const Profile &profile);
+    // adds the time since the last call to the current mode
+    void account();
+
+    bool lightSleepAllowed() const { return _profile.lightSleep; }
+    uint16_t cpuMhz() const { return _profile.cpuMhz; }
+    bool dfs() const { return _lock != NULL; }
+    const Usage &usage(uint8_t mode) const { return _usage[mode]; }
+
+    // µA at a CPU clock, while the CPU runs or waits
+    static uint32_t activeUa(uint16_t mhz);
+    static uint32_t idleUa(uint16_t mhz);
+    static const uint32_t lightSleepUa = 800;
+
+  private:
+    static const uint8_t noMode = 0xFF;
+
+    JobScheduler &_scheduler;
+    Usage *_usage = NULL;
+    uint8_t _modes = 0;
+    uint8_t _mode = noMode; // until the first apply()
+    Profile _profile = {maxMhz, false};
+    esp_pm_lock_handle_t _lock = NULL;
+    bool _locked = false;
+    int64_t _lastUs = 0;
+    uint64_t _lastIdleUs = 0;
+    uint64_t _lastLightSleepUs = 0;
+};
+
+#endif // end of POWERMANAGER_H
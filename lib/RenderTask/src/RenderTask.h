@@ -0,0 +1,129 @@
+#ifndef RENDERTASK_H
+#define RENDERTASK_H
+
+#include <Arduino.h>
+#include <DoubleBuffer.h>
+#include <atomic>
+#include <esp_timer.h>
+
+// Draws what the mode logic publishes from a task pinned to the other core, so
+// drawing and the display transfer don't hold up the altitude pipeline.
+//
+// The mode logic fills a small State and hands it over with publish(), which
+// copies it into a DoubleBuffer and returns right away. The task draws the
+// newest State whenever it is free again: a State replaced before the task got
+// to it is skipped, not queued, so a slow frame never delays the next ones.
+// draw() is the only code that touches the display once begin() was called.
+template <typename State>
+class RenderTask
+{
+  public:
+    typedef void (*DrawFunction)(const State &state);
+
+    void begin(DrawFunction draw, BaseType_t core)
+    {
+      _draw = draw;
+      // below the sensor task, above the log
+      xTaskCreatePinnedToCore(taskMain, "render", 4096, this, tskIDLE_PRIORITY + 2, &_task, core);
+    }
+
+    void publish(const State &state)
+    {
+      Frame frame;
+      frame.state = state;
+      frame.publishedUs = esp_timer_get_time();
+      _frames.write(frame);
+      if (_task)
+      {
+        xTaskNotifyGive(_task);
+      }
+    }
+
+    // the task gets its notification bits (eSetBits) whenever it drew everything published, so
+    // the loop can try a light sleep again
+    void notifyWhenIdle(TaskHandle_t task, uint32_t notifyBits)
+    {
+      _idleTask = task;
+      _idleNotifyBits = notifyBits;
+    }
+
+    // everything published is drawn
+    bool idle() const { return !_frames.pending() && !_drawing.load(); }
+    // waits until idle(), before the display is switched off
+    void flush()
+    {
+      while (_task && !idle())
+      {
+        vTaskDelay(1);
+      }
+    }
+
+    uint32_t frames() const { return _drawn; }
+    // published but replaced by a newer State before it was drawn
+    uint32_t skipped() const { return _frames.skipped(); }
+    // from publish() until draw() returned
+    uint32_t latencyMaxUs() const { return _latencyMaxUs; }
+    uint32_t latencyAvgUs() const { return _latencyAvgUs; }
+    // time draw() took
+    uint32_t drawMaxUs() const { return _drawMaxUs; }
+
+  private:
+    struct Frame
+    {
+      State state;
+      uint32_t publishedUs;
+    };
+
+    static void taskMain(void *arg)
+    {
+      RenderTask *self = (RenderTask *)arg;
+      // a State published before begin() is drawn right away
+      for (;;)
+      {
+        self->drawPending();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      }
+    }
+
+    void drawPending()
+    {
+      Frame frame;
+      // set before the read, so idle() can't fall between taking a State and drawing it
+      _drawing.store(true);
+      bool drew = false;
+      while (_frames.read(frame))
+      {
+        drew = true;
+        uint32_t startUs = esp_timer_get_time();
+        _draw(frame.state);
+        uint32_t endUs = esp_timer_get_time();
+        uint32_t latencyUs = endUs - frame.publishedUs;
+        _drawn++;
+        _latencyTotalUs += latencyUs;
+        _latencyAvgUs = _latencyTotalUs / _drawn;
+        _latencyMaxUs = latencyUs > _latencyMaxUs ? latencyUs : _latencyMaxUs;
+        _drawMaxUs = endUs - startUs > _drawMaxUs ? endUs - startUs : _drawMaxUs;
+      }
+      _drawing.store(false);
+      if (drew && _idleTask)
+      {
+        xTaskNotify(_idleTask, _idleNotifyBits, eSetBits);
+      }
+    }
+
+    DoubleBuffer<Frame> _frames;
+    DrawFunction _draw = NULL;
+    TaskHandle_t _task = NULL;
+    TaskHandle_t _idleTask = NULL;
+    uint32_t _idleNotifyBits = 0;
+    std::atomic<bool> _drawing{false};
+
+    volatile uint32_t _drawn = 0;
+    volatile uint32_t _latencyMaxUs = 0;
+    volatile uint32_t _drawMaxUs = 0;
+    volatile uint32_t _latencyAvgUs = 0;
+    // only touched by the task, the other core reads _latencyAvgUs
+    uint64_t _latencyTotalUs = 0;
+};
+
+#endif // end of RENDERTASK_H
@@ -0,0 +1,59 @@
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free single producer / single consumer ring buffer.
+// push() may only be called from one task and pop() from one other task.
+// When the ring is full the new element is dropped and counted, the consumer
+// never sees a half written element.
+template <typename T, size_t SIZE>
+class SampleRing
+{
+    static_assert((SIZE & (SIZE - 1)) == 0, "SampleRing size must be a power of two");
+
+  public:
+    bool push(const T &item)
+    {
+      uint32_t head = _head.load(std::memory_order_relaxed);
+      if (head - _tail.load(std::memory_order_acquire) == SIZE)
+      {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      _items[head & (SIZE - 1)] = item;
+      _head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool pop(T &item)
+    {
+      uint32_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+      item = _items[tail & (SIZE - 1)];
+      _tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    size_t available() const
+    {
+      return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    // number of elements lost because the consumer did not keep up
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    static constexpr size_t capacity() { return SIZE; }
+
+  private:
+    T _items[SIZE];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
+
+#endif // end of SAMPLERING_H
@@ -0,0 +1,185 @@
+#include "SensorFusion.h"
+#include <math.h>
+
+namespace
+{
+  // outside of this the sensor or its compensation is broken, not the altitude
+  const float minAltitudeM = -1000;
+  const float maxAltitudeM = 12000;
+  // weights of a new value in the moving means
+  const float noiseAlpha = 1.0f / 32;
+  const float offsetAlpha = 1.0f / 64;
+  // noise assumed before a sensor has a history
+  const float initialNoiseM = 0.5f;
+}
+
+void SensorFusion::reset()
+{
+  for (uint8_t i = 0; i < sensors; i++)
+  {
+    Stats stats = _sensors[i].stats;
+    _sensors[i] = Sensor();
+    _sensors[i].stats = stats;
+    _sensors[i].squaredError = 6 * initialNoiseM * initialNoiseM;
+  }
+  // the reference pressures are taken per sensor, so both start at the same altitude
+  _offset = 0;
+  _fused[0] = _fused[1] = 0;
+  _fusedHistory = 0;
+  _agreeing = 0;
+  _newFaults = 0;
+}
+
+float SensorFusion::noise(uint8_t sensor) const
+{
+  return sqrtf(variance(sensor));
+}
+
+float SensorFusion::variance(uint8_t sensor) const
+{
+  float variance = _sensors[sensor].squaredError / 6;
+  return variance > minNoiseM * minNoiseM ? variance : minNoiseM * minNoiseM;
+}
+
+void SensorFusion::setFault(uint8_t sensor, Fault fault)
+{
+  Sensor &entry = _sensors[sensor];
+  if (entry.fault == fault)
+  {
+    return;
+  }
+  // a sensor left out already only changes the kind of its fault, e.g. an outlier that turns out stuck
+  if (entry.fault == FAULT_NONE)
+  {
+    _newFaults |= 1 << sensor;
+  }
+  entry.fault = fault;
+  if (fault == FAULT_INVALID)
+  {
+    entry.stats.invalid++;
+  }
+  else if (fault == FAULT_STUCK)
+  {
+    entry.stats.stuck++;
+  }
+  else if (fault == FAULT_OUTLIER)
+  {
+    entry.stats.outliers++;
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+float SensorFusion::update(float altitude1, float altitude2)
+{
+  const float altitude[sensors] = {altitude1, altitude2};
+  // both moved by half the offset, onto their common mean
+  const float corrected[sensors] = {altitude1 - _offset / 2, altitude2 + _offset / 2};
+  bool valid[sensors];
+  float error[sensors] = {};
+  _newFaults = 0;
+
+  for (uint8_t i = 0; i < sensors; i++)
+  {
+    Sensor &sensor = _sensors[i];
+    valid[i] = isfinite(altitude[i]) && altitude[i] > minAltitudeM && altitude[i] < maxAltitudeM;
+    if (!valid[i])
+    {
+      setFault(i, FAULT_INVALID);
+      continue;
+    }
+    sensor.repeats = sensor.history && altitude[i] == sensor.last[0] ? sensor.repeats + 1 : 0;
+    if (sensor.history >= 2)
+    {
+      error[i] = altitude[i] - 2 * sensor.last[0] + sensor.last[1];
+    }
+  }
+
+  // a frozen value only stands out against a sensor that moves
+  for (uint8_t i = 0; i < sensors; i++)
+  {
+    const Sensor &other = _sensors[1 - i];
+    if (valid[i] && valid[1 - i] && _sensors[i].repeats >= stuckSamples && other.repeats == 0)
+    {
+      setFault(i, FAULT_STUCK);
+      // the frozen one caused the disagreement, not the one that kept moving
+      if (other.fault == FAULT_OUTLIER)
+      {
+        _sensors[1 - i].fault = FAULT_NONE;
+      }
+    }
+  }
+
+  bool both = valid[0] && valid[1];
+  float limit = outlierSigmas * sqrtf(variance(0) + variance(1));
+  limit = limit > outlierMinM ? limit : outlierMinM;
+  bool agree = both && fabsf(altitude1 - altitude2 - _offset) <= limit;
+  if (both && !agree && _sensors[0].fault == FAULT_NONE && _sensors[1].fault == FAULT_NONE)
+  {
+    // one that repeats its value while the other moves is about to count as stuck, otherwise
+    // the one further from where the fused altitude was heading
+    float predicted = _fusedHistory >= 2 ? 2 * _fused[0] - _fused[1] : _fused[0];
+    uint8_t blamed = fabsf(corrected[0] - predicted) > fabsf(corrected[1] - predicted) ? 0 : 1;
+    if (_sensors[0].repeats != _sensors[1].repeats && (_sensors[0].repeats == 0 || _sensors[1].repeats == 0))
+    {
+      blamed = _sensors[0].repeats > _sensors[1].repeats ? 0 : 1;
+    }
+    setFault(blamed, FAULT_OUTLIER);
+  }
+  _agreeing = agree ? (_agreeing < rejoinSamples ? _agreeing + 1 : _agreeing) : 0;
+  for (uint8_t i = 0; i < sensors; i++)
+  {
+    if (_sensors[i].fault != FAULT_NONE && valid[i] && _sensors[i].repeats == 0 && _agreeing >= rejoinSamples)
+    {
+      _sensors[i].fault = FAULT_NONE;
+    }
+  }
+
+  // healthy sensors, a faulty one only if there is no healthy one
+  bool any = false;
+  for (uint8_t i = 0; i < sensors; i++)
+  {
+    _sensors[i].used = valid[i] && _sensors[i].fault == FAULT_NONE;
+    any |= _sensors[i].used;
+  }
+  for (uint8_t i = 0; i < sensors && !any; i++)
+  {
+    _sensors[i].used = valid[i];
+  }
+
+  float sum = 0;
+  float weights = 0;
+  for (uint8_t i = 0; i < sensors; i++)
+  {
+    Sensor &sensor = _sensors[i];
+    if (sensor.used)
+    {
+      float weight = 1 / variance(i);
+      sum += weight * corrected[i];
+      weights += weight;
+      if (sensor.history >= 2)
+      {
+        sensor.squaredError += (error[i] * error[i] - sensor.squaredError) * noiseAlpha;
+      }
+    }
+    else
+    {
+      sensor.stats.excludedSamples++;
+    }
+    if (valid[i])
+    {
+      sensor.last[1] = sensor.last[0];
+      sensor.last[0] = altitude[i];
+      sensor.history = sensor.history < 2 ? sensor.history + 1 : 2;
+    }
+  }
+  if (_sensors[0].used && _sensors[1].used)
+  {
+    _offset += (altitude1 - altitude2 - _offset) * offsetAlpha;
+  }
+
+  _fused[1] = _fused[0];
+  _fused[0] = weights > 0 ? sum / weights : _fused[0];
+  _fusedHistory = _fusedHistory < 2 ? _fusedHistory + 1 : 2;
+  return _fused[0];
+}
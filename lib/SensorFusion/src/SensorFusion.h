@@ -0,0 +1,89 @@
+#ifndef SENSORFUSION_H
+#define SENSORFUSION_H
+
+#include <stdint.h>
+
+// Combines the altitudes of the two pressure sensors into one, sample by sample.
+//
+// Each sensor keeps its own noise, from the second difference of its readings (6 sigma^2
+// for white noise, the motion of a jump adds far less at the sample rates used), and the
+// two keep a slowly tracked offset between them. The fused altitude is the inverse variance
+// weighted mean of both readings, each moved by half the offset, so dropping one sensor
+// does not step the altitude.
+//
+// A sensor is left out while it
+// - reads no number or one outside the physical range (INVALID),
+// - repeats the same value while the other one moves (STUCK),
+// - disagrees with the other beyond the noise and is the one further from the track of the
+//   fused altitude (OUTLIER); it comes back after agreeing for rejoinSamples in a row.
+// Every sample yields an altitude: from one sensor if needed, from a faulty one if neither
+// is healthy, and the last altitude if neither reads a number at all.
+class SensorFusion
+{
+  public:
+    static const uint8_t sensors = 2;
+    static const uint8_t stuckSamples = 8;
+    static const uint8_t rejoinSamples = 5;
+    static constexpr float outlierMinM = 3.0f;
+    static constexpr float outlierSigmas = 6.0f;
+    static constexpr float minNoiseM = 0.05f;
+
+    enum Fault : uint8_t
+    {
+      FAULT_NONE,
+      FAULT_INVALID,
+      FAULT_STUCK,
+      FAULT_OUTLIER,
+    };
+
+    // counted when a fault of that kind starts, excludedSamples for every sample left out
+    struct Stats
+    {
+      uint16_t invalid;
+      uint16_t stuck;
+      uint16_t outliers;
+      uint32_t excludedSamples;
+    };
+
+    SensorFusion() { reset(); }
+
+    // forget history, noise and offset, e.g. after new reference pressures; the counters stay
+    void reset();
+    // altitudes in m of both sensors from the same sample
+    float update(float altitude1, float altitude2);
+
+    float altitude() const { return _fused[0]; }
+    Fault fault(uint8_t sensor) const { return _sensors[sensor].fault; }
+    bool used(uint8_t sensor) const { return _sensors[sensor].used; }
+    // standard deviation of one reading in m
+    float noise(uint8_t sensor) const;
+    // altitude1 - altitude2 in m
+    float offset() const { return _offset; }
+    // bit per sensor that was healthy before the last update() and is left out since
+    uint8_t newFaults() const { return _newFaults; }
+    const Stats &stats(uint8_t sensor) const { return _sensors[sensor].stats; }
+
+  private:
+    struct Sensor
+    {
+      float last[2]; // the last two valid readings, newest first
+      uint8_t history;
+      uint8_t repeats;
+      float squaredError; // moving mean of the squared second difference
+      Fault fault;
+      bool used;
+      Stats stats;
+    };
+
+    void setFault(uint8_t sensor, Fault fault);
+    float variance(uint8_t sensor) const;
+
+    Sensor _sensors[sensors] = {};
+    float _offset = 0;
+    float _fused[2] = {}; // newest first
+    uint8_t _fusedHistory = 0;
+    uint8_t _agreeing = 0;
+    uint8_t _newFaults = 0;
+};
+
+#endif // end of SENSORFUSION_H
@@ -0,0 +1,123 @@
+#include "SensorTask.h"
+
+SensorTask::SensorTask(Bmp280 &sensor1, Bmp280 &sensor2) : _sensor1(sensor1), _sensor2(sensor2)
+{
+}
+
+void SensorTask::begin(uint32_t periodMs, BaseType_t core)
+{
+  _busMutex = xSemaphoreCreateMutex();
+  _periodUs = periodMs * 1000;
+  xTaskCreatePinnedToCore(taskMain, "sensors", 4096, this, configMAX_PRIORITIES - 2, &_task, core);
+
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = &onTimer;
+  timerArgs.arg = this;
+  timerArgs.name = "sensors";
+  esp_timer_create(&timerArgs, &_timer);
+  esp_timer_start_periodic(_timer, _periodUs);
+}
+
+void SensorTask::setPeriod(uint32_t periodMs)
+{
+  if (_periodUs == periodMs * 1000)
+  {
+    return;
+  }
+  _periodUs = periodMs * 1000;
+  if (_timer)
+  {
+    esp_timer_stop(_timer);
+    esp_timer_start_periodic(_timer, _periodUs);
+  }
+  _lastTimeUs = 0;
+}
+
+AltitudeSample SensorTask::read()
+{
+  AltitudeSample sample;
+  sample.timeUs = esp_timer_get_time();
+  // on a bus error the previous reading is repeated
+  _sensor1.read();
+  _sensor2.read();
+  sample.pressure1 = _sensor1.pressure();
+  sample.pressure2 = _sensor2.pressure();
+  sample.temperature = _sensor1.temperature();
+  return sample;
+}
+
+bool SensorTask::lockBus(TickType_t timeout)
+{
+  // before begin() nobody else uses the bus
+  return _busMutex == NULL || xSemaphoreTake(_busMutex, timeout) == pdTRUE;
+}
+
+void SensorTask::unlockBus()
+{
+  if (_busMutex != NULL)
+  {
+    xSemaphoreGive(_busMutex);
+  }
+}
+
+// runs in the esp_timer task
+void SensorTask::onTimer(void *arg)
+{
+  SensorTask *self = (SensorTask *)arg;
+  self->_tickTimeUs = esp_timer_get_time();
+  xTaskNotifyGive(self->_task);
+}
+
+void SensorTask::taskMain(void *arg)
+{
+  SensorTask *self = (SensorTask *)arg;
+  for (;;)
+  {
+    // more than one pending tick means the previous sample took longer than a period
+    uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (ticks > 1)
+    {
+      self->_missedTicks += ticks - 1;
+    }
+    self->acquire(self->_tickTimeUs);
+  }
+}
+
+uint32_t SensorTask::jitterAvgUs()
+{
+  portENTER_CRITICAL(&_jitterLock);
+  uint64_t sumUs = _jitterSumUs;
+  uint32_t count = _jitterCount;
+  portEXIT_CRITICAL(&_jitterLock);
+  return count ? sumUs / count : 0;
+}
+
+void SensorTask::acquire(uint32_t timeUs)
+{
+  uint32_t startUs = esp_timer_get_time();
+  if (_lastTimeUs != 0)
+  {
+    int32_t deviation = (int32_t)(startUs - _lastTimeUs - _periodUs);
+    uint32_t jitter = deviation < 0 ? -deviation : deviation;
+    portENTER_CRITICAL(&_jitterLock);
+    _jitterSumUs += jitter;
+    _jitterCount++;
+    portEXIT_CRITICAL(&_jitterLock);
+    if (jitter > _jitterMaxUs)
+    {
+      _jitterMaxUs = jitter;
+    }
+  }
+  _lastTimeUs = startUs;
+
+  lockBus();
+  AltitudeSample sample = read();
+  unlockBus();
+  sample.timeUs = timeUs;
+  _ring.push(sample);
+  _samples++;
+  if (_consumer)
+  {
+    xTaskNotify(_consumer, _notifyBits, eSetBits);
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef SENSORTASK_H
+#define SENSORTASK_H
+
+#include <Arduino.h>
+#include <Bmp280.h>
+#include <SampleRing.h>
+#include <esp_timer.h>
+
+struct AltitudeSample
+{
+  uint32_t timeUs;   // esp_timer time of the timer tick that triggered the sample
+  float pressure1;   // Pa
+  float pressure2;   // Pa
+  float temperature; // °C from sensor 1
+};
+
+// Samples both pressure sensors from a task pinned to its own core. A periodic
+// esp_timer wakes the task, so the sample cadence does not depend on how long the
+// display or the mode logic take. Unlike the timer group counters esp_timer keeps
+// its alarms across light sleep. Samples are handed over through a lock-free ring,
+// the consumer task gets its notification bits (eSetBits) for each.
+class SensorTask
+{
+  public:
+    SensorTask(Bmp280 &sensor1, Bmp280 &sensor2);
+    void begin(uint32_t periodMs, BaseType_t core);
+    void setPeriod(uint32_t periodMs);
+    void setConsumer(TaskHandle_t task, uint32_t notifyBits)
+    {
+      _consumer = task;
+      _notifyBits = notifyBits;
+    }
+    bool running() { return _task != NULL; }
+
+    // blocking read for use before begin()
+    AltitudeSample read();
+    bool pop(AltitudeSample &sample) { return _ring.pop(sample); }
+
+    // the RTC shares the I2C bus, everybody else has to hold the lock while using Wire
+    bool lockBus(TickType_t timeout = portMAX_DELAY);
+    void unlockBus();
+
+    uint32_t samples() { return _samples; }
+    // samples lost because the ring was full or the task missed a timer tick
+    uint32_t dropped() { return _ring.dropped() + _missedTicks; }
+    // deviation of the sampling interval from the timer period
+    uint32_t jitterMaxUs() { return _jitterMaxUs; }
+    // the first sample after begin() and setPeriod() has no interval to compare
+    uint32_t jitterAvgUs();
+
+  private:
+    static void onTimer(void *arg);
+    static void taskMain(void *arg);
+    void acquire(uint32_t timeUs);
+
+    Bmp280 &_sensor1;
+    Bmp280 &_sensor2;
+    SampleRing<AltitudeSample, 32> _ring;
+    esp_timer_handle_t _timer = NULL;
+    TaskHandle_t _task = NULL;
+    TaskHandle_t _consumer = NULL;
+    uint32_t _notifyBits = 0;
+    SemaphoreHandle_t _busMutex = NULL;
+
+    volatile uint32_t _tickTimeUs = 0;
+    uint32_t _periodUs = 0;
+    uint32_t _lastTimeUs = 0;
+    volatile uint32_t _samples = 0;
+    volatile uint32_t _missedTicks = 0;
+    volatile uint32_t _jitterMaxUs = 0;
+    // written on the core of the task and read on the other one, only together under _jitterLock
+    portMUX_TYPE _jitterLock = portMUX_INITIALIZER_UNLOCKED;
+    uint64_t _jitterSumUs = 0;
+    uint32_t _jitterCount = 0;
+};
+
+#endif // end of SENSORTASK_H
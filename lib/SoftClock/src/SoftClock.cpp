@@ -0,0 +1,19 @@
+#include "SoftClock.h"
+#include <esp_timer.h>
+
+int32_t SoftClock::sync(uint32_t rtcSeconds)
+{
+  int32_t offset = _syncs ? (int32_t)(rtcSeconds - seconds()) : 0;
+  if (!_syncs || offset != 0)
+  {
+    _baseSeconds = rtcSeconds;
+    _baseUs = esp_timer_get_time();
+  }
+  _syncs++;
+  return offset;
+}
+
+uint32_t SoftClock::seconds() const
+{
+  return _baseSeconds + (uint32_t)((esp_timer_get_time() - _baseUs) / 1000000);
+}
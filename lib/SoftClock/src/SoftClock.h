@@ -0,0 +1,30 @@
+#ifndef SOFTCLOCK_H
+#define SOFTCLOCK_H
+
+#include <Arduino.h>
+
+// Wall clock between two reads of the RTC: the RTC seconds of the last sync plus the
+// esp_timer time since then. esp_timer runs from the main crystal and keeps counting
+// through light sleep, so a sync every few minutes is plenty; a deep sleep starts a
+// new boot and needs a new sync.
+//
+// The RTC only has whole seconds. A sync that agrees with the clock keeps the old
+// base, so the clock neither steps back within a second nor loses its phase.
+class SoftClock
+{
+  public:
+    // returns how far the clock was off in s, 0 for the first sync
+    int32_t sync(uint32_t rtcSeconds);
+    bool synced() const { return _syncs > 0; }
+    uint32_t syncs() const { return _syncs; }
+
+    // seconds since 2000-01-01
+    uint32_t seconds() const;
+
+  private:
+    uint32_t _baseSeconds = 0;
+    int64_t _baseUs = 0;
+    uint32_t _syncs = 0;
+};
+
+#endif // end of SOFTCLOCK_H
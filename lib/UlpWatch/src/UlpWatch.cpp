@@ -0,0 +1,100 @@
+#include "UlpWatch.h"
+
+#include <driver/rtc_io.h>
+#include <esp32/ulp.h>
+#include <esp_sleep.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_i2c_reg.h>
+#include <soc/rtc_io_reg.h>
+#include <soc/sens_reg.h>
+
+#define BMP280_REGISTER_CONTROL 0xF4
+#define BMP280_REGISTER_PRESSUREDATA 0xF7
+
+// forced mode with 1x temperature and pressure oversampling, 6.4 ms at most
+#define BMP280_FORCED_X1 0x25
+
+// one run of the program: 8.2 ms conversion delay plus three I2C transactions at 100 kHz
+#define ULP_RUN_US 10000
+
+#define LABEL_CLIMBED 0
+#define LABEL_WAKE 1
+
+bool UlpWatch::start(uint8_t address, uint16_t threshold, uint32_t periodMs, uint16_t maxChecks)
+{
+  rtc_gpio_init(sclPin);
+  rtc_gpio_set_direction(sclPin, RTC_GPIO_MODE_INPUT_ONLY);
+  rtc_gpio_init(sdaPin);
+  rtc_gpio_set_direction(sdaPin, RTC_GPIO_MODE_INPUT_ONLY);
+  // function 3 of the touch pads is the RTC I2C controller
+  REG_SET_FIELD(RTC_IO_TOUCH_PAD0_REG, RTC_IO_TOUCH_PAD0_FUN_SEL, 3);
+  REG_SET_FIELD(RTC_IO_TOUCH_PAD3_REG, RTC_IO_TOUCH_PAD3_FUN_SEL, 3);
+  REG_SET_FIELD(RTC_IO_SAR_I2C_IO_REG, RTC_IO_SAR_I2C_SCL_SEL, 0);
+  REG_SET_FIELD(RTC_IO_SAR_I2C_IO_REG, RTC_IO_SAR_I2C_SDA_SEL, 1);
+
+  // 100 kHz in cycles of the 8 MHz RTC_FAST_CLK
+  WRITE_PERI_REG(RTC_I2C_SCL_LOW_PERIOD_REG, 40);
+  WRITE_PERI_REG(RTC_I2C_SCL_HIGH_PERIOD_REG, 40);
+  WRITE_PERI_REG(RTC_I2C_SDA_DUTY_REG, 16);
+  WRITE_PERI_REG(RTC_I2C_SCL_START_PERIOD_REG, 30);
+  WRITE_PERI_REG(RTC_I2C_SCL_STOP_PERIOD_REG, 44);
+  WRITE_PERI_REG(RTC_I2C_TIMEOUT_REG, 10000);
+  REG_SET_FIELD(RTC_I2C_CTRL_REG, RTC_I2C_MS_MODE, 1);
+  REG_SET_FIELD(SENS_SAR_SLAVE_ADDR1_REG, SENS_I2C_SLAVE_ADDR0, address);
+
+  // threshold and maxChecks are immediates, R3 stays 0 as base for the data words
+  const ulp_insn_t program[] = {
+      I_MOVI(R3, 0),
+      I_I2C_WRITE(0, BMP280_REGISTER_CONTROL, BMP280_FORCED_X1),
+      I_DELAY(0xFFFF),
+      I_I2C_READ(0, BMP280_REGISTER_PRESSUREDATA),
+      I_LSHI(R1, R0, 8),
+      I_I2C_READ(0, BMP280_REGISTER_PRESSUREDATA + 1),
+      I_ORR(R0, R1, R0),
+      I_ST(R0, R3, dataOffset + RAW),
+      M_BGE(LABEL_CLIMBED, threshold),
+      I_LD(R0, R3, dataOffset + CHECKS),
+      I_ADDI(R0, R0, 1),
+      I_ST(R0, R3, dataOffset + CHECKS),
+      M_BGE(LABEL_WAKE, maxChecks),
+      I_HALT(),
+      M_LABEL(LABEL_CLIMBED),
+      I_MOVI(R1, 1),
+      I_ST(R1, R3, dataOffset + CLIMBED),
+      // the timer keeps running and wakes again until stop(), so a wakeup that comes
+      // while the main cores are still going to sleep is not lost
+      M_LABEL(LABEL_WAKE),
+      I_WAKE(),
+      I_HALT(),
+  };
+  size_t size = sizeof(program) / sizeof(ulp_insn_t);
+  if (ulp_process_macros_and_load(0, program, &size) != ESP_OK || size > dataOffset)
+  {
+    return false;
+  }
+  for (int i = 0; i < DATA_WORDS; i++)
+  {
+    RTC_SLOW_MEM[dataOffset + i] = 0;
+  }
+
+  ulp_set_wakeup_period(0, periodMs * 1000);
+  esp_sleep_enable_ulp_wakeup();
+  return ulp_run(0) == ESP_OK;
+}
+
+void UlpWatch::stop()
+{
+  if (READ_PERI_REG(RTC_CNTL_STATE0_REG) & RTC_CNTL_ULP_CP_SLP_TIMER_EN)
+  {
+    CLEAR_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN);
+    // a run that already started finishes its I2C transactions before Wire takes the pads
+    delayMicroseconds(ULP_RUN_US);
+  }
+  rtc_gpio_deinit(sclPin);
+  rtc_gpio_deinit(sdaPin);
+}
+
+uint16_t UlpWatch::data(Data index)
+{
+  return RTC_SLOW_MEM[dataOffset + index] & 0xFFFF;
+}
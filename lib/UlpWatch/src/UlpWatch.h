@@ -0,0 +1,54 @@
+#ifndef ULPWATCH_H
+#define ULPWATCH_H
+
+#include <Arduino.h>
+#include <Bmp280.h>
+#include <driver/gpio.h>
+
+// Watches one BMP280 from the ULP coprocessor while the main cores are in deep sleep.
+//
+// On every tick of the ULP timer the program starts a forced conversion over the RTC
+// I2C controller and compares the upper 16 bits of the raw pressure with a threshold
+// computed before sleeping. The raw reading rises as the pressure falls, so a reading
+// at or above the threshold is a climb and wakes the main cores. The ULP cannot
+// compensate the reading, the threshold only holds at the temperature it was computed
+// for: after maxChecks conversions the ULP wakes the main cores anyway, which check
+// the altitude properly and start a new watch.
+//
+// The RTC I2C controller only reaches the sensor on the RTC pads below, the ULP cannot
+// use the GPIO matrix.
+class UlpWatch
+{
+  public:
+    static const gpio_num_t sclPin = GPIO_NUM_4;  // TOUCH_PAD0
+    static const gpio_num_t sdaPin = GPIO_NUM_15; // TOUCH_PAD3
+
+    // words of RTC slow memory: program from 0, data behind it
+    static const uint32_t dataOffset = 96;
+
+    // threshold for the pressure the sensor has to see to wake up, in Pa, sensor read() just before
+    uint16_t threshold(const Bmp280 &sensor, float pressure) { return sensor.rawPressure(pressure) >> 4; }
+    // loads the program and starts the ULP timer, the sensor has to sleep so its IIR filter is off
+    bool start(uint8_t address, uint16_t threshold, uint32_t periodMs, uint16_t maxChecks);
+    // stops the ULP timer after any wakeup and hands the pads back to the GPIO matrix, before Wire.begin()
+    void stop();
+
+    // what the ULP saw up to the wakeup
+    bool climbed() { return data(CLIMBED) != 0; }
+    uint16_t lastRaw() { return data(RAW); }
+    uint16_t checks() { return data(CHECKS); }
+
+  private:
+    enum Data
+    {
+      RAW,
+      CHECKS,
+      CLIMBED,
+      DATA_WORDS
+    };
+
+    // the ULP only writes the lower 16 bits of a word
+    uint16_t data(Data index);
+};
+
+#endif // end of ULPWATCH_H
@@ -0,0 +1,59 @@
+#ifndef UNITS_H
+#define UNITS_H
+
+#include <math.h>
+#include <stdint.h>
+
+// The units the jumper reads, chosen at compile time: meters, or feet with -DUNITS_FEET.
+//
+// Only the display changes. The filter, the jump detector, the logbook and the track stay in
+// meters and m/s, so a logbook reads the same after a change of units, and the mode changes
+// compare in meters too (JumpModes.h). The per sample conversion is a multiply by a constant
+// that the meters build folds away.
+struct Meters
+{
+  static constexpr float perMeter = 1.0f;
+  static constexpr int32_t altitudeStep = 1;      // the displayed altitude is a multiple of it
+  static constexpr int32_t freefallDivisor = 1;   // the freefall digits show the altitude divided by it
+  static constexpr uint8_t freefallDecimals = 0;  // of those digits after the decimal point
+  static constexpr float ratePerMetersPerSecond = 1.0f;
+  static constexpr int32_t targetAltitude = 4000; // the airplane screen counts down to it
+  static constexpr const char *altitudeSymbol = "m";
+  static constexpr const char *rateSymbol = "m/s";
+  static constexpr const char *targetLabel = "4km";
+};
+
+struct Feet
+{
+  static constexpr float perMeter = 1 / 0.3048f;
+  static constexpr int32_t altitudeStep = 10;
+  static constexpr int32_t freefallDivisor = 100;               // thousands with one decimal like feet altimeters, 13500 ft shows as 13.5
+  static constexpr uint8_t freefallDecimals = 1;
+  static constexpr float ratePerMetersPerSecond = 60 / 0.3048f; // ft/min like the vertical speed indicator of the plane
+  static constexpr int32_t targetAltitude = 13500;
+  static constexpr const char *altitudeSymbol = "ft";
+  static constexpr const char *rateSymbol = "ft/min";
+  static constexpr const char *targetLabel = "13.5k";
+};
+
+template <typename Unit>
+struct Units : Unit
+{
+  // the displayed altitude, rounded to altitudeStep
+  static int32_t altitude(float meters) { return lroundf(meters * (Unit::perMeter / Unit::altitudeStep)) * Unit::altitudeStep; }
+  static int32_t freefallAltitude(int32_t altitude)
+  {
+    return Unit::freefallDivisor == 1 ? altitude : (altitude + (altitude < 0 ? -1 : 1) * Unit::freefallDivisor / 2) / Unit::freefallDivisor;
+  }
+  static int32_t rate(float metersPerSecond) { return lroundf(metersPerSecond * Unit::ratePerMetersPerSecond); }
+  // back to meters, for the time to the target altitude
+  static constexpr float toMeters(int32_t value) { return value / Unit::perMeter; }
+};
+
+#ifdef UNITS_FEET
+typedef Units<Feet> DisplayUnits;
+#else
+typedef Units<Meters> DisplayUnits;
+#endif
+
+#endif // end of UNITS_H
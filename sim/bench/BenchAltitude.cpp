@@ -0,0 +1,34 @@
+#include "Benchmark.h"
+
+#include <BaroAltitude.h>
+#include <math.h>
+
+// pressure to altitude: lookup table against the pow() formula of Adafruit_BMP280::readAltitude()
+void benchAltitude()
+{
+  const uint32_t iterations = 4000000;
+  const float referencePressure = 101325;
+  // 300 to 1100 hPa, stepped so consecutive samples hit different table segments
+  auto pressure = [](uint32_t i) { return 30000.0f + (i * 7919u % 80000u); };
+
+  double powNs = measureNs(iterations, [&](uint32_t i) { return BaroAltitude::fromRatioExact(pressure(i) / referencePressure); });
+  double tableNs = measureNs(iterations, [&](uint32_t i) { return BaroAltitude::fromPressure(pressure(i), referencePressure); });
+
+  double maxError = 0;
+  for (float p = 30000; p <= 110000; p += 0.25f)
+  {
+    double exact = 44330 * (1 - pow(p / (double)referencePressure, 0.1903));
+    double error = fabs(BaroAltitude::fromPressure(p, referencePressure) - exact);
+    maxError = error > maxError ? error : maxError;
+  }
+
+  printf("pow():        %6.2f ns/sample\n", powNs);
+  printf("lookup table: %6.2f ns/sample (%.1fx faster)\n", tableNs, powNs / tableNs);
+  printf("max error 300-1100 hPa: %.3f m\n", maxError);
+  // the bound BaroAltitude.h gives for the whole table
+  if (maxError >= 0.16)
+  {
+    printf("FAIL: the lookup table is off by more than 0.16 m\n");
+    benchmarkFailures++;
+  }
+}
@@ -0,0 +1,171 @@
+#include "Benchmark.h"
+
+#include "SyntheticJump.h"
+
+#include <AltitudeFilter.h>
+#include <JumpDetector.h>
+#include <JumpModes.h>
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+// exit, deployment and landing detection replayed over a corpus of synthetic jumps with known
+// event times, for the rule table of JumpDetector against the fixed thresholds it replaced
+
+namespace
+{
+  const uint32_t jumps = 300;
+
+  // detection delay in ms of the default rules: the earliest may not be earlier, median and 99th
+  // percentile not later. A landing can be found in the flare, an exit or deployment never before it.
+  // The corpus is seeded, so these are the current results plus about 7%: a change of the rules, the
+  // filter or the sensor profiles that detects later fails here. Lower them when it detects earlier.
+  const float budgetMs[JumpDetector::EVENT_TYPES][3] = {{0, 0, 0}, {0, 1620, 1990}, {0, 830, 2000}, {-2800, 660, 7950}};
+
+  // the thresholds of the mode functions before the detector: speed and altitude only, no hold time
+  const JumpDetector::Rule legacyRules[] = {
+      {JumpDetector::AIRCRAFT, JumpDetector::FREEFALL, JumpDetector::EXIT, -INFINITY, -15.5f, -INFINITY, INFINITY, INFINITY, 0},
+      {JumpDetector::FREEFALL, JumpDetector::CANOPY, JumpDetector::DEPLOYMENT, -14.5f, INFINITY, -INFINITY, INFINITY, INFINITY, 0},
+      {JumpDetector::CANOPY, JumpDetector::LANDED, JumpDetector::LANDING, -INFINITY, INFINITY, -INFINITY, INFINITY, 3.5f, 0},
+  };
+
+  const char *eventNames[] = {"", "exit", "deployment", "landing"};
+
+  struct Jump : SyntheticJump
+  {
+    JumpProfile profile;
+  };
+
+  struct Results
+  {
+    std::vector<float> delayMs[JumpDetector::EVENT_TYPES];
+    std::vector<float> onsetMs[JumpDetector::EVENT_TYPES];
+    uint32_t missed[JumpDetector::EVENT_TYPES];
+    uint32_t unexpected[JumpDetector::EVENT_TYPES];
+    double updateNs;
+    uint64_t updates;
+  };
+
+  // samples at the rate of the phase the detector is in, through the sensor IIR and the Kalman filter
+  void replay(const Jump &jump, const JumpDetector::Rule *rules, uint8_t count, uint32_t seed, Results &results)
+  {
+    std::mt19937 random(seed);
+    std::normal_distribution<float> noise(0, jump.profile.noiseM);
+    JumpDetector detector(rules, count);
+    AltitudeFilter filter;
+    double endS = jump.durationS();
+    float sensor = jump.at(0);
+    uint32_t timeUs = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (timeUs / 1e6 < endS)
+    {
+      const SensorProfile &profile = sensorProfiles[jumpMode(detector.phase())];
+      sensor += (jump.at(timeUs / 1e6) + noise(random) - sensor) / profile.filterCoefficient();
+      filter.update(sensor, timeUs);
+      detector.update(filter.altitude(), filter.verticalSpeed(), filter.acceleration(), timeUs);
+      results.updates++;
+      timeUs += profile.samplePeriod * 1000;
+    }
+    auto end = std::chrono::steady_clock::now();
+    results.updateNs += std::chrono::duration<double, std::nano>(end - start).count();
+
+    for (uint8_t type = JumpDetector::EXIT; type < JumpDetector::EVENT_TYPES; type++)
+    {
+      const JumpDetector::Event &event = detector.event((JumpDetector::EventType)type);
+      bool detected = event.type != JumpDetector::NONE;
+      bool real = jump.eventS[type] >= 0;
+      if (detected && real)
+      {
+        results.delayMs[type].push_back(event.detectedUs / 1e3 - jump.eventS[type] * 1e3);
+        results.onsetMs[type].push_back(event.onsetUs / 1e3 - jump.eventS[type] * 1e3);
+      }
+      else if (real)
+      {
+        results.missed[type]++;
+      }
+      else if (detected)
+      {
+        results.unexpected[type]++;
+      }
+    }
+  }
+
+  float percentile(std::vector<float> values, float share)
+  {
+    if (values.empty())
+    {
+      return NAN;
+    }
+    std::sort(values.begin(), values.end());
+    size_t i = share > 0 ? ceilf(share * values.size()) - 1 : 0;
+    return values[std::min(i, values.size() - 1)];
+  }
+
+  Results run(const std::vector<Jump> &corpus, const JumpDetector::Rule *rules, uint8_t count)
+  {
+    Results results = {};
+    for (uint32_t i = 0; i < corpus.size(); i++)
+    {
+      replay(corpus[i], rules, count, 1000 + i, results);
+    }
+    return results;
+  }
+
+  void print(const char *name, const Results &results)
+  {
+    printf("%s: %.1f ns/update\n", name, results.updateNs / results.updates);
+    for (uint8_t type = JumpDetector::EXIT; type < JumpDetector::EVENT_TYPES; type++)
+    {
+      printf("  %-10s delay earliest %6.0f ms, median %6.0f ms, p99 %6.0f ms, onset median %6.0f ms, p99 %6.0f ms, %u missed, %u unexpected\n",
+             eventNames[type], percentile(results.delayMs[type], 0), percentile(results.delayMs[type], 0.5f),
+             percentile(results.delayMs[type], 0.99f),
+             percentile(results.onsetMs[type], 0.5f), percentile(results.onsetMs[type], 0.99f), results.missed[type],
+             results.unexpected[type]);
+      BenchmarkRecord("detector", (std::string(name) + " " + eventNames[type]).c_str())
+          .add("ns_per_update", results.updateNs / results.updates)
+          .add("delay_earliest_ms", percentile(results.delayMs[type], 0))
+          .add("delay_median_ms", percentile(results.delayMs[type], 0.5f))
+          .add("delay_p99_ms", percentile(results.delayMs[type], 0.99f))
+          .add("missed", results.missed[type])
+          .add("unexpected", results.unexpected[type]);
+    }
+  }
+}
+
+void benchDetector()
+{
+  std::mt19937 random(7);
+  std::vector<Jump> corpus;
+  uint32_t rideDowns = 0;
+  for (uint32_t i = 0; i < jumps; i++)
+  {
+    bool rideDown = i % 10 == 9;
+    rideDowns += rideDown;
+    Jump jump;
+    jump.profile = randomJumpProfile(random, rideDown);
+    static_cast<SyntheticJump &>(jump) = generateJump(jump.profile, random);
+    corpus.push_back(jump);
+  }
+  printf("corpus: %u jumps, %u of them riding the plane down\n", jumps, rideDowns);
+
+  Results legacy = run(corpus, legacyRules, sizeof(legacyRules) / sizeof(legacyRules[0]));
+  Results rules = run(corpus, JumpDetector::defaultRules, JumpDetector::defaultRuleCount);
+  print("fixed thresholds", legacy);
+  print("rule table", rules);
+
+  // the regression check of the default rules: no event may be missed, appear out of place or come too early
+  for (uint8_t type = JumpDetector::EXIT; type < JumpDetector::EVENT_TYPES; type++)
+  {
+    float earliest = percentile(rules.delayMs[type], 0);
+    float median = percentile(rules.delayMs[type], 0.5f);
+    float p99 = percentile(rules.delayMs[type], 0.99f);
+    const float *budget = budgetMs[type];
+    if (rules.missed[type] || rules.unexpected[type] || !(earliest >= budget[0]) || !(median <= budget[1]) || !(p99 <= budget[2]))
+    {
+      printf("FAIL %s: earliest %.0f ms, median %.0f ms, p99 %.0f ms against the budget of %.0f / %.0f / %.0f ms, or missed or unexpected events\n",
+             eventNames[type], earliest, median, p99, budget[0], budget[1], budget[2]);
+      benchmarkFailures++;
+    }
+  }
+}
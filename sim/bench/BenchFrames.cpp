@@ -0,0 +1,100 @@
+#include "Benchmark.h"
+
+#include <DoubleBuffer.h>
+#include <atomic>
+#include <thread>
+
+// the hand-over of RenderTask: mode logic publishing on one core while the render task reads on the
+// other, here as two host threads. Every value carries a checksum over its fields, a torn read shows
+// up as a mismatch.
+
+namespace
+{
+  // the size of the FrameState of main.cpp
+  struct Frame
+  {
+    uint32_t sequence;
+    int32_t values[8];
+    uint32_t checksum;
+  };
+
+  uint32_t checksum(const Frame &frame)
+  {
+    uint32_t sum = frame.sequence * 2654435761u;
+    for (int32_t value : frame.values)
+    {
+      sum = (sum ^ (uint32_t)value) * 16777619u;
+    }
+    return sum;
+  }
+
+  // writes as fast as it can with pauseNs between two, so the reader copies while the other slot is written
+  void run(const char *name, uint32_t writes, uint32_t pauseNs)
+  {
+    DoubleBuffer<Frame> buffer;
+    std::atomic<bool> done{false};
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    uint32_t outOfOrder = 0;
+
+    std::thread reader([&] {
+      Frame frame;
+      uint32_t last = 0;
+      while (!done.load() || buffer.pending())
+      {
+        if (!buffer.read(frame))
+        {
+          continue;
+        }
+        reads++;
+        torn += frame.checksum != checksum(frame);
+        outOfOrder += frame.sequence <= last;
+        last = frame.sequence;
+      }
+    });
+
+    double writeNs = 0;
+    for (uint32_t i = 1; i <= writes; i++)
+    {
+      Frame frame;
+      frame.sequence = i;
+      for (int32_t v = 0; v < 8; v++)
+      {
+        frame.values[v] = i * 31 + v;
+      }
+      frame.checksum = checksum(frame);
+      auto start = std::chrono::steady_clock::now();
+      buffer.write(frame);
+      auto end = std::chrono::steady_clock::now();
+      writeNs += std::chrono::duration<double, std::nano>(end - start).count();
+      while (std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - end).count() < pauseNs)
+      {
+      }
+    }
+    writeNs /= writes;
+    done.store(true);
+    reader.join();
+
+    printf("%-9s %u writes at %.1f ns each, %u read, %u skipped, %u torn, %u out of order\n", name, writes, writeNs, reads,
+           buffer.skipped(), torn, outOfOrder);
+    BenchmarkRecord("frames", name)
+        .add("write_ns", writeNs)
+        .add("reads", reads)
+        .add("skipped", buffer.skipped())
+        .add("torn", torn)
+        .add("out_of_order", outOfOrder);
+    // every write is either read or skipped, none twice
+    if (torn || outOfOrder || reads + buffer.skipped() != writes)
+    {
+      printf("FAIL %s: the reader saw a half written or repeated frame\n", name);
+      benchmarkFailures++;
+    }
+  }
+}
+
+void benchFrames()
+{
+  // the writer far ahead of the reader, then about as fast as it
+  run("flat out", 2000000, 0);
+  run("paced", 200000, 500);
+}
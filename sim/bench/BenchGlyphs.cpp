@@ -0,0 +1,89 @@
+#include "Benchmark.h"
+
+#include <GlyphCache.h>
+#include <U8g2lib.h>
+
+namespace
+{
+  // every altitude the display can show has to give the same pixels and the same x after the last glyph
+  // both ways, also clipped at the edges. Without begin() the cache hands the digits to U8g2.
+  uint32_t differentFrames(const uint8_t *font, int16_t baseline, int16_t x, bool cached, uint32_t &frames, uint8_t decimals = 0)
+  {
+    char text[16];
+    U8G2 display;
+    GlyphCache cache(font, baseline);
+    static uint8_t expected[128 * 8];
+    uint32_t different = 0;
+
+    if (cached && !cache.begin(display))
+    {
+      printf("glyph cache: begin() failed\n");
+      return 1;
+    }
+    for (long value = -999; value <= 9999; value++, frames++)
+    {
+      display.clearBuffer();
+      display.setFont(font);
+      display.setCursor(x, baseline);
+      if (decimals)
+      {
+        // thousands of feet with one decimal
+        snprintf(text, sizeof(text), "%s%ld.%ld", value < 0 ? "-" : "", labs(value) / 10, labs(value) % 10);
+        display.print(text);
+      }
+      else
+      {
+        display.print(value);
+      }
+      int16_t end = display.getCursorX();
+      memcpy(expected, display.getBufferPtr(), sizeof(expected));
+      display.clearBuffer();
+      different += cache.print(display, x, value, decimals) != end || memcmp(expected, display.getBufferPtr(), sizeof(expected)) != 0;
+    }
+    return different;
+  }
+}
+
+// freefall frame: large digits through the U8g2 font path against the glyph cache
+void benchGlyphs()
+{
+  const uint32_t iterations = 200000;
+  U8G2 display;
+  GlyphCache cache(u8g2_font_logisoso62_tn, 64);
+  cache.begin(display);
+  auto altitude = [](uint32_t i) { return 4000 - (long)(i % 4100); };
+
+  double fontNs = measureNs(iterations, [&](uint32_t i) {
+    display.clearBuffer();
+    display.setFontDirection(0);
+    display.setFont(u8g2_font_logisoso62_tn);
+    display.setCursor(0, 64);
+    display.print(altitude(i));
+    return (float)display.getBufferPtr()[300];
+  });
+  double cacheNs = measureNs(iterations, [&](uint32_t i) {
+    display.clearBuffer();
+    cache.print(display, 0, altitude(i));
+    return (float)display.getBufferPtr()[300];
+  });
+
+  // the fonts of main.cpp, and an oblique one with pixels left of the cursor and past the advance
+  uint32_t frames = 0;
+  uint32_t different = differentFrames(u8g2_font_logisoso62_tn, 64, 0, true, frames);
+  different += differentFrames(u8g2_font_logisoso50_tn, 51, 0, true, frames);
+  different += differentFrames(u8g2_font_helvBO24_tn, 40, 0, true, frames);
+  different += differentFrames(u8g2_font_helvBO24_tn, 40, -7, true, frames);
+  different += differentFrames(u8g2_font_helvBO24_tn, 40, 70, true, frames);
+  different += differentFrames(u8g2_font_logisoso62_tn, 64, 0, false, frames);
+  different += differentFrames(u8g2_font_logisoso62_tn, 64, 0, true, frames, 1);
+  different += differentFrames(u8g2_font_logisoso62_tn, 64, 0, false, frames, 1);
+
+  printf("U8g2 font:   %8.1f ns/frame\n", fontNs);
+  printf("glyph cache: %8.1f ns/frame (%.1fx faster)\n", cacheNs, fontNs / cacheNs);
+  printf("frames that differ: %u of %u\n", different, frames);
+  if (different)
+  {
+    printf("FAIL: the glyph cache draws other pixels than the font\n");
+    benchmarkFailures++;
+  }
+}
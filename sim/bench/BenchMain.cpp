@@ -0,0 +1,113 @@
+#include "Benchmark.h"
+
+#include <math.h>
+#include <string.h>
+
+volatile float benchmarkSink;
+int benchmarkFailures = 0;
+
+namespace
+{
+  FILE *jsonFile = nullptr;
+}
+
+struct BenchmarkEntry
+{
+  const char *name;
+  void (*run)();
+};
+
+static const BenchmarkEntry benchmarks[] = {
+    {"altitude", benchAltitude},
+    {"track", benchTrack},
+    {"glyphs", benchGlyphs},
+    {"detector", benchDetector},
+    {"pipeline", benchPipeline},
+    {"units", benchUnits},
+    {"frames", benchFrames},
+};
+
+BenchmarkRecord::BenchmarkRecord(const char *benchmark, const char *name)
+{
+  _line = "{";
+  add("benchmark", benchmark);
+  add("name", name);
+}
+
+BenchmarkRecord::~BenchmarkRecord()
+{
+  if (jsonFile)
+  {
+    fprintf(jsonFile, "%s}\n", _line.c_str());
+  }
+}
+
+BenchmarkRecord &BenchmarkRecord::add(const char *key, double value)
+{
+  char number[32] = "null";
+  if (isfinite(value))
+  {
+    snprintf(number, sizeof(number), "%.6g", value);
+  }
+  _line += _line.size() > 1 ? ", \"" : "\"";
+  _line += key;
+  _line += "\": ";
+  _line += number;
+  return *this;
+}
+
+BenchmarkRecord &BenchmarkRecord::add(const char *key, const char *value)
+{
+  // names only, nothing that needs escaping
+  _line += _line.size() > 1 ? ", \"" : "\"";
+  _line += key;
+  _line += "\": \"";
+  _line += value;
+  _line += "\"";
+  return *this;
+}
+
+int main(int argc, char **argv)
+{
+  const char *only = nullptr;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+    {
+      jsonFile = fopen(argv[++i], "w");
+      if (!jsonFile)
+      {
+        fprintf(stderr, "cannot write %s\n", argv[i]);
+        return 2;
+      }
+    }
+    else if (strcmp(argv[i], "--write-corpus") == 0 && i + 1 < argc)
+    {
+      return writeCorpus(argv[++i]) ? 0 : 2;
+    }
+    else if (argv[i][0] != '-' && !only)
+    {
+      only = argv[i];
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--json <file>] [--write-corpus <dir>] [altitude|track|glyphs|detector|pipeline|units|frames]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  for (const BenchmarkEntry &benchmark : benchmarks)
+  {
+    if (only && strcmp(only, benchmark.name) != 0)
+    {
+      continue;
+    }
+    printf("== %s\n", benchmark.name);
+    benchmark.run();
+  }
+  if (jsonFile)
+  {
+    fclose(jsonFile);
+  }
+  return benchmarkFailures ? 1 : 0;
+}
@@ -0,0 +1,312 @@
+#include "Benchmark.h"
+
+#include <AltitudeFilter.h>
+#include <BaroAltitude.h>
+#include <JumpDetector.h>
+#include <JumpModes.h>
+#include <SensorFusion.h>
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <math.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// the altitude pipeline of main.cpp, from the two pressure readings through updateAltitude() to the
+// mode changes, replayed over the recorded traces of sim/traces: throughput, state size and how well
+// every trace's exit, deployment and landing are found
+
+namespace
+{
+  const char *traceDirectory = "sim/traces";
+  const uint32_t rounds = 50;
+
+  const char *eventNames[] = {"", "exit", "deployment", "landing"};
+
+  struct TracePoint
+  {
+    uint32_t timeMs;
+    float pressure[SensorFusion::sensors];
+  };
+
+  struct Trace
+  {
+    std::string name;
+    std::vector<TracePoint> points;
+    double eventMs[JumpDetector::EVENT_TYPES]; // negative if the trace has none
+
+    // linear interpolation like the simulator
+    float pressure(uint8_t sensor, uint32_t timeMs, size_t &cursor) const
+    {
+      while (cursor + 2 < points.size() && points[cursor + 1].timeMs <= timeMs)
+      {
+        cursor++;
+      }
+      const TracePoint &a = points[cursor];
+      const TracePoint &b = points[cursor + 1];
+      float t = timeMs <= a.timeMs ? 0 : timeMs >= b.timeMs ? 1 : (float)(timeMs - a.timeMs) / (b.timeMs - a.timeMs);
+      return a.pressure[sensor] + (b.pressure[sensor] - a.pressure[sensor]) * t;
+    }
+  };
+
+  // what the sensor task hands to updateAltitude()
+  struct Sample
+  {
+    uint32_t timeUs;
+    float pressure[SensorFusion::sensors];
+  };
+
+  // updateAltitude() and the mode changes of the mode functions
+  struct Pipeline
+  {
+    float reference[SensorFusion::sensors];
+    SensorFusion fusion;
+    AltitudeFilter filter;
+    JumpDetector detector;
+    uint8_t mode = MODE_GROUND;
+    uint32_t groundSinceUs = 0; // last sample in the plane or under canopy
+    bool asleep = false; // every sample is a wakeup from deep sleep
+
+    Pipeline(const Sample &first) : reference{first.pressure[0], first.pressure[1]} {}
+
+    void update(const Sample &sample)
+    {
+      // setup() after a wakeup, the reference pressures survive in RTC memory
+      if (asleep)
+      {
+        fusion.reset();
+        filter.reset();
+      }
+      float altitude1 = BaroAltitude::fromPressure(sample.pressure[0], reference[0]);
+      float altitude2 = BaroAltitude::fromPressure(sample.pressure[1], reference[1]);
+      filter.update(fusion.update(altitude1, altitude2), sample.timeUs);
+      if (mode <= MODE_AIRPLANE)
+      {
+        detector.update(filter.altitude(), filter.verticalSpeed(), filter.acceleration(), sample.timeUs);
+      }
+
+      uint8_t next = nextMode(mode, detector, filter.altitude());
+      if (mode == MODE_AIRPLANE || mode == MODE_CANOPY)
+      {
+        groundSinceUs = sample.timeUs;
+      }
+      else if (mode == MODE_GROUND && next == MODE_AIRPLANE)
+      {
+        asleep = false;
+        detector.reset();
+      }
+      else if (mode == MODE_GROUND && sample.timeUs - groundSinceUs >= sleepTime * 1000000)
+      {
+        asleep = true;
+      }
+      mode = next;
+    }
+  };
+
+  bool loadTrace(const std::string &path, Trace &trace)
+  {
+    std::ifstream file(path);
+    std::string line;
+    std::fill(trace.eventMs, trace.eventMs + JumpDetector::EVENT_TYPES, -1);
+    while (std::getline(file, line))
+    {
+      char name[32];
+      double timeMs;
+      TracePoint point;
+      if (sscanf(line.c_str(), "# event,%31[^,],%lf", name, &timeMs) == 2)
+      {
+        for (uint8_t type = JumpDetector::EXIT; type < JumpDetector::EVENT_TYPES; type++)
+        {
+          trace.eventMs[type] = strcmp(name, eventNames[type]) == 0 ? timeMs : trace.eventMs[type];
+        }
+      }
+      else if (!line.empty() && line[0] != '#' && sscanf(line.c_str(), "%lf,%f,%f", &timeMs, &point.pressure[0], &point.pressure[1]) == 3)
+      {
+        point.timeMs = timeMs;
+        trace.points.push_back(point);
+      }
+    }
+    return trace.points.size() > 1;
+  }
+
+  std::vector<Trace> loadTraces()
+  {
+    std::vector<std::string> paths;
+    if (DIR *directory = opendir(traceDirectory))
+    {
+      while (dirent *entry = readdir(directory))
+      {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".csv") == 0)
+        {
+          paths.push_back(name);
+        }
+      }
+      closedir(directory);
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Trace> traces;
+    for (const std::string &name : paths)
+    {
+      Trace trace;
+      trace.name = name.substr(0, name.size() - 4);
+      if (loadTrace(std::string(traceDirectory) + "/" + name, trace))
+      {
+        traces.push_back(trace);
+      }
+    }
+    return traces;
+  }
+
+  // the samples of the sensor task: the BMP280 IIR over the trace at the rate of the mode the pipeline is
+  // in, and one forced conversion per wakeup while it sleeps on the ground
+  std::vector<Sample> sampleTrace(const Trace &trace)
+  {
+    std::vector<Sample> samples;
+    size_t cursor = 0;
+    Sample sample = {0, {trace.points[0].pressure[0], trace.points[0].pressure[1]}};
+    Pipeline pipeline(sample);
+    uint32_t endMs = trace.points.back().timeMs;
+    for (uint32_t timeMs = 0; timeMs <= endMs; timeMs += pipeline.asleep ? sleepForTime * 1000 : sensorProfiles[pipeline.mode].samplePeriod)
+    {
+      const SensorProfile &profile = sensorProfiles[pipeline.mode];
+      sample.timeUs = timeMs * 1000;
+      for (uint8_t i = 0; i < SensorFusion::sensors; i++)
+      {
+        float pressure = trace.pressure(i, timeMs, cursor);
+        sample.pressure[i] = pipeline.asleep ? pressure : sample.pressure[i] + (pressure - sample.pressure[i]) / profile.filterCoefficient();
+      }
+      samples.push_back(sample);
+      pipeline.update(sample);
+    }
+    return samples;
+  }
+
+  uint64_t cycles()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  struct Timing
+  {
+    double ns;
+    uint64_t cycles;
+  };
+
+  // the pipeline alone, from fresh state like after a boot, over samples recorded beforehand
+  Timing measure(const std::vector<Sample> &samples, Pipeline &last)
+  {
+    Timing timing = {};
+    float sum = 0;
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+      Pipeline pipeline(samples[0]);
+      auto start = std::chrono::steady_clock::now();
+      uint64_t startCycles = cycles();
+      for (const Sample &sample : samples)
+      {
+        pipeline.update(sample);
+      }
+      timing.cycles += cycles() - startCycles;
+      timing.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      sum += pipeline.filter.altitude();
+      last = pipeline;
+    }
+    benchmarkSink = sum;
+    return timing;
+  }
+}
+
+void benchPipeline()
+{
+  std::vector<Trace> traces = loadTraces();
+  if (traces.empty())
+  {
+    printf("FAIL no traces in %s, run from the repository root\n", traceDirectory);
+    benchmarkFailures++;
+    return;
+  }
+
+  printf("%-20s %7s %10s %11s %13s %13s %13s\n", "trace", "samples", "ns/sample", "cyc/sample", "exit", "deployment", "landing");
+  uint64_t totalSamples = 0;
+  double totalNs = 0;
+  uint64_t totalCycles = 0;
+  uint32_t failures = 0;
+  for (const Trace &trace : traces)
+  {
+    std::vector<Sample> samples = sampleTrace(trace);
+    Pipeline pipeline(samples[0]);
+    Timing timing = measure(samples, pipeline);
+    uint64_t updates = (uint64_t)samples.size() * rounds;
+    totalSamples += updates;
+    totalNs += timing.ns;
+    totalCycles += timing.cycles;
+
+    BenchmarkRecord record("pipeline", trace.name.c_str());
+    record.add("samples", samples.size()).add("ns_per_sample", timing.ns / updates).add("cycles_per_sample", timing.cycles ? (double)timing.cycles / updates : NAN);
+    printf("%-20s %7zu %10.1f %11.0f", trace.name.c_str(), samples.size(), timing.ns / updates, (double)timing.cycles / updates);
+
+    // detection delay against the true time of the trace, or what went wrong
+    for (uint8_t type = JumpDetector::EXIT; type < JumpDetector::EVENT_TYPES; type++)
+    {
+      const JumpDetector::Event &event = pipeline.detector.event((JumpDetector::EventType)type);
+      bool detected = event.type != JumpDetector::NONE;
+      bool real = trace.eventMs[type] >= 0;
+      std::string key = eventNames[type];
+      if (detected && real)
+      {
+        double delayMs = event.detectedUs / 1e3 - trace.eventMs[type];
+        printf(" %10.0f ms", delayMs);
+        record.add((key + "_delay_ms").c_str(), delayMs).add((key + "_onset_ms").c_str(), event.onsetUs / 1e3 - trace.eventMs[type]);
+      }
+      else if (detected || real)
+      {
+        printf(" %13s", detected ? "UNEXPECTED" : "MISSED");
+        record.add((key + "_delay_ms").c_str(), NAN).add((key + "_error").c_str(), detected ? "unexpected" : "missed");
+        failures++;
+      }
+      else
+      {
+        printf(" %13s", "-");
+      }
+    }
+    if (pipeline.mode != MODE_GROUND)
+    {
+      printf("  ends in mode %u", pipeline.mode);
+      failures++;
+    }
+    record.add("faults_sensor1", pipeline.fusion.stats(0).excludedSamples).add("faults_sensor2", pipeline.fusion.stats(1).excludedSamples);
+    printf("\n");
+  }
+
+  // the state the firmware keeps for the pipeline, and what this process needed at its peak
+  size_t stateBytes = sizeof(SensorFusion) + sizeof(AltitudeFilter) + sizeof(JumpDetector);
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double samplesPerS = totalSamples / (totalNs / 1e9);
+  double cyclesPerSample = totalCycles ? (double)totalCycles / totalSamples : NAN;
+  printf("all traces: %.2f M samples/s, %.0f TSC cycles/sample, %zu bytes of state, %ld KB peak RSS, %u failures\n", samplesPerS / 1e6,
+         cyclesPerSample, stateBytes, usage.ru_maxrss, failures);
+  BenchmarkRecord("pipeline", "all")
+      .add("traces", traces.size())
+      .add("samples_per_s", samplesPerS)
+      .add("cycles_per_sample", cyclesPerSample)
+      .add("state_bytes", stateBytes)
+      .add("peak_rss_kb", usage.ru_maxrss)
+      .add("failures", failures);
+
+  if (failures)
+  {
+    printf("FAIL %u missed or unexpected events or traces that did not end on the ground\n", failures);
+    benchmarkFailures++;
+  }
+}
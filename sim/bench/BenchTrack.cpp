@@ -0,0 +1,77 @@
+#include "Benchmark.h"
+
+#include <AltitudeFilter.h>
+#include <TrackCodec.h>
+#include <random>
+#include <vector>
+
+// track encoding of a filtered jump: encode and decode speed, size and an exact round trip
+void benchTrack()
+{
+  // 60 s freefall at 25 Hz from 4000 m, then canopy at 10 Hz until landing
+  std::vector<TrackSample> samples;
+  std::mt19937 random(1);
+  std::normal_distribution<float> noise(0, 0.4f);
+  AltitudeFilter filter;
+  uint32_t timeUs = 0;
+  float altitude = 4000;
+  while (altitude > 0)
+  {
+    bool freefall = timeUs < 60000000;
+    uint32_t periodUs = freefall ? 40000 : 100000;
+    altitude -= (freefall ? 55.0f : 5.0f) * periodUs / 1e6f;
+    filter.update(altitude + noise(random), timeUs);
+    samples.push_back({timeUs / 1000, (int32_t)lroundf(filter.altitude() * 10), (int32_t)lroundf(filter.verticalSpeed() * 10)});
+    timeUs += periodUs;
+  }
+
+  std::vector<uint8_t> buffer(samples.size() * TrackEncoder::maxSampleSize);
+  TrackEncoder encoder(buffer.data(), buffer.size());
+  const uint32_t rounds = 200;
+
+  double encodeNs = measureNs(rounds, [&](uint32_t) {
+    encoder.reset();
+    for (const TrackSample &sample : samples)
+    {
+      encoder.add(sample);
+    }
+    return (float)encoder.length();
+  }) / samples.size();
+
+  double decodeNs = measureNs(rounds, [&](uint32_t) {
+    TrackDecoder decoder(buffer.data(), encoder.length());
+    TrackSample sample;
+    float sum = 0;
+    while (decoder.next(sample))
+    {
+      sum += sample.altitude;
+    }
+    return sum;
+  }) / samples.size();
+
+  uint32_t mismatches = 0;
+  uint32_t decoded = 0;
+  TrackDecoder decoder(buffer.data(), encoder.length());
+  TrackSample sample;
+  while (decoder.next(sample))
+  {
+    const TrackSample &original = samples[decoded++];
+    if (sample.timeMs != original.timeMs || sample.altitude != original.altitude || sample.verticalSpeed != original.verticalSpeed)
+    {
+      mismatches++;
+    }
+  }
+
+  printf("samples:  %zu, %.1f s\n", samples.size(), samples.back().timeMs / 1000.0);
+  printf("encoded:  %zu bytes, %.2f bytes/sample (raw %zu bytes)\n", encoder.length(), (double)encoder.length() / samples.size(),
+         samples.size() * sizeof(TrackSample));
+  printf("encode:   %6.2f ns/sample\n", encodeNs);
+  printf("decode:   %6.2f ns/sample\n", decodeNs);
+  printf("round trip: %u of %zu samples decoded, %u mismatches\n", decoded, samples.size(), mismatches);
+  // the decoder reproduces the samples exactly
+  if (mismatches || decoded != samples.size())
+  {
+    printf("FAIL: the track does not decode to the samples that were encoded\n");
+    benchmarkFailures++;
+  }
+}
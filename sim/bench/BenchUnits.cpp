@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+
+#include <Units.h>
+#include <math.h>
+
+// both unit policies of Units.h in one build: the rounding of the displayed altitude and climb
+// rate, and the per sample cost against the runtime switch of prototype_main.cpp
+
+namespace
+{
+  // the prototype decided per sample
+  volatile bool feet = true;
+  volatile float feetFactor = 0.3048f;
+
+  // largest difference between the displayed and the exact value over the range of a jump
+  template <typename U>
+  double maxAltitudeError()
+  {
+    double maxError = 0;
+    for (float meters = -100; meters <= 5000; meters += 0.01f)
+    {
+      double error = fabs(U::altitude(meters) - meters * (double)U::perMeter);
+      maxError = error > maxError ? error : maxError;
+    }
+    return maxError;
+  }
+
+  template <typename U>
+  double maxRateError()
+  {
+    double maxError = 0;
+    for (float speed = -80; speed <= 20; speed += 0.001f)
+    {
+      double error = fabs(U::rate(speed) - speed * (double)U::ratePerMetersPerSecond);
+      maxError = error > maxError ? error : maxError;
+    }
+    return maxError;
+  }
+
+  template <typename U>
+  void check(const char *name)
+  {
+    double altitudeError = maxAltitudeError<U>();
+    double rateError = maxRateError<U>();
+    int32_t freefall = U::freefallAltitude(U::altitude(4000));
+    double shown = freefall / pow(10, U::freefallDecimals);
+    printf("%-6s altitude max error %.3f %s (step %d), rate max error %.3f %s, 4000 m in freefall shows %.*f\n", name, altitudeError,
+           U::altitudeSymbol, U::altitudeStep, rateError, U::rateSymbol, U::freefallDecimals, shown);
+    BenchmarkRecord("units", name).add("altitude_max_error", altitudeError).add("rate_max_error", rateError).add("freefall_4000m", shown);
+    // rounding to the nearest step, with the float error of a multiply on top
+    if (altitudeError > U::altitudeStep / 2.0 + 0.01 || rateError > 0.5 + 0.01 || freefall > 9999 || freefall < 1000 / U::freefallDivisor)
+    {
+      printf("FAIL %s: rounding or freefall digits out of range\n", name);
+      benchmarkFailures++;
+    }
+  }
+}
+
+void benchUnits()
+{
+  const uint32_t iterations = 4000000;
+  auto altitude = [](uint32_t i) { return (float)(i % 50000) * 0.1f - 100; };
+
+  double runtimeNs = measureNs(iterations, [&](uint32_t i) { return (float)(int)roundf(feet ? altitude(i) / feetFactor : altitude(i)); });
+  double metersNs = measureNs(iterations, [&](uint32_t i) { return (float)Units<Meters>::altitude(altitude(i)); });
+  double feetNs = measureNs(iterations, [&](uint32_t i) { return (float)Units<Feet>::altitude(altitude(i)); });
+
+  printf("runtime switch: %5.2f ns/sample\n", runtimeNs);
+  printf("meters policy:  %5.2f ns/sample\n", metersNs);
+  printf("feet policy:    %5.2f ns/sample\n", feetNs);
+  BenchmarkRecord("units", "per sample").add("runtime_ns", runtimeNs).add("meters_ns", metersNs).add("feet_ns", feetNs);
+  check<Units<Meters>>("meters");
+  check<Units<Feet>>("feet");
+}
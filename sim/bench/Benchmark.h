@@ -0,0 +1,56 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+// keeps results alive so the compiler can't drop the measured work
+extern volatile float benchmarkSink;
+// checks that failed, main() returns non-zero if there are any
+extern int benchmarkFailures;
+
+// one line of JSON per result in the file of --json, so scripts can compare runs; written when it goes
+// out of scope, nothing without --json
+class BenchmarkRecord
+{
+  public:
+    BenchmarkRecord(const char *benchmark, const char *name);
+    ~BenchmarkRecord();
+
+    // NaN and infinities are written as null
+    BenchmarkRecord &add(const char *key, double value);
+    BenchmarkRecord &add(const char *key, const char *value);
+
+  private:
+    std::string _line;
+};
+
+// average nanoseconds per call of fn(i) over the given number of iterations
+template <typename Function>
+double measureNs(uint32_t iterations, Function fn)
+{
+  float sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    sum += fn(i);
+  }
+  auto end = std::chrono::steady_clock::now();
+  benchmarkSink = sum;
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+void benchAltitude();
+void benchTrack();
+void benchGlyphs();
+void benchDetector();
+void benchPipeline();
+void benchUnits();
+void benchFrames();
+
+// the traces of the pipeline benchmark besides jump_4000m.csv, see JumpCorpus.cpp
+bool writeCorpus(const char *directory);
+
+#endif // end of BENCHMARK_H
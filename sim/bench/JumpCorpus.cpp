@@ -0,0 +1,170 @@
+#include "Benchmark.h"
+
+#include "SyntheticJump.h"
+
+#include <math.h>
+#include <string>
+
+// the traces of sim/traces besides jump_4000m.csv, each a synthetic jump with one thing that
+// makes it hard, written as the sensors would read it
+
+namespace
+{
+  struct Scenario
+  {
+    const char *name;
+    const char *description;
+    uint32_t seed;
+    float groundPressure; // Pa, sets the dropzone elevation
+    float groundTemperature; // C
+    float noisePa; // standard deviation of both sensors
+    float offsetPa; // sensor 2 reads that much higher
+    void (*shape)(JumpProfile &profile);
+    // sensor 1 repeats its reading for stuckS from stuckAtS, sensor 2 reads glitchPa off once every glitchEveryS
+    float stuckAtS;
+    float stuckS;
+    float glitchPa;
+    float glitchEveryS;
+  };
+
+  const float groundS = 120; // on the ground before the climb starts at climbStartAltitude
+  const float climbStartAltitude = 50;
+
+  const Scenario scenarios[] = {
+      {"hop_pop_1200m", "hop and pop: exit at 1200 m, pull after 3 s, hard opening", 11, 101325, 18, 2.5f, 9, [](JumpProfile &p) {
+         p.exitAltitude = 1200;
+         p.hopAndPop = true;
+         p.pullDelayS = 3;
+         p.openingS = 0.8f;
+       },
+       0, 0, 0, 0},
+      {"head_down_4500m", "exit at 4500 m belly, head down at 80 m/s from 3500 m, deployment at 1000 m", 12, 100500, 22, 2.5f, 14, [](JumpProfile &p) {
+         p.exitAltitude = 4500;
+         p.terminalSpeed = 55;
+         p.positionChangeAltitude = 3500;
+         p.positionTerminalSpeed = 80;
+         p.positionChangeS = 5;
+         p.deploymentAltitude = 1000;
+         p.openingS = 1.0f;
+         p.spiral = false;
+       },
+       0, 0, 0, 0},
+      {"track_soft_opening", "exit at 3000 m, tracking at 38 m/s from 1500 m, slow opening at 1000 m, spiral from 600 m", 13, 95500, 26, 2.5f, -6, [](JumpProfile &p) {
+         p.exitAltitude = 3000;
+         p.terminalSpeed = 52;
+         p.positionChangeAltitude = 1500;
+         p.positionTerminalSpeed = 38;
+         p.positionChangeS = 6;
+         p.deploymentAltitude = 1000;
+         p.openingS = 2.0f;
+         p.spiral = true;
+         p.spiralAltitude = 600;
+       },
+       0, 0, 0, 0},
+      {"high_field_landing", "exit at 3500 m, landing on a field 12 m above the reference after a deep brakes approach", 14, 99800, 15, 2.5f, 4, [](JumpProfile &p) {
+         p.exitAltitude = 3500;
+         p.deploymentAltitude = 900;
+         p.spiral = false;
+         p.deepBrakes = true;
+         p.landingAltitude = 12;
+       },
+       0, 0, 0, 0},
+      {"ride_down", "climb to 1500 m, then the plane descends at 6 m/s and lands with the jumper", 15, 101000, 20, 2.5f, 11, [](JumpProfile &p) {
+         p.exitAltitude = 1500;
+         p.rideDown = true;
+         p.landingAltitude = 0;
+       },
+       0, 0, 0, 0},
+      {"turbulent_noisy", "3 m/s gusts, 8 Pa noise, sensor 2 glitches by 2500 Pa every 45 s, sensor 1 stuck for 20 s under canopy", 16, 100200, 24, 8, 14, [](JumpProfile &p) {
+         p.exitAltitude = 4000;
+         p.deploymentAltitude = 1100;
+         p.gustMs = 3;
+         p.spiral = false;
+         p.landingAltitude = 0;
+       },
+       -120, 20, 2500, 45},
+  };
+
+  float pressureAt(float altitude, float groundPressure)
+  {
+    return groundPressure * powf(1 - altitude / 44330, 1 / 0.1903f);
+  }
+
+  bool writeTrace(const char *directory, const Scenario &scenario)
+  {
+    std::mt19937 random(scenario.seed);
+    JumpProfile profile = randomJumpProfile(random, false);
+    scenario.shape(profile);
+    SyntheticJump jump = generateJump(profile, random);
+    std::normal_distribution<float> noise(0, scenario.noisePa);
+
+    // ground, a climb to where the jump starts, the jump
+    double climbS = climbStartAltitude / profile.climbRate;
+    double jumpStartS = groundS + climbS;
+    double endS = jumpStartS + jump.durationS();
+    double exitS = jump.eventS[JumpDetector::EXIT] >= 0 ? jumpStartS + jump.eventS[JumpDetector::EXIT] : endS;
+    double landingS = jumpStartS + jump.eventS[JumpDetector::LANDING];
+    // stuckAtS counts back from the landing
+    double stuckAtS = scenario.stuckS > 0 ? landingS + scenario.stuckAtS : -1;
+
+    std::string path = std::string(directory) + "/" + scenario.name + ".csv";
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+      return false;
+    }
+    fprintf(file, "# synthetic jump: %s\n", scenario.description);
+    fprintf(file, "# %.0f Pa on the ground, sensor 2 reads %.0f Pa high, both sensors with %.1f Pa gaussian noise\n", scenario.groundPressure,
+            scenario.offsetPa, scenario.noisePa);
+    fprintf(file, "# written by the bench program: --write-corpus sim/traces\n");
+    fprintf(file, "# when it happened, for the detection delays the simulator reports\n");
+    const char *eventNames[] = {"", "exit", "deployment", "landing"};
+    for (uint8_t type = JumpDetector::EXIT; type < JumpDetector::EVENT_TYPES; type++)
+    {
+      if (jump.eventS[type] >= 0)
+      {
+        fprintf(file, "# event,%s,%.0f\n", eventNames[type], (jumpStartS + jump.eventS[type]) * 1000);
+      }
+    }
+    fprintf(file, "# time_ms,pressure1_pa,pressure2_pa,temperature_c\n");
+
+    float stuckPressure = 0;
+    double nextGlitchS = scenario.glitchEveryS;
+    for (double timeS = 0; timeS < endS;)
+    {
+      float altitude = timeS < groundS ? 0 : timeS < jumpStartS ? (timeS - groundS) / climbS * climbStartAltitude : jump.at(timeS - jumpStartS);
+      float pressure = pressureAt(altitude, scenario.groundPressure);
+      float pressure1 = pressure + noise(random);
+      float pressure2 = pressure + scenario.offsetPa + noise(random);
+      if (stuckAtS >= 0 && timeS >= stuckAtS && timeS < stuckAtS + scenario.stuckS)
+      {
+        stuckPressure = stuckPressure ? stuckPressure : pressure1;
+        pressure1 = stuckPressure;
+      }
+      if (scenario.glitchEveryS > 0 && timeS >= nextGlitchS)
+      {
+        pressure2 += scenario.glitchPa;
+        nextGlitchS += scenario.glitchEveryS;
+      }
+      fprintf(file, "%.0f,%.1f,%.1f,%.1f\n", timeS * 1000, pressure1, pressure2, scenario.groundTemperature - 0.0065f * altitude);
+      // 10 Hz from shortly before the exit until after the landing, 5 Hz in the plane and on the ground
+      timeS += timeS >= exitS - 2 && timeS < landingS + 5 ? 0.1 : 0.2;
+    }
+    fclose(file);
+    printf("%s: %.0f s, exit at %.0f m\n", path.c_str(), endS, profile.exitAltitude);
+    return true;
+  }
+}
+
+bool writeCorpus(const char *directory)
+{
+  for (const Scenario &scenario : scenarios)
+  {
+    if (!writeTrace(directory, scenario))
+    {
+      fprintf(stderr, "cannot write %s/%s.csv\n", directory, scenario.name);
+      return false;
+    }
+  }
+  return true;
+}
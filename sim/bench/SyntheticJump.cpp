@@ -0,0 +1,166 @@
+#include "SyntheticJump.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+  const float gravity = 9.81f;
+}
+
+float SyntheticJump::at(double timeS) const
+{
+  size_t i = timeS / stepS;
+  if (i + 1 >= altitude.size())
+  {
+    return altitude.back();
+  }
+  float fraction = timeS / stepS - i;
+  return altitude[i] + (altitude[i + 1] - altitude[i]) * fraction;
+}
+
+JumpProfile randomJumpProfile(std::mt19937 &random, bool rideDown)
+{
+  auto uniform = [&](float low, float high) { return std::uniform_real_distribution<float>(low, high)(random); };
+
+  JumpProfile profile;
+  profile.noiseM = uniform(0.1f, 0.6f);
+  profile.exitAltitude = uniform(1000, 4500);
+  profile.hopAndPop = profile.exitAltitude < 1600;
+  profile.deploymentAltitude = uniform(700, 1500);
+  profile.pullDelayS = uniform(2, 5);
+  profile.terminalSpeed = uniform(45, 75);
+  // tracking away before the pull slows the fall, a change to head down speeds it up
+  profile.positionChangeAltitude = profile.deploymentAltitude + uniform(200, 600);
+  profile.positionTerminalSpeed = uniform(0, 1) < 0.5f ? uniform(30, 45) : uniform(60, 80);
+  profile.positionChangeS = uniform(4, 8);
+  profile.openingS = uniform(0.8f, 2.0f);
+  profile.canopySpeed = uniform(4, 7);
+  profile.spiral = uniform(0, 1) < 0.3f;
+  profile.spiralAltitude = uniform(400, 700);
+  profile.deepBrakes = uniform(0, 1) < 0.3f;
+  profile.landingAltitude = uniform(0, 1) < 0.9f ? uniform(-2, 3) : uniform(5, 15);
+  profile.climbRate = uniform(4, 10);
+  profile.jumpRunS = uniform(30, 90);
+  profile.rideDown = rideDown;
+  profile.gustMs = 1;
+  return profile;
+}
+
+SyntheticJump generateJump(const JumpProfile &profile, std::mt19937 &random)
+{
+  const float stepS = SyntheticJump::stepS;
+  std::normal_distribution<float> normal(0, 1);
+
+  SyntheticJump jump;
+  for (double &eventS : jump.eventS)
+  {
+    eventS = -1;
+  }
+
+  enum Stage
+  {
+    CLIMB,
+    JUMP_RUN,
+    RIDE_DOWN,
+    FREEFALL,
+    CANOPY,
+    GROUND,
+  } stage = CLIMB;
+
+  float altitude = 50;
+  float speed = profile.climbRate;
+  float gust = 0;
+  double timeS = 0;
+  double stageS = 0;
+  double groundS = 0;
+  float positionStartS = -1;
+  while (stage != GROUND || timeS - groundS < 30)
+  {
+    jump.altitude.push_back(altitude);
+    timeS += stepS;
+    // turbulence: mean reverting vertical gusts with a time constant of 2 s
+    gust += -gust / 2 * stepS + profile.gustMs * sqrtf(stepS) * normal(random);
+
+    switch (stage)
+    {
+    case CLIMB:
+      speed = profile.climbRate + gust;
+      if (altitude >= profile.exitAltitude)
+      {
+        stage = profile.rideDown ? RIDE_DOWN : JUMP_RUN;
+        stageS = timeS;
+      }
+      break;
+
+    case JUMP_RUN:
+      speed = gust;
+      if (timeS - stageS >= profile.jumpRunS)
+      {
+        stage = FREEFALL;
+        stageS = timeS;
+        jump.eventS[JumpDetector::EXIT] = timeS;
+      }
+      break;
+
+    case RIDE_DOWN:
+      speed = -6 + gust;
+      break;
+
+    case FREEFALL:
+    {
+      float terminal = profile.terminalSpeed;
+      if (!profile.hopAndPop && altitude < profile.positionChangeAltitude)
+      {
+        positionStartS = positionStartS < 0 ? timeS : positionStartS;
+        float share = std::min(1.0f, (float)(timeS - positionStartS) / profile.positionChangeS);
+        terminal = profile.terminalSpeed + (profile.positionTerminalSpeed - profile.terminalSpeed) * share;
+      }
+      speed += (-gravity + gravity * speed * speed / (terminal * terminal)) * stepS;
+      if (profile.hopAndPop ? timeS - stageS >= profile.pullDelayS : altitude <= profile.deploymentAltitude)
+      {
+        stage = CANOPY;
+        stageS = timeS;
+        jump.eventS[JumpDetector::DEPLOYMENT] = timeS;
+      }
+      break;
+    }
+
+    case CANOPY:
+    {
+      float target = -profile.canopySpeed;
+      float timeConstant = timeS - stageS < 5 ? profile.openingS : 2;
+      if (profile.spiral && altitude < profile.spiralAltitude && altitude > profile.spiralAltitude - 150)
+      {
+        target = -13;
+      }
+      // a long final approach in deep brakes, then the flare
+      if (profile.deepBrakes && altitude < profile.landingAltitude + 25)
+      {
+        target = -2;
+      }
+      if (altitude < profile.landingAltitude + 6)
+      {
+        target = -1.5f;
+        timeConstant = 0.5f;
+      }
+      speed += (target - speed) / timeConstant * stepS;
+      break;
+    }
+
+    case GROUND:
+      speed = 0;
+      break;
+    }
+
+    altitude += speed * stepS;
+    if ((stage == CANOPY || stage == RIDE_DOWN) && altitude <= profile.landingAltitude)
+    {
+      altitude = profile.landingAltitude;
+      stage = GROUND;
+      groundS = timeS;
+      jump.eventS[JumpDetector::LANDING] = timeS;
+    }
+  }
+  return jump;
+}
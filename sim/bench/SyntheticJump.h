@@ -0,0 +1,52 @@
+#ifndef SYNTHETICJUMP_H
+#define SYNTHETICJUMP_H
+
+#include <JumpDetector.h>
+#include <random>
+#include <vector>
+
+// everything that makes one synthetic jump different from the next
+struct JumpProfile
+{
+  float noiseM; // standard deviation of the fused altitude, only used by the replays
+  float climbRate; // m/s
+  float exitAltitude; // m above the ground reference
+  float jumpRunS;
+  bool rideDown; // the plane lands with the jumper instead
+  bool hopAndPop; // pulls pullDelayS after the exit instead of at deploymentAltitude
+  float pullDelayS;
+  float deploymentAltitude;
+  float terminalSpeed; // m/s, positive
+  // tracking or a change to head down: the terminal speed moves to positionTerminalSpeed over positionChangeS
+  float positionChangeAltitude;
+  float positionTerminalSpeed;
+  float positionChangeS;
+  float openingS; // time constant of the opening
+  float canopySpeed; // m/s descent, positive
+  bool spiral; // 150 m at 13 m/s from spiralAltitude down
+  float spiralAltitude;
+  bool deepBrakes; // a final approach at 2 m/s from 25 m above the field
+  float landingAltitude; // the field, m above the ground reference
+  float gustMs; // standard deviation of the vertical gusts in the plane
+};
+
+// the true altitude of a jump every stepS from the start of the climb at 50 m, and when it exited,
+// deployed and landed
+struct SyntheticJump
+{
+  static constexpr float stepS = 0.01f;
+
+  std::vector<float> altitude; // m above the ground reference
+  double eventS[JumpDetector::EVENT_TYPES]; // negative if the jump has none
+
+  float at(double timeS) const;
+  double durationS() const { return altitude.size() * stepS; }
+};
+
+// a random jump in the range of what happens on a dropzone
+JumpProfile randomJumpProfile(std::mt19937 &random, bool rideDown);
+// climb and jump run in turbulence, freefall with drag, an opening that brakes exponentially,
+// canopy, flare and 30 s on the ground
+SyntheticJump generateJump(const JumpProfile &profile, std::mt19937 &random);
+
+#endif // end of SYNTHETICJUMP_H
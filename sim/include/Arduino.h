@@ -0,0 +1,79 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Host stand-in for the ESP32 Arduino core. Only the parts used by the firmware
+// are provided; time is virtual and driven by the simulator (see Simulator.h).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "WString.h"
+#include "Print.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define INPUT_PULLUP 0x05
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+// attributes that only matter on the target
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define DMA_ATTR
+// RTC slow memory survives deep sleep; the simulator saves and restores this section between boots
+#define RTC_DATA_ATTR __attribute__((section("rtc_slow_data"), used))
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define snprintf_P snprintf
+#define strcpy_P strcpy
+#define strlen_P strlen
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+uint16_t analogRead(uint8_t pin);
+// the handler runs on the level changes of the simulated pin, outside of any task
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// fixed CPU costs of the fakes scale with the clock, bus transfers do not
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz);
+uint32_t getCpuFrequencyMhz();
+
+// the caller waits until its bytes are on the wire, 10 bits per byte at the baud rate
+class HardwareSerial : public Print
+{
+  public:
+    void begin(unsigned long baud);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+  private:
+    unsigned long _baud = 115200;
+};
+
+extern HardwareSerial Serial;
+
+#endif // end of SIM_ARDUINO_H
@@ -0,0 +1,56 @@
+#ifndef SIM_PRINT_H
+#define SIM_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "WString.h"
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+      size_t n = 0;
+      while (size--)
+      {
+        n += write(*buffer++);
+      }
+      return n;
+    }
+    size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n) { return printFormatted("%u", n); }
+    size_t print(int n) { return printFormatted("%d", n); }
+    size_t print(unsigned int n) { return printFormatted("%u", n); }
+    size_t print(long n) { return printFormatted("%ld", n); }
+    size_t print(unsigned long n) { return printFormatted("%lu", n); }
+    size_t print(double n, int digits = 2) { return printFormatted("%.*f", digits, n); }
+
+    template <typename T>
+    size_t println(T value)
+    {
+      size_t n = print(value);
+      return n + println();
+    }
+    size_t println() { return write("\r\n"); }
+    virtual void flush() {}
+
+  private:
+    template <typename... Args>
+    size_t printFormatted(const char *format, Args... args)
+    {
+      char buf[32];
+      snprintf(buf, sizeof(buf), format, args...);
+      return write(buf);
+    }
+};
+
+#endif // end of SIM_PRINT_H
@@ -0,0 +1,63 @@
+#ifndef SIM_RTCDS3231_H
+#define SIM_RTCDS3231_H
+
+#include <Arduino.h>
+
+// Date and time counted from 2000-01-01 like the Makuna Rtc library
+class RtcDateTime
+{
+  public:
+    RtcDateTime(uint32_t secondsFrom2000 = 0);
+    RtcDateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second);
+
+    uint16_t Year() const { return _year; }
+    uint8_t Month() const { return _month; }
+    uint8_t Day() const { return _day; }
+    uint8_t Hour() const { return _hour; }
+    uint8_t Minute() const { return _minute; }
+    uint8_t Second() const { return _second; }
+    uint32_t TotalSeconds() const { return _total; }
+    operator uint32_t() const { return _total; }
+
+  private:
+    uint32_t _total;
+    uint16_t _year;
+    uint8_t _month;
+    uint8_t _day;
+    uint8_t _hour;
+    uint8_t _minute;
+    uint8_t _second;
+};
+
+// reads the time registers over I2C like the real library
+template <class T_WIRE_METHOD>
+class RtcDS3231
+{
+  public:
+    RtcDS3231(T_WIRE_METHOD &wire) : _wire(wire) {}
+    void Begin() {}
+    bool IsDateTimeValid() { return true; }
+    bool GetIsRunning() { return true; }
+
+    RtcDateTime GetDateTime()
+    {
+      uint8_t registers[7];
+      _wire.beginTransmission(0x68);
+      _wire.write((uint8_t)0x00);
+      _wire.endTransmission();
+      _wire.requestFrom(0x68, 7);
+      for (uint8_t i = 0; i < 7; i++)
+      {
+        registers[i] = fromBcd(_wire.read());
+      }
+      // seconds, minutes, hours, weekday, day, month, year
+      return RtcDateTime(2000 + registers[6], registers[5], registers[4], registers[2], registers[1], registers[0]);
+    }
+
+  private:
+    static uint8_t fromBcd(uint8_t value) { return value - 6 * (value >> 4); }
+
+    T_WIRE_METHOD &_wire;
+};
+
+#endif // end of SIM_RTCDS3231_H
@@ -0,0 +1,66 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+
+// Host-side simulation of the altimeter hardware.
+//
+// The simulator owns a virtual clock and a recorded pressure trace. The fakes in
+// sim/include read sensor values, buttons and time from here, so setup()/loop()
+// from src/main.cpp run unmodified and much faster than real time.
+namespace Simulator
+{
+  // virtual time since the start of the trace
+  uint64_t nowUs();
+  // virtual time since the current boot (what millis()/micros() see)
+  uint64_t sinceBootUs();
+  void advanceUs(uint64_t us);
+
+  const uint64_t current = UINT64_MAX;
+
+  // trace values at the given virtual time, channel 0 = sensor at 0x76, 1 = 0x77
+  float pressurePa(uint8_t channel, uint64_t timeUs = current);
+  float temperatureC(uint8_t channel, uint64_t timeUs = current);
+  // seconds since 2000-01-01 of the current virtual time
+  uint32_t rtcSeconds();
+
+  int pinLevel(uint8_t pin);
+  // virtual time of the next level change of a pin, SimKernel::forever if there is none
+  uint64_t nextPinEdgeUs(uint8_t pin);
+  // voltage at an ADC pin, the ADC model is in FakeAdc.cpp
+  float pinMillivolts(uint8_t pin);
+
+  bool serialEnabled();
+  // false with --no-pm, esp_pm_configure() then fails like without CONFIG_PM_ENABLE
+  bool powerManagement();
+
+  // CPU clock from setCpuFrequencyMhz() or DFS
+  void setCpuMhz(uint32_t mhz);
+  uint32_t cpuMhz();
+  // time of CPU work that takes the given time at 240 MHz, at the current clock
+  uint64_t cpuTime(uint64_t fullClockTime);
+
+  // called by the firmware whenever changeModeTo() fires
+  void modeChanged(uint8_t from, uint8_t to);
+  // called by the firmware for every event of its jump detector, with the time since its onset
+  void jumpEvent(const char *name, uint32_t sinceOnsetUs);
+  // called by the display fake for every transmitted byte count
+  void displayTransfer(uint32_t bytes);
+  // called by the Wire fake for every transaction
+  void i2cTransfer(uint32_t bytes, uint32_t busUs);
+
+  void setWakeupTimer(uint64_t us);
+  void setWakeupPin(uint8_t pin, int level);
+  void setWakeupUlp();
+  // light sleep wakeup levels of the GPIOs, only used while the GPIO wakeup is enabled
+  void setGpioWakeup(uint8_t pin, int level);
+  void enableGpioWakeup(bool enabled);
+  int wakeupCause();
+  // moves the clock to the wakeup timer or the first press on a wakeup pin
+  void lightSleep();
+  // called by the FreeRTOS fake for the time the loop task was blocked and free for others
+  void loopIdle(uint64_t us);
+  [[noreturn]] void deepSleep();
+}
+
+#endif // end of SIMULATOR_H
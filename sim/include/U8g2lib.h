@@ -0,0 +1,139 @@
+#ifndef SIM_U8G2LIB_H
+#define SIM_U8G2LIB_H
+
+#include <Arduino.h>
+
+// Display fake with a real 128x64 page buffer in the SSD1309 tile layout.
+// Glyphs are drawn as deterministic patterns of the font's cell size, so frame
+// contents change exactly where the firmware draws, but no real font data is used.
+// Frames go out through the u8x8 byte and GPIO callbacks with the command
+// sequence of the SSD1309 driver, so custom transports run against the fake too.
+
+typedef struct
+{
+  uint8_t rotation;
+} u8g2_cb_t;
+
+typedef struct u8x8_struct u8x8_t;
+typedef uint8_t (*u8x8_msg_cb)(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr);
+
+#define U8X8_PIN_NONE 255
+
+#define U8X8_MSG_BYTE_INIT 20
+#define U8X8_MSG_BYTE_SEND 23
+#define U8X8_MSG_BYTE_START_TRANSFER 24
+#define U8X8_MSG_BYTE_END_TRANSFER 25
+#define U8X8_MSG_BYTE_SET_DC 32
+#define U8X8_MSG_GPIO_AND_DELAY_INIT 40
+#define U8X8_MSG_DELAY_MILLI 41
+#define U8X8_MSG_GPIO_RESET 75
+
+struct u8x8_struct
+{
+  u8x8_msg_cb byte_cb;
+  u8x8_msg_cb gpio_and_delay_cb;
+  uint8_t clock;
+  uint8_t data;
+  uint8_t cs;
+  uint8_t dc;
+  uint8_t reset;
+};
+
+typedef struct
+{
+  u8x8_t u8x8;
+} u8g2_t;
+
+void u8g2_Setup_ssd1309_128x64_noname2_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb);
+void u8x8_SetPin_4Wire_SW_SPI(u8x8_t *u8x8, uint8_t clock, uint8_t data, uint8_t cs, uint8_t dc, uint8_t reset);
+void u8x8_SetPin_4Wire_HW_SPI(u8x8_t *u8x8, uint8_t cs, uint8_t dc, uint8_t reset);
+
+// bit-banged SPI through digitalWrite(), the transport of the *_SW_SPI classes
+uint8_t u8x8_byte_arduino_4wire_sw_spi(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr);
+uint8_t u8x8_gpio_and_delay_arduino(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr);
+
+extern const u8g2_cb_t u8g2_cb_r0;
+#define U8G2_R0 (&u8g2_cb_r0)
+
+// fonts: glyph advance, glyph height, first column relative to the cursor (signed), columns past the advance
+extern const uint8_t u8g2_font_courR08_tf[];
+extern const uint8_t u8g2_font_courR08_tr[];
+extern const uint8_t u8g2_font_courB10_tn[];
+extern const uint8_t u8g2_font_courB24_tn[];
+extern const uint8_t u8g2_font_courB24_tr[];
+extern const uint8_t u8g2_font_battery19_tn[];
+extern const uint8_t u8g2_font_logisoso38_tn[];
+extern const uint8_t u8g2_font_logisoso50_tn[];
+extern const uint8_t u8g2_font_logisoso62_tn[];
+extern const uint8_t u8g2_font_helvBO24_tn[];
+
+class U8G2 : public Print
+{
+  public:
+    static const uint8_t tileWidth = 16;
+    static const uint8_t tileHeight = 8;
+
+    U8G2() { memset(&u8g2, 0, sizeof(u8g2)); }
+
+    bool begin();
+    void enableUTF8Print() { _utf8 = true; }
+    void setFlipMode(uint8_t mode) {}
+    void setPowerSave(uint8_t is_enable);
+    void clearDisplay();
+    u8x8_t *getU8x8() { return &u8g2.u8x8; }
+    u8g2_t *getU8g2() { return &u8g2; }
+
+    void clearBuffer() { memset(_buffer, 0, sizeof(_buffer)); }
+    void sendBuffer();
+    void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+    uint8_t *getBufferPtr() { return _buffer; }
+    uint8_t getBufferTileWidth() { return tileWidth; }
+    uint8_t getBufferTileHeight() { return tileHeight; }
+    uint16_t getDisplayWidth() { return tileWidth * 8; }
+    uint16_t getDisplayHeight() { return tileHeight * 8; }
+
+    void setFont(const uint8_t *font) { _font = font; }
+    void setFontDirection(uint8_t dir) { _direction = dir; }
+    void setCursor(int16_t x, int16_t y)
+    {
+      _cursorX = x;
+      _cursorY = y;
+    }
+    int16_t getCursorX() { return _cursorX; }
+    void drawPixel(int16_t x, int16_t y);
+    void drawHLine(int16_t x, int16_t y, int16_t w);
+    void drawBox(int16_t x, int16_t y, int16_t w, int16_t h);
+    // one glyph at x/y (baseline) without moving the cursor, returns its advance
+    uint8_t drawGlyph(int16_t x, int16_t y, uint16_t encoding);
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+
+  protected:
+    u8g2_t u8g2;
+
+  private:
+    void printGlyph(uint8_t c);
+    uint8_t byteCall(uint8_t msg, uint8_t arg_int = 0, const void *arg_ptr = nullptr);
+    void sendCommands(const uint8_t *commands, size_t length);
+    void drawTiles(uint8_t tx, uint8_t ty, uint8_t tw, const uint8_t *tiles);
+
+    uint8_t _buffer[tileWidth * tileHeight * 8];
+    const uint8_t *_font = nullptr;
+    uint8_t _direction = 0;
+    int16_t _cursorX = 0;
+    int16_t _cursorY = 0;
+    bool _utf8 = false;
+};
+
+class U8G2_SSD1309_128X64_NONAME2_F_4W_SW_SPI : public U8G2
+{
+  public:
+    U8G2_SSD1309_128X64_NONAME2_F_4W_SW_SPI(const u8g2_cb_t *rotation, uint8_t clock, uint8_t data, uint8_t cs, uint8_t dc, uint8_t reset = U8X8_PIN_NONE)
+    {
+      u8g2_Setup_ssd1309_128x64_noname2_f(&u8g2, rotation, u8x8_byte_arduino_4wire_sw_spi, u8x8_gpio_and_delay_arduino);
+      u8x8_SetPin_4Wire_SW_SPI(getU8x8(), clock, data, cs, dc, reset);
+    }
+};
+
+#endif // end of SIM_U8G2LIB_H
@@ -0,0 +1,57 @@
+#ifndef SIM_WSTRING_H
+#define SIM_WSTRING_H
+
+#include <string>
+
+// Minimal Arduino String backed by std::string. The text is always on the heap like in the String
+// of the ESP32 core, which has no small string buffer, so the heap check of the simulator sees
+// every String the firmware makes or copies.
+class String
+{
+  public:
+    String(const char *cstr = "") : _s(cstr ? cstr : "") { onHeap(); }
+    String(const std::string &s) : _s(s) { onHeap(); }
+    String(const String &other) : _s(other._s) { onHeap(); }
+    explicit String(char c) : _s(1, c) { onHeap(); }
+    explicit String(int value) : _s(std::to_string(value)) { onHeap(); }
+    explicit String(unsigned int value) : _s(std::to_string(value)) { onHeap(); }
+    explicit String(long value) : _s(std::to_string(value)) { onHeap(); }
+    explicit String(unsigned long value) : _s(std::to_string(value)) { onHeap(); }
+    explicit String(unsigned char value) : _s(std::to_string(value)) { onHeap(); }
+    explicit String(float value, unsigned int decimalPlaces = 2) : _s(format(value, decimalPlaces)) { onHeap(); }
+    explicit String(double value, unsigned int decimalPlaces = 2) : _s(format(value, decimalPlaces)) { onHeap(); }
+
+    String &operator=(const String &rhs)
+    {
+      _s = rhs._s;
+      onHeap();
+      return *this;
+    }
+
+    const char *c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+
+    String &operator+=(const String &rhs)
+    {
+      _s += rhs._s;
+      return *this;
+    }
+    friend String operator+(const String &lhs, const String &rhs) { return String(lhs._s + rhs._s); }
+    friend String operator+(const char *lhs, const String &rhs) { return String(std::string(lhs) + rhs._s); }
+    friend String operator+(const String &lhs, const char *rhs) { return String(lhs._s + rhs); }
+    bool operator==(const String &rhs) const { return _s == rhs._s; }
+
+  private:
+    // past the small string buffer of std::string
+    void onHeap() { _s.reserve(sizeof(std::string)); }
+
+    static std::string format(double value, unsigned int decimalPlaces)
+    {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+      return buf;
+    }
+    std::string _s;
+};
+
+#endif // end of SIM_WSTRING_H
@@ -0,0 +1,37 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+// I2C master talking to the simulated devices (BMP280 at 0x76/0x77, DS3231 at 0x68).
+// Every transaction moves the virtual clock by its time on the bus.
+class TwoWire
+{
+  public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void setClock(uint32_t frequency);
+    uint32_t getClock() { return _frequency; }
+
+    void beginTransmission(uint16_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t length);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint16_t address, uint8_t size, bool sendStop = true);
+    int available() { return _rxLength - _rxIndex; }
+    int read() { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1; }
+
+  private:
+    void busTime(size_t bytes);
+
+    uint32_t _frequency = 100000;
+    uint16_t _txAddress = 0;
+    uint8_t _txBuffer[128];
+    size_t _txLength = 0;
+    uint8_t _rxBuffer[128];
+    size_t _rxLength = 0;
+    size_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // end of SIM_WIRE_H
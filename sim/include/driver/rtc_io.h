@@ -0,0 +1,23 @@
+#ifndef SIM_DRIVER_RTC_IO_H
+#define SIM_DRIVER_RTC_IO_H
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+// RTC GPIO driver: pin muxing has no effect in the simulator, the RTC I2C controller
+// of the ULP fake reaches the simulated devices whatever pads are selected
+
+typedef enum
+{
+  RTC_GPIO_MODE_INPUT_ONLY,
+  RTC_GPIO_MODE_OUTPUT_ONLY,
+  RTC_GPIO_MODE_INPUT_OUTPUT,
+  RTC_GPIO_MODE_DISABLED,
+} rtc_gpio_mode_t;
+
+esp_err_t rtc_gpio_init(gpio_num_t gpio_num);
+esp_err_t rtc_gpio_deinit(gpio_num_t gpio_num);
+esp_err_t rtc_gpio_set_direction(gpio_num_t gpio_num, rtc_gpio_mode_t mode);
+esp_err_t rtc_gpio_pullup_en(gpio_num_t gpio_num);
+
+#endif // end of SIM_DRIVER_RTC_IO_H
@@ -0,0 +1,105 @@
+#ifndef SIM_ESP32_ULP_H
+#define SIM_ESP32_ULP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// ULP coprocessor of the ESP32 with the subset of the instruction macros the firmware
+// uses. Programs are assembled by ulp_process_macros_and_load() into RTC slow memory
+// like on the target, and the simulator runs them while the main cores are in deep
+// sleep: I2C instructions reach the same simulated devices as Wire, every instruction
+// takes its cycles at 8 MHz on the virtual clock.
+
+enum
+{
+  R0 = 0,
+  R1,
+  R2,
+  R3,
+};
+
+// the fake encodes every instruction into one word of RTC slow memory, with its own opcodes
+enum
+{
+  SIM_ULP_HALT = 0,
+  SIM_ULP_WAKE,
+  SIM_ULP_DELAY,
+  SIM_ULP_MOVI,
+  SIM_ULP_MOVR,
+  SIM_ULP_ADDI,
+  SIM_ULP_LSHI,
+  SIM_ULP_ORR,
+  SIM_ULP_LD,
+  SIM_ULP_ST,
+  SIM_ULP_I2C_READ,
+  SIM_ULP_I2C_WRITE,
+  SIM_ULP_BL,
+  SIM_ULP_BGE,
+  SIM_ULP_BX,
+  SIM_ULP_LABEL,
+};
+
+typedef union
+{
+  struct
+  {
+    uint32_t imm : 16;
+    uint32_t rs2 : 2;
+    uint32_t rs1 : 2;
+    uint32_t rd : 2;
+    uint32_t unused : 5;
+    uint32_t opcode : 5;
+  } alu;
+  struct
+  {
+    uint32_t sub : 8;
+    uint32_t value : 8;
+    uint32_t slave : 3;
+    uint32_t unused : 8;
+    uint32_t opcode : 5;
+  } i2c;
+  struct
+  {
+    uint32_t imm : 16;
+    uint32_t target : 11; // label number until ulp_process_macros_and_load() resolves it to an address
+    uint32_t opcode : 5;
+  } branch;
+  uint32_t instruction;
+} ulp_insn_t;
+
+#define SIM_ULP_ALU(op, rd_, rs1_, rs2_, imm_) {.alu = {.imm = (uint32_t)(imm_), .rs2 = (rs2_), .rs1 = (rs1_), .rd = (rd_), .unused = 0, .opcode = (op)}}
+#define SIM_ULP_BRANCH(op, label_, imm_) {.branch = {.imm = (uint32_t)(imm_), .target = (label_), .opcode = (op)}}
+
+#define I_HALT() SIM_ULP_ALU(SIM_ULP_HALT, 0, 0, 0, 0)
+#define I_WAKE() SIM_ULP_ALU(SIM_ULP_WAKE, 0, 0, 0, 0)
+#define I_DELAY(cycles_) SIM_ULP_ALU(SIM_ULP_DELAY, 0, 0, 0, cycles_)
+#define I_MOVI(reg_dest, imm_) SIM_ULP_ALU(SIM_ULP_MOVI, reg_dest, 0, 0, imm_)
+#define I_MOVR(reg_dest, reg_src) SIM_ULP_ALU(SIM_ULP_MOVR, reg_dest, reg_src, 0, 0)
+#define I_ADDI(reg_dest, reg_src, imm_) SIM_ULP_ALU(SIM_ULP_ADDI, reg_dest, reg_src, 0, imm_)
+#define I_LSHI(reg_dest, reg_src, imm_) SIM_ULP_ALU(SIM_ULP_LSHI, reg_dest, reg_src, 0, imm_)
+#define I_ORR(reg_dest, reg_src1, reg_src2) SIM_ULP_ALU(SIM_ULP_ORR, reg_dest, reg_src1, reg_src2, 0)
+// word address reg_addr + offset_
+#define I_LD(reg_dest, reg_addr, offset_) SIM_ULP_ALU(SIM_ULP_LD, reg_dest, reg_addr, 0, offset_)
+#define I_ST(reg_val, reg_addr, offset_) SIM_ULP_ALU(SIM_ULP_ST, reg_val, reg_addr, 0, offset_)
+// one register of the I2C slave selected by SENS_I2C_SLAVE_ADDRn, the byte read ends up in R0
+#define I_I2C_READ(slave_sel, sub_addr) {.i2c = {.sub = (sub_addr), .value = 0, .slave = (slave_sel), .unused = 0, .opcode = SIM_ULP_I2C_READ}}
+#define I_I2C_WRITE(slave_sel, sub_addr, val) {.i2c = {.sub = (sub_addr), .value = (val), .slave = (slave_sel), .unused = 0, .opcode = SIM_ULP_I2C_WRITE}}
+
+#define M_LABEL(label_num) SIM_ULP_BRANCH(SIM_ULP_LABEL, label_num, 0)
+// branch if R0 < imm_value / R0 >= imm_value
+#define M_BL(label_num, imm_value) SIM_ULP_BRANCH(SIM_ULP_BL, label_num, imm_value)
+#define M_BGE(label_num, imm_value) SIM_ULP_BRANCH(SIM_ULP_BGE, label_num, imm_value)
+#define M_BX(label_num) SIM_ULP_BRANCH(SIM_ULP_BX, label_num, 0)
+
+// RTC slow memory, the ULP program and its data live in the first words that the core reserves for it
+#define SIM_ULP_RESERVED_WORDS 128
+extern uint32_t simRtcSlowMemory[SIM_ULP_RESERVED_WORDS];
+#define RTC_SLOW_MEM simRtcSlowMemory
+
+esp_err_t ulp_process_macros_and_load(uint32_t load_addr, const ulp_insn_t *program, size_t *psize);
+esp_err_t ulp_run(uint32_t entry_point);
+esp_err_t ulp_set_wakeup_period(size_t period_index, uint32_t period_us);
+
+#endif // end of SIM_ESP32_ULP_H
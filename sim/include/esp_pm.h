@@ -0,0 +1,33 @@
+#ifndef SIM_ESP_PM_H
+#define SIM_ESP_PM_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// DFS of ESP-IDF 4.x: the CPU runs at min_freq_mhz unless a CPU_FREQ_MAX lock is held
+typedef struct
+{
+  int max_freq_mhz;
+  int min_freq_mhz;
+  bool light_sleep_enable;
+} esp_pm_config_esp32_t;
+
+typedef enum
+{
+  ESP_PM_CPU_FREQ_MAX,
+  ESP_PM_APB_FREQ_MAX,
+  ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+struct esp_pm_lock;
+typedef struct esp_pm_lock *esp_pm_lock_handle_t;
+
+// automatic light sleep needs tickless idle, which the fake does not have: ESP_ERR_NOT_SUPPORTED
+esp_err_t esp_pm_configure(const void *config);
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char *name, esp_pm_lock_handle_t *out_handle);
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle);
+
+#endif // end of SIM_ESP_PM_H
@@ -0,0 +1,38 @@
+#ifndef SIM_ESP_SLEEP_H
+#define SIM_ESP_SLEEP_H
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+typedef enum
+{
+  ESP_SLEEP_WAKEUP_UNDEFINED,
+  ESP_SLEEP_WAKEUP_ALL,
+  ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1,
+  ESP_SLEEP_WAKEUP_TIMER,
+  ESP_SLEEP_WAKEUP_TOUCHPAD,
+  ESP_SLEEP_WAKEUP_ULP,
+  ESP_SLEEP_WAKEUP_GPIO,
+  ESP_SLEEP_WAKEUP_UART,
+} esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level);
+// wake when the ULP program executes I_WAKE()
+esp_err_t esp_sleep_enable_ulp_wakeup();
+// light sleep only: wake on the levels set with gpio_wakeup_enable()
+esp_err_t esp_sleep_enable_gpio_wakeup();
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_wakeup_cause_t source);
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+
+// advances the virtual clock to the wakeup timer, an ext0 or a GPIO wakeup pin going low
+esp_err_t esp_light_sleep_start();
+
+// never returns: the simulator ends the current boot and starts the next one after the wakeup timer,
+// an ext0 button press or a wakeup of the ULP program
+[[noreturn]] void esp_deep_sleep_start();
+
+#endif // end of SIM_ESP_SLEEP_H
@@ -0,0 +1,10 @@
+#ifndef SIM_SOC_RTC_CNTL_REG_H
+#define SIM_SOC_RTC_CNTL_REG_H
+
+#include "soc.h"
+
+#define RTC_CNTL_STATE0_REG (DR_REG_RTCCNTL_BASE + 0x18)
+// ULP timer, set by ulp_run()
+#define RTC_CNTL_ULP_CP_SLP_TIMER_EN BIT(24)
+
+#endif // end of SIM_SOC_RTC_CNTL_REG_H
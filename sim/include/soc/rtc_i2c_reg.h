@@ -0,0 +1,17 @@
+#ifndef SIM_SOC_RTC_I2C_REG_H
+#define SIM_SOC_RTC_I2C_REG_H
+
+#include "soc.h"
+
+// RTC I2C controller used by the ULP, timing in RTC_FAST_CLK cycles (8 MHz)
+#define RTC_I2C_SCL_LOW_PERIOD_REG (DR_REG_RTC_I2C_BASE + 0x000)
+#define RTC_I2C_CTRL_REG (DR_REG_RTC_I2C_BASE + 0x004)
+#define RTC_I2C_MS_MODE_V 0x1
+#define RTC_I2C_MS_MODE_S 4
+#define RTC_I2C_TIMEOUT_REG (DR_REG_RTC_I2C_BASE + 0x00c)
+#define RTC_I2C_SDA_DUTY_REG (DR_REG_RTC_I2C_BASE + 0x030)
+#define RTC_I2C_SCL_HIGH_PERIOD_REG (DR_REG_RTC_I2C_BASE + 0x038)
+#define RTC_I2C_SCL_START_PERIOD_REG (DR_REG_RTC_I2C_BASE + 0x040)
+#define RTC_I2C_SCL_STOP_PERIOD_REG (DR_REG_RTC_I2C_BASE + 0x044)
+
+#endif // end of SIM_SOC_RTC_I2C_REG_H
@@ -0,0 +1,19 @@
+#ifndef SIM_SOC_RTC_IO_REG_H
+#define SIM_SOC_RTC_IO_REG_H
+
+#include "soc.h"
+
+#define RTC_IO_TOUCH_PAD0_REG (DR_REG_RTCIO_BASE + 0x94)
+#define RTC_IO_TOUCH_PAD0_FUN_SEL_V 0x3
+#define RTC_IO_TOUCH_PAD0_FUN_SEL_S 17
+#define RTC_IO_TOUCH_PAD3_REG (DR_REG_RTCIO_BASE + 0xa0)
+#define RTC_IO_TOUCH_PAD3_FUN_SEL_V 0x3
+#define RTC_IO_TOUCH_PAD3_FUN_SEL_S 17
+
+#define RTC_IO_SAR_I2C_IO_REG (DR_REG_RTCIO_BASE + 0xc4)
+#define RTC_IO_SAR_I2C_SDA_SEL_V 0x3
+#define RTC_IO_SAR_I2C_SDA_SEL_S 30
+#define RTC_IO_SAR_I2C_SCL_SEL_V 0x3
+#define RTC_IO_SAR_I2C_SCL_SEL_S 28
+
+#endif // end of SIM_SOC_RTC_IO_REG_H
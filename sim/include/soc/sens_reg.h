@@ -0,0 +1,13 @@
+#ifndef SIM_SOC_SENS_REG_H
+#define SIM_SOC_SENS_REG_H
+
+#include "soc.h"
+
+// the fake keeps the wakeup period in microseconds instead of RTC slow clock cycles
+#define SENS_ULP_CP_SLEEP_CYC0_REG (DR_REG_SENS_BASE + 0x18)
+
+#define SENS_SAR_SLAVE_ADDR1_REG (DR_REG_SENS_BASE + 0x3c)
+#define SENS_I2C_SLAVE_ADDR0_V 0x7FF
+#define SENS_I2C_SLAVE_ADDR0_S 11
+
+#endif // end of SIM_SOC_SENS_REG_H
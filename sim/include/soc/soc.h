@@ -0,0 +1,25 @@
+#ifndef SIM_SOC_SOC_H
+#define SIM_SOC_SOC_H
+
+#include <stdint.h>
+
+// Peripheral register access. The simulator keeps the RTC registers the firmware writes
+// in RTC memory, so they survive deep sleep and the ULP fake sees what setup() configured.
+uint32_t simReadRegister(uint32_t address);
+void simWriteRegister(uint32_t address, uint32_t value);
+
+#define BIT(nr) (1UL << (nr))
+
+#define READ_PERI_REG(addr) simReadRegister(addr)
+#define WRITE_PERI_REG(addr, val) simWriteRegister((addr), (val))
+#define SET_PERI_REG_MASK(reg, mask) WRITE_PERI_REG((reg), READ_PERI_REG(reg) | (mask))
+#define CLEAR_PERI_REG_MASK(reg, mask) WRITE_PERI_REG((reg), READ_PERI_REG(reg) & ~(mask))
+#define REG_GET_FIELD(_r, _f) ((READ_PERI_REG(_r) >> (_f##_S)) & (_f##_V))
+#define REG_SET_FIELD(_r, _f, _v) WRITE_PERI_REG((_r), (READ_PERI_REG(_r) & ~((_f##_V) << (_f##_S))) | (((_v) & (_f##_V)) << (_f##_S)))
+
+#define DR_REG_RTCCNTL_BASE 0x3ff48000
+#define DR_REG_RTCIO_BASE 0x3ff48400
+#define DR_REG_SENS_BASE 0x3ff48800
+#define DR_REG_RTC_I2C_BASE 0x3ff48C00
+
+#endif // end of SIM_SOC_SOC_H
@@ -0,0 +1,65 @@
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+#include "Simulator.h"
+
+namespace
+{
+  // the simulated chip: Vref 2.5% above nominal, as burnt into its eFuse
+  const uint32_t chipVrefMv = 1128;
+  // 11 dB attenuation: 0 to 4095 over about 75 to 3150 mV at the nominal Vref of 1100 mV
+  const float offsetMv = 75;
+  const float spanMv = 3075;
+  const uint8_t channelPins[] = {36, 37, 38, 39, 32, 33, 34, 35};
+
+  uint32_t noiseSeed = 1;
+
+  // a few LSB of noise like the real ADC, the same on every run
+  int rawReading(uint8_t pin)
+  {
+    float raw = (Simulator::pinMillivolts(pin) - offsetMv) * 4095 / (spanMv * chipVrefMv / 1100);
+    noiseSeed = noiseSeed * 1103515245 + 12345;
+    int noisy = (int)(raw + 0.5f) + (int)((noiseSeed >> 16) % 13) - 6;
+    return noisy < 0 ? 0 : noisy > 4095 ? 4095 : noisy;
+  }
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+  return rawReading(pin);
+}
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit)
+{
+  return ESP_OK;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten)
+{
+  return ESP_OK;
+}
+
+int adc1_get_raw(adc1_channel_t channel)
+{
+  return rawReading(channelPins[channel]);
+}
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t *chars)
+{
+  chars->adc_num = adc_num;
+  chars->atten = atten;
+  chars->bit_width = bit_width;
+  chars->vref = chipVrefMv;
+  chars->coeff_a = spanMv * chipVrefMv / 1100 / 4095 * 65536 + 0.5f;
+  chars->coeff_b = offsetMv;
+  chars->low_curve = nullptr;
+  chars->high_curve = nullptr;
+  return ESP_ADC_CAL_VAL_EFUSE_VREF;
+}
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t *chars)
+{
+  return (chars->coeff_a * adc_reading + 32768) / 65536 + chars->coeff_b;
+}
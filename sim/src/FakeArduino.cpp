@@ -0,0 +1,215 @@
+#include <Arduino.h>
+#include <driver/gpio.h>
+#include <unistd.h>
+
+#include "SimDisplay.h"
+#include "SimKernel.h"
+#include "Simulator.h"
+
+HardwareSerial Serial;
+
+namespace
+{
+  // a kernel timer per pin with a handler, due at the next level change of the pin
+  struct PinInterrupt
+  {
+    SimKernel::Timer timer;
+    void (*handler)(void *) = nullptr;
+    void *arg = nullptr;
+    gpio_int_type_t type = GPIO_INTR_DISABLE;
+    bool enabled = false;
+  };
+
+  const uint8_t pinCount = 40;
+  PinInterrupt pinInterrupts[pinCount];
+
+  void armPinInterrupt(uint8_t pin)
+  {
+    PinInterrupt &interrupt = pinInterrupts[pin];
+    interrupt.timer.nextUs = Simulator::nextPinEdgeUs(pin);
+    interrupt.timer.enabled = interrupt.handler && interrupt.timer.nextUs != SimKernel::forever;
+  }
+
+  // the buttons have clean edges, every change of the level is one edge; a level type fires
+  // once on the edge that reaches the level
+  void pinEdge(uint8_t pin)
+  {
+    PinInterrupt &interrupt = pinInterrupts[pin];
+    int level = Simulator::pinLevel(pin);
+    bool fires = interrupt.type == GPIO_INTR_ANYEDGE || (interrupt.type == GPIO_INTR_POSEDGE && level == HIGH) ||
+                 (interrupt.type == GPIO_INTR_NEGEDGE && level == LOW) ||
+                 (interrupt.type == GPIO_INTR_LOW_LEVEL && level == LOW) ||
+                 (interrupt.type == GPIO_INTR_HIGH_LEVEL && level == HIGH);
+    if (interrupt.enabled && fires)
+    {
+      interrupt.handler(interrupt.arg);
+    }
+    armPinInterrupt(pin);
+  }
+}
+
+unsigned long millis()
+{
+  return Simulator::sinceBootUs() / 1000;
+}
+
+unsigned long micros()
+{
+  return Simulator::sinceBootUs();
+}
+
+void delay(uint32_t ms)
+{
+  Simulator::advanceUs((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  Simulator::advanceUs(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+int digitalRead(uint8_t pin)
+{
+  return Simulator::pinLevel(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin == SimDisplay::dcPin)
+  {
+    SimDisplay::setDc(val);
+  }
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode)
+{
+  PinInterrupt &interrupt = pinInterrupts[pin];
+  if (!interrupt.handler)
+  {
+    interrupt.timer.fire = [pin] { pinEdge(pin); };
+    SimKernel::addTimer(&interrupt.timer);
+  }
+  interrupt.handler = handler;
+  interrupt.arg = arg;
+  interrupt.type = mode == RISING ? GPIO_INTR_POSEDGE : mode == FALLING ? GPIO_INTR_NEGEDGE : GPIO_INTR_ANYEDGE;
+  interrupt.enabled = true;
+  armPinInterrupt(pin);
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  PinInterrupt &interrupt = pinInterrupts[pin];
+  if (interrupt.handler)
+  {
+    SimKernel::removeTimer(&interrupt.timer);
+  }
+  interrupt = PinInterrupt();
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+  pinInterrupts[gpio_num].type = intr_type;
+  return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+  pinInterrupts[gpio_num].enabled = true;
+  return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+  pinInterrupts[gpio_num].enabled = false;
+  return ESP_OK;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void HardwareSerial::begin(unsigned long baud)
+{
+  _baud = baud;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (Simulator::serialEnabled())
+  {
+    fwrite(buffer, 1, size, stdout);
+  }
+  Simulator::advanceUs(size * 10 * 1000000ULL / _baud);
+  return size;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+  Simulator::setWakeupTimer(time_in_us);
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level)
+{
+  Simulator::setWakeupPin(gpio_num, level);
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup()
+{
+  Simulator::enableGpioWakeup(true);
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_wakeup_cause_t source)
+{
+  if (source == ESP_SLEEP_WAKEUP_TIMER)
+  {
+    Simulator::setWakeupTimer(0);
+  }
+  else if (source == ESP_SLEEP_WAKEUP_GPIO)
+  {
+    Simulator::enableGpioWakeup(false);
+  }
+  return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+  pinInterrupts[gpio_num].type = intr_type;
+  Simulator::setGpioWakeup(gpio_num, intr_type == GPIO_INTR_LOW_LEVEL ? LOW : HIGH);
+  return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num)
+{
+  pinInterrupts[gpio_num].type = GPIO_INTR_DISABLE;
+  // only the pins that wake on low are tracked
+  Simulator::setGpioWakeup(gpio_num, HIGH);
+  return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause()
+{
+  return (esp_sleep_wakeup_cause_t)Simulator::wakeupCause();
+}
+
+esp_err_t esp_light_sleep_start()
+{
+  Simulator::lightSleep();
+  return ESP_OK;
+}
+
+void esp_deep_sleep_start()
+{
+  Simulator::deepSleep();
+}
@@ -0,0 +1,234 @@
+#include <cstring>
+#include <esp_partition.h>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <vector>
+
+#include "SimFlash.h"
+#include "Simulator.h"
+
+namespace
+{
+  // typical timings of the flash chip on the LOLIN D32
+  const uint64_t sectorEraseUs = 45000;
+  const uint64_t pageProgramUs = 700;
+  const uint32_t pageSize = 256;
+
+  struct SharedCounters
+  {
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+  };
+
+  struct Partition
+  {
+    esp_partition_t info;
+    uint8_t *data;
+    uint32_t *sectorErases;
+    SharedCounters *counters;
+  };
+
+  std::vector<Partition> partitions;
+
+  uint8_t *sharedMemory(size_t size)
+  {
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return memory == MAP_FAILED ? nullptr : (uint8_t *)memory;
+  }
+
+  uint32_t parseNumber(std::string text)
+  {
+    uint32_t factor = 1;
+    if (!text.empty() && (text.back() == 'K' || text.back() == 'k'))
+    {
+      factor = 1024;
+      text.pop_back();
+    }
+    else if (!text.empty() && (text.back() == 'M' || text.back() == 'm'))
+    {
+      factor = 1024 * 1024;
+      text.pop_back();
+    }
+    return strtoul(text.c_str(), nullptr, 0) * factor;
+  }
+
+  std::string trim(const std::string &text)
+  {
+    size_t start = text.find_first_not_of(" \t\r");
+    size_t end = text.find_last_not_of(" \t\r");
+    return start == std::string::npos ? "" : text.substr(start, end - start + 1);
+  }
+
+  Partition *find(const esp_partition_t *partition)
+  {
+    for (Partition &p : partitions)
+    {
+      if (&p.info == partition)
+      {
+        return &p;
+      }
+    }
+    return nullptr;
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+bool SimFlash::begin(const char *partitionTable, const char *image)
+{
+  std::ifstream file(partitionTable);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    line = trim(line);
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (start <= line.size())
+    {
+      size_t end = line.find(',', start);
+      fields.push_back(trim(line.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+      start = end == std::string::npos ? line.size() + 1 : end + 1;
+    }
+    // only data partitions are simulated
+    if (fields.size() < 5 || fields[1] != "data")
+    {
+      continue;
+    }
+    Partition partition;
+    memset(&partition.info, 0, sizeof(partition.info));
+    partition.info.type = ESP_PARTITION_TYPE_DATA;
+    partition.info.subtype = fields[2] == "nvs" ? 0x02 : fields[2] == "ota" ? 0x00 : fields[2] == "spiffs" ? 0x82 : parseNumber(fields[2]);
+    partition.info.address = parseNumber(fields[3]);
+    partition.info.size = parseNumber(fields[4]);
+    strncpy(partition.info.label, fields[0].c_str(), sizeof(partition.info.label) - 1);
+    uint32_t sectors = partition.info.size / sectorSize;
+    uint8_t *memory = sharedMemory(partition.info.size + sectors * sizeof(uint32_t) + sizeof(SharedCounters));
+    if (!memory)
+    {
+      return false;
+    }
+    partition.data = memory;
+    partition.sectorErases = (uint32_t *)(memory + partition.info.size);
+    partition.counters = (SharedCounters *)(partition.sectorErases + sectors);
+    memset(partition.data, 0xFF, partition.info.size);
+    partitions.push_back(partition);
+  }
+  if (partitions.empty())
+  {
+    return false;
+  }
+
+  if (image)
+  {
+    std::ifstream input(image, std::ios::binary);
+    for (Partition &partition : partitions)
+    {
+      input.read((char *)partition.data, partition.info.size);
+    }
+  }
+  return true;
+}
+
+bool SimFlash::save(const char *image)
+{
+  std::ofstream output(image, std::ios::binary);
+  for (Partition &partition : partitions)
+  {
+    output.write((const char *)partition.data, partition.info.size);
+  }
+  return output.good();
+}
+
+const esp_partition_t *SimFlash::partition(int index)
+{
+  return index < (int)partitions.size() ? &partitions[index].info : nullptr;
+}
+
+SimFlash::Usage SimFlash::usage(const esp_partition_t *partition)
+{
+  Partition *p = find(partition);
+  Usage usage = {p->counters->bytesRead, p->counters->bytesWritten, 0, UINT32_MAX, 0};
+  for (uint32_t sector = 0; sector < p->info.size / sectorSize; sector++)
+  {
+    uint32_t erases = p->sectorErases[sector];
+    usage.erases += erases;
+    usage.minSectorErases = erases < usage.minSectorErases ? erases : usage.minSectorErases;
+    usage.maxSectorErases = erases > usage.maxSectorErases ? erases : usage.maxSectorErases;
+  }
+  return usage;
+}
+
+void SimFlash::resetUsage()
+{
+  for (Partition &partition : partitions)
+  {
+    memset(partition.sectorErases, 0, partition.info.size / sectorSize * sizeof(uint32_t));
+    memset(partition.counters, 0, sizeof(SharedCounters));
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+  for (Partition &partition : partitions)
+  {
+    if (partition.info.type == type && (subtype == ESP_PARTITION_SUBTYPE_ANY || partition.info.subtype == subtype) &&
+        (label == nullptr || strcmp(label, partition.info.label) == 0))
+    {
+      return &partition.info;
+    }
+  }
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+  Partition *p = find(partition);
+  if (!p || src_offset + size > p->info.size)
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memcpy(dst, p->data + src_offset, size);
+  p->counters->bytesRead += size;
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+  Partition *p = find(partition);
+  if (!p || dst_offset + size > p->info.size)
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  // NOR flash: programming can only turn ones into zeros
+  const uint8_t *bytes = (const uint8_t *)src;
+  for (size_t i = 0; i < size; i++)
+  {
+    p->data[dst_offset + i] &= bytes[i];
+  }
+  p->counters->bytesWritten += size;
+  Simulator::advanceUs((size + pageSize - 1) / pageSize * pageProgramUs);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+  Partition *p = find(partition);
+  if (!p || offset % SimFlash::sectorSize || size % SimFlash::sectorSize || offset + size > p->info.size)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(p->data + offset, 0xFF, size);
+  for (size_t sector = offset / SimFlash::sectorSize; sector < (offset + size) / SimFlash::sectorSize; sector++)
+  {
+    p->sectorErases[sector]++;
+  }
+  Simulator::advanceUs(size / SimFlash::sectorSize * sectorEraseUs);
+  return ESP_OK;
+}
@@ -0,0 +1,520 @@
+#include <Arduino.h>
+#include <condition_variable>
+#include <esp_timer.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SimKernel.h"
+#include "Simulator.h"
+
+struct SimTask
+{
+  const char *name;
+  TaskFunction_t code;
+  void *parameters;
+  UBaseType_t priority;
+  std::thread thread;
+  std::condition_variable resumed;
+  bool scheduled = false;
+  bool finished = false;
+  // blocked until ready() returns true or the wake time passed
+  std::function<bool()> ready;
+  uint64_t wakeAtUs = SimKernel::forever;
+  uint32_t notifyValue = 0;
+  bool notifyPending = false;
+};
+
+struct SimSemaphore
+{
+  int count;
+  int maxCount;
+};
+
+struct esp_timer
+{
+  SimKernel::Timer timer;
+  esp_timer_cb_t callback;
+  void *arg;
+};
+
+uint64_t SimKernel::nowUs = 0;
+
+namespace
+{
+  std::mutex kernelMutex;
+  std::condition_variable mainResumed;
+  SimTask *running = nullptr;
+  thread_local SimTask *self = nullptr;
+  std::vector<SimTask *> tasks;
+  std::vector<SimKernel::Timer *> timers;
+  std::vector<esp_timer *> espTimers;
+  // stands in for the Arduino loop task, which is the main thread
+  SimTask loopTask;
+
+  // main thread hands the CPU to a task and waits until it blocks again
+  void resume(SimTask *task)
+  {
+    std::unique_lock<std::mutex> lock(kernelMutex);
+    running = task;
+    task->scheduled = true;
+    task->resumed.notify_one();
+    mainResumed.wait(lock, [] { return running == nullptr; });
+  }
+
+  // task gives the CPU back to the main thread and waits to be scheduled again
+  void yieldToMain()
+  {
+    std::unique_lock<std::mutex> lock(kernelMutex);
+    self->scheduled = false;
+    running = nullptr;
+    mainResumed.notify_one();
+    self->resumed.wait(lock, [] { return self->scheduled; });
+  }
+
+  void taskEntry(SimTask *task)
+  {
+    {
+      std::unique_lock<std::mutex> lock(kernelMutex);
+      task->resumed.wait(lock, [task] { return task->scheduled; });
+    }
+    self = task;
+    task->code(task->parameters);
+    std::unique_lock<std::mutex> lock(kernelMutex);
+    task->finished = true;
+    running = nullptr;
+    mainResumed.notify_one();
+  }
+
+  uint64_t nextEventUs()
+  {
+    uint64_t next = SimKernel::forever;
+    for (SimKernel::Timer *timer : timers)
+    {
+      if (timer->enabled && timer->nextUs < next)
+      {
+        next = timer->nextUs;
+      }
+    }
+    for (SimTask *task : tasks)
+    {
+      if (!task->finished && task->wakeAtUs < next)
+      {
+        next = task->wakeAtUs;
+      }
+    }
+    return next;
+  }
+
+  void fireTimers()
+  {
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+      SimKernel::Timer *timer = timers[i];
+      if (timer->enabled && timer->nextUs <= SimKernel::nowUs)
+      {
+        if (timer->autoreload && timer->periodUs)
+        {
+          timer->nextUs += timer->periodUs;
+        }
+        else
+        {
+          timer->enabled = false;
+        }
+        timer->fire();
+      }
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void SimKernel::addTimer(Timer *timer)
+{
+  timers.push_back(timer);
+}
+
+void SimKernel::removeTimer(Timer *timer)
+{
+  for (size_t i = 0; i < timers.size(); i++)
+  {
+    if (timers[i] == timer)
+    {
+      timers.erase(timers.begin() + i);
+      return;
+    }
+  }
+}
+
+bool SimKernel::inTask()
+{
+  return self != nullptr;
+}
+
+void SimKernel::runReadyTasks()
+{
+  if (inTask())
+  {
+    return;
+  }
+  while (true)
+  {
+    SimTask *next = nullptr;
+    for (SimTask *task : tasks)
+    {
+      bool ready = !task->ready || task->ready() || task->wakeAtUs <= nowUs;
+      if (!task->finished && ready && (!next || task->priority > next->priority))
+      {
+        next = task;
+      }
+    }
+    if (!next)
+    {
+      return;
+    }
+    next->wakeAtUs = forever;
+    resume(next);
+  }
+}
+
+void SimKernel::advanceTo(uint64_t targetUs)
+{
+  runReadyTasks();
+  while (true)
+  {
+    uint64_t next = nextEventUs();
+    if (next > targetUs)
+    {
+      break;
+    }
+    if (next > nowUs)
+    {
+      nowUs = next;
+    }
+    fireTimers();
+    runReadyTasks();
+  }
+  nowUs = targetUs;
+  runReadyTasks();
+}
+
+bool SimKernel::block(const std::function<bool()> &ready, uint64_t timeoutUs)
+{
+  if (inTask())
+  {
+    self->ready = ready ? ready : [] { return false; };
+    self->wakeAtUs = timeoutUs;
+    yieldToMain();
+    self->ready = nullptr;
+    return ready && ready();
+  }
+
+  // the main thread cannot be suspended, it moves the clock forward until the condition holds
+  runReadyTasks();
+  while (!ready || !ready())
+  {
+    uint64_t next = nextEventUs();
+    if (next > timeoutUs)
+    {
+      if (timeoutUs == forever)
+      {
+        fprintf(stderr, "[sim] deadlock: loop task blocks forever\n");
+        abort();
+      }
+      advanceTo(timeoutUs);
+      return ready && ready();
+    }
+    advanceTo(next > nowUs ? next : nowUs);
+  }
+  return true;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+static uint64_t timeoutFromTicks(TickType_t ticks)
+{
+  return ticks == portMAX_DELAY ? SimKernel::forever : SimKernel::nowUs + (uint64_t)ticks * 1000 * portTICK_PERIOD_MS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stackDepth, void *parameters,
+                                   UBaseType_t priority, TaskHandle_t *createdTask, BaseType_t coreId)
+{
+  SimTask *task = new SimTask();
+  task->name = name;
+  task->code = code;
+  task->parameters = parameters;
+  task->priority = priority;
+  tasks.push_back(task);
+  task->thread = std::thread(taskEntry, task);
+  task->thread.detach();
+  if (createdTask)
+  {
+    *createdTask = task;
+  }
+  // the task starts right away on the other core
+  SimKernel::runReadyTasks();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+  if (task == nullptr || task == self)
+  {
+    self->finished = true;
+    self->ready = [] { return false; };
+    while (true)
+    {
+      yieldToMain();
+    }
+  }
+  task->finished = true;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  uint64_t startUs = SimKernel::nowUs;
+  SimKernel::block(nullptr, timeoutFromTicks(ticks));
+  if (!SimKernel::inTask())
+  {
+    Simulator::loopIdle(SimKernel::nowUs - startUs);
+  }
+}
+
+TickType_t xTaskGetTickCount()
+{
+  return Simulator::sinceBootUs() / 1000 / portTICK_PERIOD_MS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  return self ? self : &loopTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+  SimTask *task = xTaskGetCurrentTaskHandle();
+  if (task->notifyValue == 0)
+  {
+    uint64_t startUs = SimKernel::nowUs;
+    SimKernel::block([task] { return task->notifyValue > 0; }, timeoutFromTicks(ticksToWait));
+    if (task == &loopTask)
+    {
+      Simulator::loopIdle(SimKernel::nowUs - startUs);
+    }
+  }
+  uint32_t value = task->notifyValue;
+  if (value)
+  {
+    task->notifyValue = clearCountOnExit ? 0 : value - 1;
+  }
+  task->notifyPending = false;
+  return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bitsToClearOnEntry, uint32_t bitsToClearOnExit, uint32_t *notificationValue,
+                           TickType_t ticksToWait)
+{
+  SimTask *task = xTaskGetCurrentTaskHandle();
+  if (!task->notifyPending)
+  {
+    task->notifyValue &= ~bitsToClearOnEntry;
+    if (ticksToWait)
+    {
+      uint64_t startUs = SimKernel::nowUs;
+      SimKernel::block([task] { return task->notifyPending; }, timeoutFromTicks(ticksToWait));
+      if (task == &loopTask)
+      {
+        Simulator::loopIdle(SimKernel::nowUs - startUs);
+      }
+    }
+  }
+  if (notificationValue)
+  {
+    *notificationValue = task->notifyValue;
+  }
+  if (!task->notifyPending)
+  {
+    return pdFALSE;
+  }
+  task->notifyValue &= ~bitsToClearOnExit;
+  task->notifyPending = false;
+  return pdTRUE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+  return xTaskNotify(task, 0, eIncrement);
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+  switch (action)
+  {
+  case eSetBits:
+    task->notifyValue |= value;
+    break;
+  case eIncrement:
+    task->notifyValue++;
+    break;
+  case eSetValueWithoutOverwrite:
+    if (task->notifyPending)
+    {
+      return pdFAIL;
+    }
+    task->notifyValue = value;
+    break;
+  case eSetValueWithOverwrite:
+    task->notifyValue = value;
+    break;
+  case eNoAction:
+    break;
+  }
+  task->notifyPending = true;
+  SimKernel::runReadyTasks();
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken)
+{
+  task->notifyValue++;
+  task->notifyPending = true;
+  if (higherPriorityTaskWoken)
+  {
+    *higherPriorityTaskWoken = pdTRUE;
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+  return new SimSemaphore{1, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+  return new SimSemaphore{0, 1};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait)
+{
+  if (semaphore->count == 0 && (ticksToWait == 0 || !SimKernel::block([semaphore] { return semaphore->count > 0; }, timeoutFromTicks(ticksToWait))))
+  {
+    return pdFALSE;
+  }
+  semaphore->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+  if (semaphore->count >= semaphore->maxCount)
+  {
+    return pdFALSE;
+  }
+  semaphore->count++;
+  SimKernel::runReadyTasks();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *higherPriorityTaskWoken)
+{
+  if (semaphore->count >= semaphore->maxCount)
+  {
+    return pdFALSE;
+  }
+  semaphore->count++;
+  if (higherPriorityTaskWoken)
+  {
+    *higherPriorityTaskWoken = pdTRUE;
+  }
+  return pdTRUE;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+int64_t esp_timer_get_time()
+{
+  return Simulator::sinceBootUs();
+}
+
+int64_t esp_timer_get_next_alarm()
+{
+  uint64_t next = SimKernel::forever;
+  for (esp_timer *timer : espTimers)
+  {
+    if (timer->timer.enabled && timer->timer.nextUs < next)
+    {
+      next = timer->timer.nextUs;
+    }
+  }
+  // the kernel counts from the start of the trace, esp_timer from the boot
+  return next == SimKernel::forever ? INT64_MAX : next - (SimKernel::nowUs - Simulator::sinceBootUs());
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+  esp_timer *timer = new esp_timer();
+  timer->callback = create_args->callback;
+  timer->arg = create_args->arg;
+  timer->timer.fire = [timer] { timer->callback(timer->arg); };
+  SimKernel::addTimer(&timer->timer);
+  espTimers.push_back(timer);
+  *out_handle = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+  if (timer->timer.enabled)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->timer.periodUs = timeout_us;
+  timer->timer.autoreload = false;
+  timer->timer.enabled = true;
+  timer->timer.nextUs = SimKernel::nowUs + timeout_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+  if (timer->timer.enabled)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->timer.periodUs = period;
+  timer->timer.autoreload = true;
+  timer->timer.enabled = true;
+  timer->timer.nextUs = SimKernel::nowUs + period;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  if (!timer->timer.enabled)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->timer.enabled = false;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+  if (timer->timer.enabled)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  SimKernel::removeTimer(&timer->timer);
+  for (size_t i = 0; i < espTimers.size(); i++)
+  {
+    if (espTimers[i] == timer)
+    {
+      espTimers.erase(espTimers.begin() + i);
+      break;
+    }
+  }
+  delete timer;
+  return ESP_OK;
+}
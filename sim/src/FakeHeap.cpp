@@ -0,0 +1,79 @@
+#include "SimHeap.h"
+
+#include <atomic>
+#include <execinfo.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// glibc's own allocator, the functions below replace the public names for the whole program
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+namespace
+{
+  std::atomic<bool> tracing(false);
+  std::atomic<uint32_t> traced(0);
+  // backtrace() allocates itself the first time, and the frames of a report must not count again
+  thread_local bool reporting = false;
+
+  void trace()
+  {
+    if (!tracing.load(std::memory_order_relaxed) || reporting)
+    {
+      return;
+    }
+    uint32_t count = traced.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count > SimHeap::reportedStacks)
+    {
+      return;
+    }
+    reporting = true;
+    void *frames[12];
+    int depth = backtrace(frames, 12);
+    dprintf(STDERR_FILENO, "[sim] heap allocation %u after setup():\n", count);
+    // skips trace() and the allocation function itself
+    backtrace_symbols_fd(frames + 2, depth - 2, STDERR_FILENO);
+    reporting = false;
+  }
+}
+
+extern "C" void *malloc(size_t size)
+{
+  trace();
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+  trace();
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+  trace();
+  return __libc_realloc(pointer, size);
+}
+
+void SimHeap::startTracing()
+{
+  // loads what backtrace() needs while it may still allocate
+  void *frame;
+  reporting = true;
+  backtrace(&frame, 1);
+  reporting = false;
+  traced = 0;
+  tracing = true;
+}
+
+void SimHeap::stopTracing()
+{
+  tracing = false;
+}
+
+uint32_t SimHeap::allocations()
+{
+  return traced;
+}
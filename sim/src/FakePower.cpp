@@ -0,0 +1,108 @@
+#include <Arduino.h>
+#include <esp_pm.h>
+
+#include "Simulator.h"
+
+struct esp_pm_lock
+{
+  esp_pm_lock_type_t type;
+  int count;
+};
+
+namespace
+{
+  bool configured = false;
+  uint32_t maxMhz = 240;
+  uint32_t minMhz = 240;
+  // clock set with setCpuFrequencyMhz(), DFS overrides it once configured
+  uint32_t fixedMhz = 240;
+  int cpuLocks = 0;
+
+  void update()
+  {
+    Simulator::setCpuMhz(!configured ? fixedMhz : cpuLocks ? maxMhz : minMhz);
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz)
+{
+  if (cpu_freq_mhz != 240 && cpu_freq_mhz != 160 && cpu_freq_mhz != 80 && cpu_freq_mhz != 40)
+  {
+    return false;
+  }
+  fixedMhz = cpu_freq_mhz;
+  update();
+  return true;
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+  return Simulator::cpuMhz();
+}
+
+esp_err_t esp_pm_configure(const void *config)
+{
+  const esp_pm_config_esp32_t *pm = (const esp_pm_config_esp32_t *)config;
+  // like an SDK built without CONFIG_PM_ENABLE or without tickless idle for automatic light sleep
+  if (!Simulator::powerManagement() || pm->light_sleep_enable)
+  {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  if (pm->min_freq_mhz > pm->max_freq_mhz)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  configured = true;
+  maxMhz = pm->max_freq_mhz;
+  minMhz = pm->min_freq_mhz;
+  update();
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char *name, esp_pm_lock_handle_t *out_handle)
+{
+  if (!Simulator::powerManagement())
+  {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  *out_handle = new esp_pm_lock{lock_type, 0};
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle)
+{
+  handle->count++;
+  if (handle->type == ESP_PM_CPU_FREQ_MAX)
+  {
+    cpuLocks++;
+    update();
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle)
+{
+  if (handle->count == 0)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  handle->count--;
+  if (handle->type == ESP_PM_CPU_FREQ_MAX)
+  {
+    cpuLocks--;
+    update();
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle)
+{
+  if (handle->count)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  delete handle;
+  return ESP_OK;
+}
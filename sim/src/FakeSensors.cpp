@@ -0,0 +1,400 @@
+#include <Bmp280.h>
+#include <RtcDS3231.h>
+#include <Wire.h>
+
+#include "Simulator.h"
+
+TwoWire Wire;
+
+namespace
+{
+  // device on the simulated bus, sees the bytes of one transaction at a time
+  class I2cDevice
+  {
+    public:
+      virtual void write(const uint8_t *data, size_t length) = 0;
+      virtual void read(uint8_t *data, size_t length) = 0;
+  };
+
+  // BMP280 with its conversion timing and IIR filter: the data registers hold the result
+  // of the last finished conversion, taken from the trace at the time of that conversion
+  class Bmp280Device : public I2cDevice
+  {
+    public:
+      Bmp280Device(uint8_t channel) : _channel(channel) {}
+
+      void write(const uint8_t *data, size_t length) override
+      {
+        // a single byte sets the register pointer for the next read, otherwise register/value pairs
+        if (length == 1)
+        {
+          _pointer = data[0];
+          return;
+        }
+        for (size_t i = 0; i + 1 < length; i += 2)
+        {
+          writeRegister(data[i], data[i + 1]);
+        }
+      }
+
+      void read(uint8_t *data, size_t length) override
+      {
+        if (_pointer <= 0xFC && _pointer + length > 0xF7)
+        {
+          update();
+        }
+        for (size_t i = 0; i < length; i++)
+        {
+          data[i] = readRegister(_pointer++);
+        }
+      }
+
+    private:
+      // datasheet example trimming values
+      static constexpr Bmp280::Calibration calibration = {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+
+      uint8_t sampling(uint8_t bits) { return bits ? 1 << ((bits > 5 ? 5 : bits) - 1) : 0; }
+
+      // typical conversion time, datasheet 3.8.1
+      uint64_t conversionUs()
+      {
+        uint8_t temperatureSteps = sampling(_control >> 5);
+        uint8_t pressureSteps = sampling((_control >> 2) & 0x07);
+        return 1000 + 2000 * temperatureSteps + 2000 * pressureSteps + (pressureSteps ? 500 : 0);
+      }
+
+      uint64_t standbyUs()
+      {
+        static const uint64_t standby[] = {500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000};
+        return standby[_config >> 5];
+      }
+
+      void writeRegister(uint8_t reg, uint8_t value)
+      {
+        if (reg == 0xF4)
+        {
+          _control = value;
+          // sleep stops conversions, forced and normal mode start one right away
+          _nextConversionUs = (value & 0x03) ? Simulator::nowUs() + conversionUs() : UINT64_MAX;
+        }
+        else if (reg == 0xF5)
+        {
+          _config = value;
+        }
+      }
+
+      uint8_t readRegister(uint8_t reg)
+      {
+        const uint16_t *words = (const uint16_t *)&calibration;
+        if (reg >= 0x88 && reg < 0xA0)
+        {
+          uint16_t word = words[(reg - 0x88) / 2];
+          return reg % 2 == 0 ? word & 0xFF : word >> 8;
+        }
+        switch (reg)
+        {
+        case 0xD0:
+          return Bmp280::chipId;
+        case 0xF3:
+          // measuring bit while a conversion is running
+          return _nextConversionUs != UINT64_MAX && _nextConversionUs - conversionUs() <= Simulator::nowUs() ? 0x08 : 0x00;
+        case 0xF4:
+          return _control;
+        case 0xF5:
+          return _config;
+        case 0xF7:
+          return _adcP >> 12;
+        case 0xF8:
+          return _adcP >> 4;
+        case 0xF9:
+          return _adcP << 4;
+        case 0xFA:
+          return _adcT >> 12;
+        case 0xFB:
+          return _adcT >> 4;
+        case 0xFC:
+          return _adcT << 4;
+        }
+        return 0;
+      }
+
+      // runs all conversions finished since the last read
+      void update()
+      {
+        bool converted = false;
+        while (_nextConversionUs <= Simulator::nowUs())
+        {
+          convert(_nextConversionUs);
+          converted = true;
+          if ((_control & 0x03) == 0x03)
+          {
+            _nextConversionUs += standbyUs() + conversionUs();
+          }
+          else
+          {
+            // forced mode goes back to sleep
+            _control &= ~0x03;
+            _nextConversionUs = UINT64_MAX;
+          }
+        }
+        if (converted)
+        {
+          toRaw();
+        }
+      }
+
+      void convert(uint64_t timeUs)
+      {
+        float pressure = Simulator::pressurePa(_channel, timeUs);
+        float temperature = Simulator::temperatureC(_channel, timeUs);
+        uint8_t filter = (_config >> 2) & 0x07;
+        float coefficient = filter ? 1 << (filter > 4 ? 4 : filter) : 1;
+
+        _hasTemperature = (_control >> 5) != 0;
+        _hasPressure = ((_control >> 2) & 0x07) != 0;
+        if (!_filtered || coefficient == 1)
+        {
+          _pressure = pressure;
+          _temperature = temperature;
+          _filtered = true;
+        }
+        else
+        {
+          _pressure += (pressure - _pressure) / coefficient;
+          _temperature += (temperature - _temperature) / coefficient;
+        }
+      }
+
+      // raw readings that compensate to the filtered values, the formulas are monotonic so bisect them
+      void toRaw()
+      {
+        int32_t targetT = _temperature * 100;
+        int32_t tFine;
+        int32_t low = 0;
+        int32_t high = 0xFFFFF;
+        while (low < high)
+        {
+          int32_t mid = (low + high) / 2;
+          if (Bmp280::compensateTemperature(calibration, mid, tFine) < targetT)
+          {
+            low = mid + 1;
+          }
+          else
+          {
+            high = mid;
+          }
+        }
+        _adcT = _hasTemperature ? low : 0x80000;
+        Bmp280::compensateTemperature(calibration, low, tFine);
+
+        uint32_t targetP = _pressure * 256;
+        low = 0;
+        high = 0xFFFFF;
+        while (low < high)
+        {
+          int32_t mid = (low + high) / 2;
+          if (Bmp280::compensatePressure(calibration, mid, tFine) > targetP)
+          {
+            low = mid + 1;
+          }
+          else
+          {
+            high = mid;
+          }
+        }
+        _adcP = _hasPressure ? low : 0x80000;
+      }
+
+      uint8_t _channel;
+      uint8_t _pointer = 0;
+      uint8_t _control = 0;
+      uint8_t _config = 0;
+      uint64_t _nextConversionUs = UINT64_MAX;
+      bool _filtered = false;
+      bool _hasTemperature = false;
+      bool _hasPressure = false;
+      float _pressure = 0;
+      float _temperature = 0;
+      int32_t _adcP = 0x80000;
+      int32_t _adcT = 0x80000;
+  };
+
+  constexpr Bmp280::Calibration Bmp280Device::calibration;
+
+  class Ds3231Device : public I2cDevice
+  {
+    public:
+      void write(const uint8_t *data, size_t length) override
+      {
+        if (length)
+        {
+          _pointer = data[0];
+        }
+      }
+
+      void read(uint8_t *data, size_t length) override
+      {
+        RtcDateTime now(Simulator::rtcSeconds());
+        uint8_t registers[7] = {now.Second(), now.Minute(), now.Hour(), 1, now.Day(), now.Month(), (uint8_t)(now.Year() - 2000)};
+        for (size_t i = 0; i < length; i++, _pointer++)
+        {
+          data[i] = _pointer < 7 ? toBcd(registers[_pointer]) : 0;
+        }
+      }
+
+    private:
+      static uint8_t toBcd(uint8_t value) { return value + 6 * (value / 10); }
+
+      uint8_t _pointer = 0;
+  };
+
+  Bmp280Device pressureSensor1(0);
+  Bmp280Device pressureSensor2(1);
+  Ds3231Device rtc;
+
+  I2cDevice *device(uint16_t address)
+  {
+    switch (address)
+    {
+    case 0x76:
+      return &pressureSensor1;
+    case 0x77:
+      return &pressureSensor2;
+    case 0x68:
+      return &rtc;
+    }
+    return nullptr;
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+  if (frequency)
+  {
+    _frequency = frequency;
+  }
+  return true;
+}
+
+void TwoWire::setClock(uint32_t frequency)
+{
+  _frequency = frequency;
+}
+
+void TwoWire::beginTransmission(uint16_t address)
+{
+  _txAddress = address;
+  _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  if (_txLength >= sizeof(_txBuffer))
+  {
+    return 0;
+  }
+  _txBuffer[_txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t length)
+{
+  size_t written = 0;
+  while (written < length && write(data[written]))
+  {
+    written++;
+  }
+  return written;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+  busTime(_txLength);
+  I2cDevice *target = device(_txAddress);
+  if (!target)
+  {
+    // address not acknowledged
+    return 2;
+  }
+  target->write(_txBuffer, _txLength);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint16_t address, uint8_t size, bool sendStop)
+{
+  busTime(size);
+  I2cDevice *target = device(address);
+  _rxIndex = 0;
+  _rxLength = 0;
+  if (!target || size > sizeof(_rxBuffer))
+  {
+    return 0;
+  }
+  target->read(_rxBuffer, size);
+  _rxLength = size;
+  return size;
+}
+
+// start, address byte, data bytes with ack bit each, stop
+void TwoWire::busTime(size_t bytes)
+{
+  uint32_t bits = 2 + (1 + bytes) * 9;
+  uint32_t us = (bits * 1000000ull + _frequency - 1) / _frequency;
+  Simulator::i2cTransfer(bytes, us);
+  Simulator::advanceUs(us);
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+static bool isLeapYear(uint16_t year)
+{
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+RtcDateTime::RtcDateTime(uint32_t secondsFrom2000) : _total(secondsFrom2000)
+{
+  uint32_t days = secondsFrom2000 / 86400;
+  uint32_t rest = secondsFrom2000 % 86400;
+
+  _hour = rest / 3600;
+  _minute = rest / 60 % 60;
+  _second = rest % 60;
+
+  _year = 2000;
+  while (days >= (isLeapYear(_year) ? 366u : 365u))
+  {
+    days -= isLeapYear(_year) ? 366 : 365;
+    _year++;
+  }
+  _month = 1;
+  while (true)
+  {
+    uint8_t length = daysInMonth[_month - 1] + (_month == 2 && isLeapYear(_year) ? 1 : 0);
+    if (days < length)
+    {
+      break;
+    }
+    days -= length;
+    _month++;
+  }
+  _day = days + 1;
+}
+
+RtcDateTime::RtcDateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second)
+    : _year(year), _month(month), _day(day), _hour(hour), _minute(minute), _second(second)
+{
+  uint32_t days = day - 1;
+  for (uint16_t y = 2000; y < year; y++)
+  {
+    days += isLeapYear(y) ? 366 : 365;
+  }
+  for (uint8_t m = 1; m < month; m++)
+  {
+    days += daysInMonth[m - 1] + (m == 2 && isLeapYear(year) ? 1 : 0);
+  }
+  _total = ((days * 24 + hour) * 60 + minute) * 60 + second;
+}
@@ -0,0 +1,159 @@
+#include <Arduino.h>
+#include <vector>
+#include <driver/gpio.h>
+#include <driver/spi_master.h>
+
+#include "SimDisplay.h"
+#include "SimKernel.h"
+#include "Simulator.h"
+
+namespace
+{
+  // CPU time the driver needs to set up and queue one transaction at 240 MHz, an estimate for ESP-IDF 3.3/4.x
+  const uint64_t queueUs = 10;
+
+  // transactions in the order they were queued, sized once when the device is added like the
+  // FreeRTOS queues of the driver, so queueing never allocates
+  class TransactionQueue
+  {
+    public:
+      void reserve(size_t size) { _slots.assign(size, nullptr); }
+      bool empty() const { return _count == 0; }
+      size_t size() const { return _count; }
+      spi_transaction_t *front() const { return _slots[_head]; }
+
+      void push_back(spi_transaction_t *transaction)
+      {
+        _slots[(_head + _count) % _slots.size()] = transaction;
+        _count++;
+      }
+
+      void pop_front()
+      {
+        _head = (_head + 1) % _slots.size();
+        _count--;
+      }
+
+    private:
+      std::vector<spi_transaction_t *> _slots;
+      size_t _head = 0;
+      size_t _count = 0;
+  };
+}
+
+struct spi_device_t
+{
+  spi_device_interface_config_t config;
+  TransactionQueue queued;
+  TransactionQueue done;
+  SimKernel::Timer timer;
+
+  uint64_t durationUs(const spi_transaction_t *transaction)
+  {
+    return (transaction->length * 1000000ULL + config.clock_speed_hz - 1) / config.clock_speed_hz;
+  }
+
+  // what happens on the bus, in interrupt context like the real pre/post callbacks
+  void transmit(spi_transaction_t *transaction)
+  {
+    if (config.pre_cb)
+    {
+      config.pre_cb(transaction);
+    }
+    const uint8_t *data = (transaction->flags & SPI_TRANS_USE_TXDATA) ? transaction->tx_data : (const uint8_t *)transaction->tx_buffer;
+    SimDisplay::write(data, transaction->length / 8);
+    if (config.post_cb)
+    {
+      config.post_cb(transaction);
+    }
+  }
+
+  // DMA finished the oldest transaction, start the next one
+  void complete()
+  {
+    spi_transaction_t *transaction = queued.front();
+    queued.pop_front();
+    transmit(transaction);
+    SimDisplay::transfers(-1);
+    done.push_back(transaction);
+    if (!queued.empty())
+    {
+      timer.nextUs = SimKernel::nowUs + durationUs(queued.front());
+      timer.enabled = true;
+    }
+  }
+};
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan)
+{
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config, spi_device_handle_t *handle)
+{
+  spi_device_t *device = new spi_device_t();
+  device->config = *dev_config;
+  device->queued.reserve(dev_config->queue_size);
+  device->done.reserve(dev_config->queue_size);
+  device->timer.fire = [device] { device->complete(); };
+  SimKernel::addTimer(&device->timer);
+  *handle = device;
+  return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait)
+{
+  if ((int)(handle->queued.size() + handle->done.size()) >= handle->config.queue_size)
+  {
+    return ESP_ERR_TIMEOUT;
+  }
+  handle->queued.push_back(trans_desc);
+  SimDisplay::transfers(1);
+  if (handle->queued.size() == 1)
+  {
+    handle->timer.nextUs = SimKernel::nowUs + handle->durationUs(trans_desc);
+    handle->timer.enabled = true;
+  }
+  Simulator::advanceUs(Simulator::cpuTime(queueUs));
+  return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, TickType_t ticks_to_wait)
+{
+  if (handle->done.empty())
+  {
+    uint64_t timeoutUs = ticks_to_wait == portMAX_DELAY ? SimKernel::forever : SimKernel::nowUs + (uint64_t)ticks_to_wait * 1000 * portTICK_PERIOD_MS;
+    if (!SimKernel::block([handle] { return !handle->done.empty(); }, timeoutUs))
+    {
+      return ESP_ERR_TIMEOUT;
+    }
+  }
+  *trans_desc = handle->done.front();
+  handle->done.pop_front();
+  return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+  if (!handle->queued.empty())
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  // the CPU waits for the bus
+  handle->transmit(trans_desc);
+  Simulator::advanceUs(Simulator::cpuTime(queueUs) + handle->durationUs(trans_desc));
+  return ESP_OK;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+  digitalWrite(gpio_num, level);
+  return ESP_OK;
+}
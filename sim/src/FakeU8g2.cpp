@@ -0,0 +1,110 @@
+#include <U8g2lib.h>
+
+// drawing into the framebuffer, no simulator dependencies so the host benchmarks can use it
+
+const u8g2_cb_t u8g2_cb_r0 = {0};
+
+const uint8_t u8g2_font_courR08_tf[] = {5, 8, 0, 0};
+const uint8_t u8g2_font_courR08_tr[] = {5, 8, 0, 0};
+const uint8_t u8g2_font_courB10_tn[] = {7, 10, 0, 0};
+const uint8_t u8g2_font_courB24_tn[] = {17, 24, 0, 0};
+const uint8_t u8g2_font_courB24_tr[] = {17, 24, 0, 0};
+const uint8_t u8g2_font_battery19_tn[] = {9, 19, 0, 0};
+const uint8_t u8g2_font_logisoso38_tn[] = {22, 38, 0, 0};
+const uint8_t u8g2_font_logisoso50_tn[] = {29, 50, 0, 0};
+const uint8_t u8g2_font_logisoso62_tn[] = {36, 62, 0, 0};
+// oblique: starts 2 columns left of the cursor and reaches 3 past the advance
+const uint8_t u8g2_font_helvBO24_tn[] = {19, 24, (uint8_t)-2, 3};
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void U8G2::drawPixel(int16_t x, int16_t y)
+{
+  if (x < 0 || y < 0 || x >= getDisplayWidth() || y >= getDisplayHeight())
+  {
+    return;
+  }
+  // vertical top first bytes, one 128 byte row per 8 pixel page
+  _buffer[(y / 8) * getDisplayWidth() + x] |= 1 << (y % 8);
+}
+
+void U8G2::drawHLine(int16_t x, int16_t y, int16_t w)
+{
+  for (int16_t i = 0; i < w; i++)
+  {
+    drawPixel(x + i, y);
+  }
+}
+
+void U8G2::drawBox(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  for (int16_t j = 0; j < h; j++)
+  {
+    drawHLine(x, y + j, w);
+  }
+}
+
+size_t U8G2::write(uint8_t c)
+{
+  // UTF-8 continuation bytes belong to the previous glyph
+  if (_utf8 && (c & 0xC0) == 0x80)
+  {
+    return 1;
+  }
+  printGlyph(c);
+  return 1;
+}
+
+uint8_t U8G2::drawGlyph(int16_t x, int16_t y, uint16_t encoding)
+{
+  int16_t cursorX = _cursorX;
+  int16_t cursorY = _cursorY;
+  _cursorX = x;
+  _cursorY = y;
+  printGlyph(encoding);
+  uint8_t advance = _direction == 1 ? _cursorY - y : _cursorX - x;
+  _cursorX = cursorX;
+  _cursorY = cursorY;
+  return advance;
+}
+
+void U8G2::printGlyph(uint8_t c)
+{
+  if (!_font)
+  {
+    return;
+  }
+  uint8_t width = _font[0];
+  uint8_t height = _font[1];
+  int8_t offset = (int8_t)_font[2];
+  // columns with pixels, one empty column before the next glyph unless the font overhangs
+  uint8_t columns = width - 1 - offset + _font[3];
+
+  for (uint8_t gy = 0; gy < height; gy++)
+  {
+    for (uint8_t gx = 0; gx < columns; gx++)
+    {
+      bool edge = gx == 0 || gx == columns - 1 || gy == 0 || gy == height - 1;
+      if (c != ' ' && (edge || (gx * 7 + gy * 3 + c) % 5 == 0))
+      {
+        if (_direction == 1)
+        {
+          drawPixel(_cursorX + gy, _cursorY + offset + gx);
+        }
+        else
+        {
+          drawPixel(_cursorX + offset + gx, _cursorY - height + 1 + gy);
+        }
+      }
+    }
+  }
+
+  if (_direction == 1)
+  {
+    _cursorY += width;
+  }
+  else
+  {
+    _cursorX += width;
+  }
+}
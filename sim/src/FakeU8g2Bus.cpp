@@ -0,0 +1,241 @@
+#include <U8g2lib.h>
+
+#include "SimDisplay.h"
+#include "Simulator.h"
+
+namespace
+{
+  // digitalWrite() bit-banging as done by the *_SW_SPI classes: three pin writes and
+  // two 1 us clock pulse delays per bit on the ESP32 at 240 MHz, the pin writes take longer at a lower clock
+  const uint32_t softwareSpiDelayNsPerBit = 2000;
+  const uint32_t softwareSpiPinNsPerBit = 500;
+
+  // init sequence of the u8g2 SSD1309 driver
+  const uint8_t initSequence[] = {0xFD, 0x12, 0xAE, 0xD5, 0xA0, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0xA1, 0xC8,
+                                  0xDA, 0x12, 0x81, 0xDF, 0xD9, 0x82, 0xDB, 0x34, 0xA4, 0xA6};
+
+  const uint8_t oneParameterCommands[] = {0x20, 0x81, 0x8D, 0xA8, 0xAD, 0xD3, 0xD5, 0xD9, 0xDA, 0xDB, 0xFD};
+
+  struct Panel
+  {
+    int dc = 0;
+    uint8_t column = 0;
+    uint8_t page = 0;
+    // parameter bytes still expected by the last command
+    uint8_t parameters = 0;
+    uint8_t memory[128 * 8] = {0};
+    uint8_t expected[128 * 8] = {0};
+    int transfers = 0;
+    bool unverified = false;
+  } panel;
+}
+
+void u8g2_Setup_ssd1309_128x64_noname2_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x8_msg_cb byte_cb, u8x8_msg_cb gpio_and_delay_cb)
+{
+  u8g2->u8x8.byte_cb = byte_cb;
+  u8g2->u8x8.gpio_and_delay_cb = gpio_and_delay_cb;
+}
+
+void u8x8_SetPin_4Wire_SW_SPI(u8x8_t *u8x8, uint8_t clock, uint8_t data, uint8_t cs, uint8_t dc, uint8_t reset)
+{
+  u8x8->clock = clock;
+  u8x8->data = data;
+  u8x8->cs = cs;
+  u8x8->dc = dc;
+  u8x8->reset = reset;
+}
+
+void u8x8_SetPin_4Wire_HW_SPI(u8x8_t *u8x8, uint8_t cs, uint8_t dc, uint8_t reset)
+{
+  u8x8_SetPin_4Wire_SW_SPI(u8x8, U8X8_PIN_NONE, U8X8_PIN_NONE, cs, dc, reset);
+}
+
+uint8_t u8x8_byte_arduino_4wire_sw_spi(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr)
+{
+  switch (msg)
+  {
+  case U8X8_MSG_BYTE_SET_DC:
+    SimDisplay::setDc(arg_int);
+    break;
+  case U8X8_MSG_BYTE_SEND:
+    SimDisplay::write((const uint8_t *)arg_ptr, arg_int);
+    // the CPU toggles every bit itself
+    Simulator::advanceUs((uint64_t)arg_int * 8 * (softwareSpiDelayNsPerBit + Simulator::cpuTime(softwareSpiPinNsPerBit)) / 1000);
+    break;
+  }
+  return 1;
+}
+
+uint8_t u8x8_gpio_and_delay_arduino(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr)
+{
+  if (msg == U8X8_MSG_DELAY_MILLI)
+  {
+    delay(arg_int);
+  }
+  return 1;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void SimDisplay::setDc(int level)
+{
+  panel.dc = level;
+}
+
+void SimDisplay::write(const uint8_t *bytes, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    uint8_t byte = bytes[i];
+    if (panel.dc)
+    {
+      // page addressing mode: the column wraps within the page
+      panel.memory[panel.page * 128 + panel.column] = byte;
+      panel.column = (panel.column + 1) % 128;
+    }
+    else if (panel.parameters)
+    {
+      panel.parameters--;
+    }
+    else if (byte <= 0x0F)
+    {
+      panel.column = (panel.column & 0xF0) | byte;
+    }
+    else if (byte <= 0x1F)
+    {
+      panel.column = ((byte & 0x07) << 4) | (panel.column & 0x0F);
+    }
+    else if (byte >= 0xB0 && byte <= 0xB7)
+    {
+      panel.page = byte & 0x07;
+    }
+    else if (byte == 0x21 || byte == 0x22)
+    {
+      panel.parameters = 2;
+    }
+    else if (memchr(oneParameterCommands, byte, sizeof(oneParameterCommands)))
+    {
+      panel.parameters = 1;
+    }
+  }
+}
+
+void SimDisplay::transfers(int change)
+{
+  panel.transfers += change;
+}
+
+void SimDisplay::expect(const uint8_t *buffer, uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th)
+{
+  panel.unverified = true;
+  for (uint8_t row = ty; row < ty + th; row++)
+  {
+    memcpy(panel.expected + row * 128 + tx * 8, buffer + row * 128 + tx * 8, tw * 8);
+  }
+}
+
+bool SimDisplay::verify()
+{
+  if (!panel.unverified || panel.transfers > 0)
+  {
+    return true;
+  }
+  panel.unverified = false;
+  return memcmp(panel.memory, panel.expected, sizeof(panel.memory)) == 0;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+bool U8G2::begin()
+{
+  u8x8_t *u8x8 = getU8x8();
+  u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_GPIO_AND_DELAY_INIT, 0, nullptr);
+  byteCall(U8X8_MSG_BYTE_INIT);
+  // reset pulse
+  u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_DELAY_MILLI, 1, nullptr);
+  u8x8->gpio_and_delay_cb(u8x8, U8X8_MSG_DELAY_MILLI, 10, nullptr);
+  sendCommands(initSequence, sizeof(initSequence));
+  // u8x8_ClearDisplay() like u8g2_begin(): one zeroed tile at a time from the stack, not from the
+  // framebuffer, so a transport has to handle data it cannot keep a pointer to
+  uint8_t tile[8] = {0};
+  clearBuffer();
+  SimDisplay::expect(_buffer, 0, 0, tileWidth, tileHeight);
+  for (uint8_t row = 0; row < tileHeight; row++)
+  {
+    for (uint8_t column = 0; column < tileWidth; column++)
+    {
+      drawTiles(column, row, 1, tile);
+    }
+  }
+  setPowerSave(0);
+  return true;
+}
+
+void U8G2::setPowerSave(uint8_t is_enable)
+{
+  uint8_t command = is_enable ? 0xAE : 0xAF;
+  sendCommands(&command, 1);
+}
+
+// like u8g2_ClearDisplay(): sends the cleared framebuffer
+void U8G2::clearDisplay()
+{
+  clearBuffer();
+  SimDisplay::expect(_buffer, 0, 0, tileWidth, tileHeight);
+  for (uint8_t row = 0; row < tileHeight; row++)
+  {
+    drawTiles(0, row, tileWidth, _buffer + row * getDisplayWidth());
+  }
+}
+
+void U8G2::sendBuffer()
+{
+  updateDisplayArea(0, 0, tileWidth, tileHeight);
+}
+
+void U8G2::updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th)
+{
+  Simulator::displayTransfer(tw * th * 8);
+  SimDisplay::expect(_buffer, tx, ty, tw, th);
+  // bit-banged from the render task, the loop may look at the panel while a frame is half sent
+  SimDisplay::transfers(1);
+  for (uint8_t row = ty; row < ty + th; row++)
+  {
+    drawTiles(tx, row, tw, _buffer + row * getDisplayWidth() + tx * 8);
+  }
+  SimDisplay::transfers(-1);
+}
+
+uint8_t U8G2::byteCall(uint8_t msg, uint8_t arg_int, const void *arg_ptr)
+{
+  return u8g2.u8x8.byte_cb(&u8g2.u8x8, msg, arg_int, (void *)arg_ptr);
+}
+
+// like u8x8_cad_001: every command byte on its own with DC low
+void U8G2::sendCommands(const uint8_t *commands, size_t length)
+{
+  byteCall(U8X8_MSG_BYTE_START_TRANSFER);
+  for (size_t i = 0; i < length; i++)
+  {
+    byteCall(U8X8_MSG_BYTE_SET_DC, 0);
+    byteCall(U8X8_MSG_BYTE_SEND, 1, commands + i);
+  }
+  byteCall(U8X8_MSG_BYTE_END_TRANSFER);
+}
+
+// one tile row like the draw tile message of the SSD1309 driver: column, page, then the data
+void U8G2::drawTiles(uint8_t tx, uint8_t ty, uint8_t tw, const uint8_t *tiles)
+{
+  uint8_t x = tx * 8;
+  uint8_t commands[] = {(uint8_t)(0x10 | (x >> 4)), (uint8_t)(x & 0x0F), (uint8_t)(0xB0 | ty)};
+
+  byteCall(U8X8_MSG_BYTE_START_TRANSFER);
+  for (uint8_t command : commands)
+  {
+    byteCall(U8X8_MSG_BYTE_SET_DC, 0);
+    byteCall(U8X8_MSG_BYTE_SEND, 1, &command);
+  }
+  byteCall(U8X8_MSG_BYTE_SET_DC, 1);
+  byteCall(U8X8_MSG_BYTE_SEND, tw * 8, tiles);
+  byteCall(U8X8_MSG_BYTE_END_TRANSFER);
+}
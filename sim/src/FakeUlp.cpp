@@ -0,0 +1,281 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <driver/rtc_io.h>
+#include <esp32/ulp.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/sens_reg.h>
+
+#include "SimUlp.h"
+#include "Simulator.h"
+
+RTC_DATA_ATTR uint32_t simRtcSlowMemory[SIM_ULP_RESERVED_WORDS];
+
+namespace
+{
+  // RTC_FAST_CLK the ULP runs on
+  const uint32_t cyclesPerUs = 8;
+  // a run that does not halt after that many instructions is a bug in the program
+  const uint32_t maxInstructions = 10000;
+
+  struct Register
+  {
+    uint32_t address;
+    uint32_t value;
+  };
+
+  // registers of the RTC domain keep their value in deep sleep, so they live in RTC memory
+  RTC_DATA_ATTR Register registers[16];
+  RTC_DATA_ATTR uint32_t entryPoint;
+
+  SimUlp::Stats ulpStats;
+
+  Register *findRegister(uint32_t address, bool create)
+  {
+    for (Register &reg : registers)
+    {
+      if (reg.address == address || (create && reg.address == 0))
+      {
+        reg.address = address;
+        return &reg;
+      }
+    }
+    return nullptr;
+  }
+
+  // slave address from SENS_I2C_SLAVE_ADDRn, two 11 bit fields per register starting at SENS_SAR_SLAVE_ADDR1_REG
+  uint8_t slaveAddress(uint8_t slave)
+  {
+    uint32_t value = READ_PERI_REG(SENS_SAR_SLAVE_ADDR1_REG + slave / 2 * 4);
+    return (value >> (slave % 2 ? 0 : SENS_I2C_SLAVE_ADDR0_S)) & SENS_I2C_SLAVE_ADDR0_V;
+  }
+
+  void cycles(uint32_t count)
+  {
+    Simulator::advanceUs((count + cyclesPerUs - 1) / cyclesPerUs);
+  }
+}
+
+uint32_t simReadRegister(uint32_t address)
+{
+  Register *reg = findRegister(address, false);
+  return reg ? reg->value : 0;
+}
+
+void simWriteRegister(uint32_t address, uint32_t value)
+{
+  Register *reg = findRegister(address, true);
+  if (!reg)
+  {
+    fprintf(stderr, "[sim] out of fake RTC registers for 0x%08x\n", address);
+    abort();
+  }
+  reg->value = value;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+esp_err_t ulp_process_macros_and_load(uint32_t load_addr, const ulp_insn_t *program, size_t *psize)
+{
+  // labels take no space, every other macro becomes one instruction word
+  uint32_t labels[2048] = {0};
+  uint32_t address = load_addr;
+  for (size_t i = 0; i < *psize; i++)
+  {
+    if (program[i].branch.opcode == SIM_ULP_LABEL)
+    {
+      labels[program[i].branch.target] = address;
+    }
+    else
+    {
+      address++;
+    }
+  }
+  if (address > SIM_ULP_RESERVED_WORDS)
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  address = load_addr;
+  for (size_t i = 0; i < *psize; i++)
+  {
+    ulp_insn_t instruction = program[i];
+    switch (instruction.branch.opcode)
+    {
+    case SIM_ULP_LABEL:
+      continue;
+    case SIM_ULP_BL:
+    case SIM_ULP_BGE:
+    case SIM_ULP_BX:
+      instruction.branch.target = labels[instruction.branch.target];
+      break;
+    }
+    RTC_SLOW_MEM[address++] = instruction.instruction;
+  }
+  *psize = address - load_addr;
+  return ESP_OK;
+}
+
+esp_err_t ulp_run(uint32_t entry_point)
+{
+  entryPoint = entry_point;
+  SET_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN);
+  return ESP_OK;
+}
+
+esp_err_t ulp_set_wakeup_period(size_t period_index, uint32_t period_us)
+{
+  if (period_index != 0)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  WRITE_PERI_REG(SENS_ULP_CP_SLEEP_CYC0_REG, period_us);
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ulp_wakeup()
+{
+  Simulator::setWakeupUlp();
+  return ESP_OK;
+}
+
+esp_err_t rtc_gpio_init(gpio_num_t gpio_num)
+{
+  return ESP_OK;
+}
+
+esp_err_t rtc_gpio_deinit(gpio_num_t gpio_num)
+{
+  return ESP_OK;
+}
+
+esp_err_t rtc_gpio_set_direction(gpio_num_t gpio_num, rtc_gpio_mode_t mode)
+{
+  return ESP_OK;
+}
+
+esp_err_t rtc_gpio_pullup_en(gpio_num_t gpio_num)
+{
+  return ESP_OK;
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+bool SimUlp::running()
+{
+  return READ_PERI_REG(RTC_CNTL_STATE0_REG) & RTC_CNTL_ULP_CP_SLP_TIMER_EN;
+}
+
+uint64_t SimUlp::periodUs()
+{
+  return READ_PERI_REG(SENS_ULP_CP_SLEEP_CYC0_REG);
+}
+
+bool SimUlp::run()
+{
+  // registers are 16 bit, memory keeps the upper half of a word when the ULP stores to it
+  uint16_t r[4] = {0, 0, 0, 0};
+  uint32_t pc = entryPoint;
+  bool woke = false;
+  uint64_t start = Simulator::nowUs();
+
+  ulpStats.runs++;
+  for (uint32_t executed = 0; executed < maxInstructions && pc < SIM_ULP_RESERVED_WORDS; executed++)
+  {
+    ulp_insn_t instruction;
+    instruction.instruction = RTC_SLOW_MEM[pc++];
+    uint16_t imm = instruction.alu.imm;
+    uint8_t rd = instruction.alu.rd;
+    uint8_t rs1 = instruction.alu.rs1;
+
+    // cycle counts of the ESP32 technical reference manual
+    switch (instruction.alu.opcode)
+    {
+    case SIM_ULP_HALT:
+      cycles(2);
+      ulpStats.wakes += woke;
+      ulpStats.busyUs += Simulator::nowUs() - start;
+      return woke;
+    case SIM_ULP_WAKE:
+      woke = true;
+      cycles(6);
+      break;
+    case SIM_ULP_DELAY:
+      cycles(imm);
+      break;
+    case SIM_ULP_MOVI:
+      r[rd] = imm;
+      cycles(6);
+      break;
+    case SIM_ULP_MOVR:
+      r[rd] = r[rs1];
+      cycles(6);
+      break;
+    case SIM_ULP_ADDI:
+      r[rd] = r[rs1] + imm;
+      cycles(6);
+      break;
+    case SIM_ULP_LSHI:
+      r[rd] = r[rs1] << (imm & 0x0F);
+      cycles(6);
+      break;
+    case SIM_ULP_ORR:
+      r[rd] = r[rs1] | r[instruction.alu.rs2];
+      cycles(6);
+      break;
+    case SIM_ULP_LD:
+      r[rd] = RTC_SLOW_MEM[(r[rs1] + imm) % SIM_ULP_RESERVED_WORDS];
+      cycles(8);
+      break;
+    case SIM_ULP_ST:
+    {
+      uint32_t &word = RTC_SLOW_MEM[(r[rs1] + imm) % SIM_ULP_RESERVED_WORDS];
+      word = (word & 0xFFFF0000) | r[rd];
+      cycles(8);
+      break;
+    }
+    case SIM_ULP_I2C_READ:
+    case SIM_ULP_I2C_WRITE:
+    {
+      uint8_t address = slaveAddress(instruction.i2c.slave);
+      ulpStats.i2cTransactions++;
+      Wire.beginTransmission(address);
+      Wire.write(instruction.i2c.sub);
+      if (instruction.i2c.opcode == SIM_ULP_I2C_WRITE)
+      {
+        Wire.write(instruction.i2c.value);
+        Wire.endTransmission();
+      }
+      else
+      {
+        Wire.endTransmission(false);
+        Wire.requestFrom(address, (uint8_t)1);
+        r[R0] = Wire.available() ? Wire.read() : 0;
+      }
+      break;
+    }
+    case SIM_ULP_BL:
+    case SIM_ULP_BGE:
+    case SIM_ULP_BX:
+    {
+      uint8_t opcode = instruction.branch.opcode;
+      if (opcode == SIM_ULP_BX || (opcode == SIM_ULP_BL && r[R0] < instruction.branch.imm) ||
+          (opcode == SIM_ULP_BGE && r[R0] >= instruction.branch.imm))
+      {
+        pc = instruction.branch.target;
+      }
+      cycles(4);
+      break;
+    }
+    default:
+      fprintf(stderr, "[sim] ULP: invalid instruction 0x%08x at %u\n", instruction.instruction, pc - 1);
+      abort();
+    }
+  }
+  fprintf(stderr, "[sim] ULP program at %u does not halt\n", entryPoint);
+  abort();
+}
+
+const SimUlp::Stats &SimUlp::stats()
+{
+  return ulpStats;
+}
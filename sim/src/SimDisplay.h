@@ -0,0 +1,27 @@
+#ifndef SIMDISPLAY_H
+#define SIMDISPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SSD1309 panel on the simulated board: interprets the command and data bytes
+// that reach it over SPI and keeps its display memory, so the sim can check that
+// every transport shows exactly what the firmware drew.
+namespace SimDisplay
+{
+  // board wiring of the data/command line
+  const uint8_t dcPin = 12;
+
+  void setDc(int level);
+  void write(const uint8_t *bytes, size_t length);
+
+  // SPI transactions to the panel still on the bus
+  void transfers(int change);
+
+  // the firmware sent this area of its framebuffer, the panel has to show it once the transfers are done
+  void expect(const uint8_t *buffer, uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+  // false if the bus is idle after a transfer and the panel differs from what was sent
+  bool verify();
+}
+
+#endif // end of SIMDISPLAY_H
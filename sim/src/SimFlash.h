@@ -0,0 +1,30 @@
+#ifndef SIMFLASH_H
+#define SIMFLASH_H
+
+#include <esp_partition.h>
+#include <stdint.h>
+
+// Data partitions of the simulated flash. The memory is shared between all
+// boots of a run (every boot is a forked process), like the real flash chip.
+namespace SimFlash
+{
+  const uint32_t sectorSize = 4096;
+
+  struct Usage
+  {
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+    uint32_t erases;
+    uint32_t minSectorErases;
+    uint32_t maxSectorErases;
+  };
+
+  // reads the partition table, optionally loading a flash image of an earlier run
+  bool begin(const char *partitionTable, const char *image);
+  bool save(const char *image);
+  const esp_partition_t *partition(int index);
+  Usage usage(const esp_partition_t *partition);
+  void resetUsage();
+}
+
+#endif // end of SIMFLASH_H
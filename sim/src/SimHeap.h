@@ -0,0 +1,20 @@
+#ifndef SIMHEAP_H
+#define SIMHEAP_H
+
+#include <stdint.h>
+
+// Heap tracing: malloc(), calloc() and realloc() of the whole process, and with them every
+// new, count while tracing is on. The simulator turns it on once setup() returned, so any
+// allocation on the way through loop() and the firmware tasks shows up, with the call stack
+// of the first ones on stderr.
+namespace SimHeap
+{
+  // call stacks printed per boot, the rest is only counted
+  const uint32_t reportedStacks = 3;
+
+  void startTracing();
+  void stopTracing();
+  uint32_t allocations();
+}
+
+#endif // end of SIMHEAP_H
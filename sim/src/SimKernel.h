@@ -0,0 +1,38 @@
+#ifndef SIMKERNEL_H
+#define SIMKERNEL_H
+
+#include <functional>
+#include <stdint.h>
+
+// Scheduler behind the FreeRTOS and timer fakes. The Arduino loop runs on the
+// main thread; every other task is a host thread that only runs while the main
+// thread waits for it, so there is never more than one thread active.
+namespace SimKernel
+{
+  const uint64_t forever = UINT64_MAX;
+
+  struct Timer
+  {
+    uint64_t periodUs = 0;
+    uint64_t nextUs = 0;
+    bool autoreload = false;
+    bool enabled = false;
+    std::function<void()> fire;
+  };
+
+  // virtual time since the start of the trace
+  extern uint64_t nowUs;
+
+  void addTimer(Timer *timer);
+  void removeTimer(Timer *timer);
+
+  // runs timers and tasks up to the given time, only called from the main thread
+  void advanceTo(uint64_t targetUs);
+  // waits until ready() is true or the absolute timeout passed, returns ready()
+  bool block(const std::function<bool()> &ready, uint64_t timeoutUs);
+  // lets tasks that became ready run, does nothing when called from a task
+  void runReadyTasks();
+  bool inTask();
+}
+
+#endif // end of SIMKERNEL_H
@@ -0,0 +1,27 @@
+#ifndef SIMULP_H
+#define SIMULP_H
+
+#include <stdint.h>
+
+// ULP coprocessor, run by the simulator while the main cores are in deep sleep.
+// Program, data and the RTC registers live in RTC memory like on the target.
+namespace SimUlp
+{
+  struct Stats
+  {
+    uint32_t runs;
+    uint32_t wakes;
+    uint32_t i2cTransactions;
+    uint64_t busyUs; // ULP running, the main cores asleep
+  };
+
+  // the ULP timer is enabled
+  bool running();
+  // time from the end of one run of the program to the start of the next one
+  uint64_t periodUs();
+  // one run from the entry point until I_HALT(), moves the virtual clock by its cycles; true if it woke the main cores
+  bool run();
+  const Stats &stats();
+}
+
+#endif // end of SIMULP_H
@@ -0,0 +1,998 @@
+#include "Simulator.h"
+#include "SimDisplay.h"
+#include "SimFlash.h"
+#include "SimHeap.h"
+#include "SimKernel.h"
+#include "SimUlp.h"
+
+#include <Arduino.h>
+#include <JumpLog.h>
+#include <JumpTrack.h>
+#include <RtcDS3231.h>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+void setup();
+void loop();
+
+// RTC slow memory of the firmware, see RTC_DATA_ATTR in Arduino.h
+extern uint8_t __start_rtc_slow_data[] __attribute__((weak));
+extern uint8_t __stop_rtc_slow_data[] __attribute__((weak));
+
+namespace
+{
+  const char *defaultTrace = "sim/traces/jump_4000m.csv";
+  const char *partitionTable = "partitions.csv";
+  const uint32_t traceStartRtcSeconds = 645962400; // 20.06.2020 10:00:00
+  const size_t rtcMemorySize = 8192;
+
+  // log-linear histogram of loop durations: 8 buckets per power of two
+  const int histogramBuckets = 8 * 40;
+
+  struct TracePoint
+  {
+    uint64_t timeUs;
+    float pressure[2];
+    float temperature;
+  };
+
+  struct ButtonPress
+  {
+    uint64_t startUs;
+    uint64_t endUs;
+    uint8_t pin;
+  };
+
+  // a sensor that freezes on the value at startUs, or reads offsetPa more
+  struct SensorFault
+  {
+    uint64_t startUs;
+    uint64_t endUs;
+    uint8_t channel;
+    bool stuck;
+    float offsetPa;
+  };
+
+  // everything a boot hands back to the next one, sent from the child process over a pipe
+  struct BootReport
+  {
+    bool slept;
+    uint64_t endUs;
+    uint64_t setupUs;
+    uint64_t setupFlashRead;
+    uint64_t wakeupTimerUs;
+    int wakeupPin;
+    int wakeupLevel;
+    bool wakeupUlp;
+    uint64_t loops;
+    uint64_t loopNsTotal;
+    uint64_t loopNsMax;
+    uint32_t loopHistogram[histogramBuckets];
+    // virtual time spent inside loop(): I2C, SPI, flash and delays the firmware waits for
+    uint64_t loopBusyUsTotal;
+    uint64_t loopBusyUsMax;
+    uint32_t loopBusyHistogram[histogramBuckets];
+    // virtual time the loop task was blocked waiting for the next job, light sleep included
+    uint64_t loopIdleUs;
+    uint32_t lightSleeps;
+    uint64_t lightSleepUs;
+    // virtual time at each of cpuClocks
+    uint64_t cpuClockUs[4];
+    uint32_t modeChanges;
+    uint32_t displayFrames;
+    uint64_t displayBytes;
+    uint32_t displayMismatches;
+    uint32_t i2cTransactions;
+    uint64_t i2cBytes;
+    uint64_t i2cBusUs;
+    // malloc(), calloc(), realloc() and new after setup() returned
+    uint32_t heapAllocations;
+    size_t rtcSize;
+    uint8_t rtc[rtcMemorySize];
+  };
+
+  std::vector<TracePoint> trace;
+  // "# event,<name>,<ms>" lines of the trace: when the exit, deployment and landing really happened
+  std::map<std::string, uint64_t> traceEvents;
+  std::vector<ButtonPress> presses;
+  std::vector<SensorFault> sensorFaults;
+  const char *flashImage = nullptr;
+  const char *trackCsv = nullptr;
+  uint32_t logbookFill = 0;
+  bool logbookCheck = false;
+  uint32_t logbookFailures = 0;
+  uint64_t stepUs = 0;
+  bool serialOutput = true;
+  bool pmSupported = true;
+  bool heapCheck = false;
+  const uint32_t cpuClocks[] = {240, 160, 80, 40};
+  uint32_t clockMhz = 240;
+  uint64_t cpuClockSince = 0;
+  float batteryVoltage = 4.05;
+
+  uint64_t &now = SimKernel::nowUs;
+  uint64_t bootStart = 0;
+  int cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  size_t traceCursor = 0;
+  int reportFd = -1;
+  BootReport report;
+  uint64_t bootFlashRead = 0;
+  uint64_t gpioWakeupLow = 0; // bit per pin
+  bool gpioWakeupEnabled = false;
+
+  uint64_t flashBytesRead()
+  {
+    uint64_t bytes = 0;
+    for (int i = 0; SimFlash::partition(i); i++)
+    {
+      bytes += SimFlash::usage(SimFlash::partition(i)).bytesRead;
+    }
+    return bytes;
+  }
+
+  int histogramBucket(uint64_t ns)
+  {
+    if (ns < 8)
+    {
+      return ns;
+    }
+    int octave = 63 - __builtin_clzll(ns);
+    int bucket = (octave - 2) * 8 + ((ns >> (octave - 3)) & 7);
+    return bucket < histogramBuckets ? bucket : histogramBuckets - 1;
+  }
+
+  uint64_t histogramValue(int bucket)
+  {
+    if (bucket < 8)
+    {
+      return bucket;
+    }
+    int octave = bucket / 8 + 2;
+    return (uint64_t)(8 + bucket % 8) << (octave - 3);
+  }
+
+  uint64_t histogramPercentile(const uint32_t *histogram, uint64_t count, double percentile)
+  {
+    uint64_t target = count * percentile;
+    uint64_t seen = 0;
+    for (int i = 0; i < histogramBuckets; i++)
+    {
+      seen += histogram[i];
+      if (seen > target)
+      {
+        return histogramValue(i);
+      }
+    }
+    return histogramValue(histogramBuckets - 1);
+  }
+
+  bool loadTrace(const char *path)
+  {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+      char name[32];
+      double timeMs;
+      if (sscanf(line.c_str(), "# event,%31[^,],%lf", name, &timeMs) == 2)
+      {
+        traceEvents[name] = timeMs * 1000;
+        continue;
+      }
+      if (line.empty() || line[0] == '#')
+      {
+        continue;
+      }
+      TracePoint point;
+      if (sscanf(line.c_str(), "%lf,%f,%f,%f", &timeMs, &point.pressure[0], &point.pressure[1], &point.temperature) != 4)
+      {
+        continue;
+      }
+      point.timeUs = timeMs * 1000;
+      trace.push_back(point);
+    }
+    return trace.size() > 1;
+  }
+
+  // linear interpolation between the two trace points around the given time
+  float traceValue(float TracePoint::*field, uint8_t channel, uint64_t now)
+  {
+    while (traceCursor + 2 < trace.size() && trace[traceCursor + 1].timeUs <= now)
+    {
+      traceCursor++;
+    }
+    while (traceCursor > 0 && trace[traceCursor].timeUs > now)
+    {
+      traceCursor--;
+    }
+    const TracePoint &a = trace[traceCursor];
+    const TracePoint &b = trace[traceCursor + 1];
+    float t = now <= a.timeUs ? 0 : now >= b.timeUs ? 1 : (float)(now - a.timeUs) / (b.timeUs - a.timeUs);
+    const float *va = field ? &(a.*field) : a.pressure;
+    const float *vb = field ? &(b.*field) : b.pressure;
+    return va[channel] + (vb[channel] - va[channel]) * t;
+  }
+
+  float traceAltitude()
+  {
+    // without the --sensor-fault misreadings
+    return 44330 * (1.0 - pow(traceValue(nullptr, 0, now) / trace[0].pressure[0], 0.1903));
+  }
+
+  void accountCpuClock()
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      if (cpuClocks[i] == clockMhz)
+      {
+        report.cpuClockUs[i] += now - cpuClockSince;
+      }
+    }
+    cpuClockSince = now;
+  }
+
+  [[noreturn]] void finishBoot(bool slept)
+  {
+    SimHeap::stopTracing();
+    report.heapAllocations = SimHeap::allocations();
+    accountCpuClock();
+    report.slept = slept;
+    report.endUs = now;
+    if (!report.setupUs)
+    {
+      report.setupUs = now - bootStart;
+      report.setupFlashRead = flashBytesRead() - bootFlashRead;
+    }
+    report.rtcSize = __start_rtc_slow_data ? __stop_rtc_slow_data - __start_rtc_slow_data : 0;
+    memcpy(report.rtc, __start_rtc_slow_data, report.rtcSize);
+    fflush(stdout);
+    const uint8_t *data = (const uint8_t *)&report;
+    size_t left = sizeof(report);
+    while (left)
+    {
+      ssize_t written = write(reportFd, data, left);
+      if (written <= 0)
+      {
+        break;
+      }
+      data += written;
+      left -= written;
+    }
+    _exit(0);
+  }
+
+  // one power cycle of the ESP32 from reset to deep sleep, runs in a forked child so
+  // every global and static starts from its initial value like after a real reset
+  [[noreturn]] void runBoot()
+  {
+    uint64_t traceEnd = trace.back().timeUs;
+    report = BootReport();
+    report.wakeupPin = -1;
+    // every boot starts at the default clock
+    cpuClockSince = now;
+
+    bootFlashRead = flashBytesRead();
+    setup();
+    report.setupUs = now - bootStart;
+    report.setupFlashRead = flashBytesRead() - bootFlashRead;
+    report.loopIdleUs = 0;
+    SimHeap::startTracing();
+
+    while (now < traceEnd)
+    {
+      auto start = std::chrono::steady_clock::now();
+      uint64_t virtualStart = now;
+      uint64_t idleStart = report.loopIdleUs;
+      loop();
+      uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+      uint64_t busyUs = now - virtualStart - (report.loopIdleUs - idleStart);
+      if (!SimDisplay::verify())
+      {
+        report.displayMismatches++;
+      }
+      report.loopBusyUsTotal += busyUs;
+      report.loopBusyUsMax = busyUs > report.loopBusyUsMax ? busyUs : report.loopBusyUsMax;
+      report.loopBusyHistogram[histogramBucket(busyUs * 1000)]++;
+      report.loops++;
+      report.loopNsTotal += ns;
+      report.loopNsMax = ns > report.loopNsMax ? ns : report.loopNsMax;
+      report.loopHistogram[histogramBucket(ns)]++;
+      Simulator::advanceUs(stepUs);
+    }
+    finishBoot(false);
+  }
+
+  // the ULP program runs on its timer from the start of deep sleep until another wakeup source,
+  // true with the clock at the end of the run that woke the main cores
+  bool runUlp(uint64_t sleepUs, uint64_t untilUs)
+  {
+    now = sleepUs;
+    while (SimUlp::running() && SimUlp::periodUs() && now + SimUlp::periodUs() < untilUs)
+    {
+      SimKernel::advanceTo(now + SimUlp::periodUs());
+      if (SimUlp::run())
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // with --logbook-check, after every jump: a new JumpLog finds it while reading no more than the
+  // sector headers and one bisection of the newest sector, reads it back, and the sectors were erased
+  // equally often give or take one
+  void checkLogbook(const JumpRecord &appended)
+  {
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "jumplog");
+    uint32_t bisections = 0;
+    while ((1u << bisections) <= JumpLog::recordsPerSector)
+    {
+      bisections++;
+    }
+    uint64_t maxRead = (partition->size / JumpLog::sectorSize + bisections) * sizeof(JumpRecord);
+
+    JumpLog log;
+    uint64_t readBefore = SimFlash::usage(partition).bytesRead;
+    bool begun = log.begin();
+    uint64_t read = SimFlash::usage(partition).bytesRead - readBefore;
+    JumpRecord record;
+    bool found = begun && log.lastJumpNumber() == appended.jumpNumber && log.read(appended.jumpNumber, record) &&
+                 memcmp(&record, &appended, sizeof(record)) == 0;
+    SimFlash::Usage usage = SimFlash::usage(partition);
+    if (!found || read > maxRead || usage.maxSectorErases - usage.minSectorErases > 1)
+    {
+      // the first failure says enough
+      if (!logbookFailures)
+      {
+        printf("[sim] FAIL logbook after jump %u: %s, begin() read %llu of at most %llu bytes, %u..%u erases per sector\n",
+               appended.jumpNumber, found ? "found" : "not found", (unsigned long long)read, (unsigned long long)maxRead,
+               usage.minSectorErases, usage.maxSectorErases);
+      }
+      logbookFailures++;
+    }
+  }
+
+  // logbook with the given number of earlier jumps, so a replay starts from a long used flash
+  void fillLogbook(uint32_t jumps)
+  {
+    JumpLog log;
+    if (!log.begin())
+    {
+      return;
+    }
+    for (uint32_t i = 0; i < jumps; i++)
+    {
+      JumpRecord record;
+      memset(&record, 0, sizeof(record));
+      record.date = traceStartRtcSeconds - (jumps - i) * 3600;
+      record.exitAltitude = 4000;
+      record.deploymentAltitude = 1000;
+      record.freefallTime = 55;
+      record.canopyTime = 240;
+      record.maxVerticalSpeed = -55;
+      log.append(record);
+      if (logbookCheck)
+      {
+        checkLogbook(record);
+      }
+    }
+    SimFlash::Usage usage = SimFlash::usage(esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "jumplog"));
+    printf("[sim] logbook filled with %u jumps: %u sector erases (%u..%u per sector)\n", jumps, usage.erases,
+           usage.minSectorErases, usage.maxSectorErases);
+    if (logbookCheck)
+    {
+      printf("[sim] logbook check: %u of %u jumps failed\n", logbookFailures, jumps);
+    }
+    SimFlash::resetUsage();
+    now = trace.front().timeUs;
+  }
+
+  // decodes the track of a jump from flash, optionally writing it as CSV
+  void printTrack(uint32_t jumpNumber)
+  {
+    static JumpTrack track;
+    static uint8_t data[JumpTrack::bufferSize];
+    size_t length;
+    uint32_t samples;
+    if (!track.begin() || !track.load(jumpNumber, data, sizeof(data), length, samples))
+    {
+      printf("[sim] no track for jump %u\n", jumpNumber);
+      return;
+    }
+
+    FILE *csv = trackCsv ? fopen(trackCsv, "w") : nullptr;
+    if (csv)
+    {
+      fprintf(csv, "time_ms,altitude_m,vertical_speed_ms\n");
+    }
+    TrackDecoder decoder(data, length);
+    TrackSample sample = {0, 0, 0};
+    uint32_t decoded = 0;
+    int32_t fastest = 0;
+    while (decoder.next(sample))
+    {
+      decoded++;
+      fastest = sample.verticalSpeed < fastest ? sample.verticalSpeed : fastest;
+      if (csv)
+      {
+        fprintf(csv, "%u,%.1f,%.1f\n", sample.timeMs, sample.altitude / 10.0, sample.verticalSpeed / 10.0);
+      }
+    }
+    if (csv)
+    {
+      fclose(csv);
+    }
+    printf("[sim] track #%u: %u samples%s in %zu bytes (%.2f bytes/sample), %.1f s, landing at %.1f m, max %.1f m/s\n",
+           jumpNumber, decoded, decoded == samples ? "" : " (SAMPLE COUNT MISMATCH)", length, (double)length / decoded,
+           sample.timeMs / 1000.0, sample.altitude / 10.0, fastest / 10.0);
+  }
+
+  void printLogbook()
+  {
+    JumpLog log;
+    JumpRecord record;
+    if (!log.begin() || log.lastJumpNumber() == 0)
+    {
+      return;
+    }
+    printf("[sim] logbook: jumps %u to %u\n", log.firstJumpNumber(), log.lastJumpNumber());
+    uint32_t first = log.lastJumpNumber() > 3 ? log.lastJumpNumber() - 2 : 1;
+    for (uint32_t jump = first; jump <= log.lastJumpNumber(); jump++)
+    {
+      if (!log.read(jump, record))
+      {
+        printf("[sim]   #%u unreadable\n", jump);
+        continue;
+      }
+      RtcDateTime date(record.date);
+      printf("[sim]   #%u %02u.%02u.%04u %02u:%02u exit %d m, deployment %d m, freefall %u s, canopy %u s, max %d m/s",
+             record.jumpNumber, date.Day(), date.Month(), date.Year(), date.Hour(), date.Minute(), record.exitAltitude,
+             record.deploymentAltitude, record.freefallTime, record.canopyTime, record.maxVerticalSpeed);
+      if (record.sensorFaults[0] || record.sensorFaults[1])
+      {
+        printf(", sensor faults %u / %u", record.sensorFaults[0], record.sensorFaults[1]);
+      }
+      printf("\n");
+    }
+    printTrack(log.lastJumpNumber());
+  }
+
+  bool parseArguments(int argc, char **argv, const char *&tracePath)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (arg == "--quiet")
+      {
+        serialOutput = false;
+      }
+      else if (arg == "--no-pm")
+      {
+        pmSupported = false;
+      }
+      else if (arg == "--heap-check")
+      {
+        heapCheck = true;
+      }
+      else if (arg == "--step-ms" && i + 1 < argc)
+      {
+        stepUs = atof(argv[++i]) * 1000;
+      }
+      else if (arg == "--flash" && i + 1 < argc)
+      {
+        flashImage = argv[++i];
+      }
+      else if (arg == "--track-csv" && i + 1 < argc)
+      {
+        trackCsv = argv[++i];
+      }
+      else if (arg == "--logbook-fill" && i + 1 < argc)
+      {
+        logbookFill = atoi(argv[++i]);
+      }
+      else if (arg == "--logbook-check")
+      {
+        logbookCheck = true;
+      }
+      else if (arg == "--battery" && i + 1 < argc)
+      {
+        batteryVoltage = atof(argv[++i]);
+      }
+      else if (arg == "--press" && i + 1 < argc)
+      {
+        // --press <seconds>:<pin>:<milliseconds>
+        double seconds;
+        unsigned pin;
+        unsigned duration;
+        if (sscanf(argv[++i], "%lf:%u:%u", &seconds, &pin, &duration) != 3)
+        {
+          return false;
+        }
+        presses.push_back({(uint64_t)(seconds * 1e6), (uint64_t)(seconds * 1e6) + duration * 1000ull, (uint8_t)pin});
+      }
+      else if (arg == "--sensor-fault" && i + 1 < argc)
+      {
+        // --sensor-fault <seconds>:<sensor 1|2>:stuck:<milliseconds> or <seconds>:<sensor>:<pascal>:<milliseconds>
+        double seconds;
+        unsigned sensor;
+        char kind[16];
+        unsigned duration;
+        if (sscanf(argv[++i], "%lf:%u:%15[^:]:%u", &seconds, &sensor, kind, &duration) != 4 || sensor < 1 || sensor > 2)
+        {
+          return false;
+        }
+        bool stuck = strcmp(kind, "stuck") == 0;
+        sensorFaults.push_back({(uint64_t)(seconds * 1e6), (uint64_t)(seconds * 1e6) + duration * 1000ull,
+                                (uint8_t)(sensor - 1), stuck, stuck ? 0 : (float)atof(kind)});
+      }
+      else if (arg[0] != '-')
+      {
+        tracePath = argv[i];
+      }
+      else
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+uint64_t Simulator::nowUs()
+{
+  return now;
+}
+
+uint64_t Simulator::sinceBootUs()
+{
+  return now - bootStart;
+}
+
+void Simulator::advanceUs(uint64_t us)
+{
+  // a task that spends time blocks, the loop task moves the clock and lets the others run
+  if (SimKernel::inTask())
+  {
+    SimKernel::block(nullptr, now + us);
+  }
+  else
+  {
+    SimKernel::advanceTo(now + us);
+  }
+}
+
+float Simulator::pressurePa(uint8_t channel, uint64_t timeUs)
+{
+  timeUs = timeUs == current ? now : timeUs;
+  float offsetPa = 0;
+  for (const SensorFault &fault : sensorFaults)
+  {
+    if (fault.channel == channel && fault.startUs <= timeUs && timeUs < fault.endUs)
+    {
+      timeUs = fault.stuck ? fault.startUs : timeUs;
+      offsetPa += fault.offsetPa;
+    }
+  }
+  return traceValue(nullptr, channel, timeUs) + offsetPa;
+}
+
+float Simulator::temperatureC(uint8_t channel, uint64_t timeUs)
+{
+  return traceValue(&TracePoint::temperature, 0, timeUs == current ? now : timeUs);
+}
+
+uint32_t Simulator::rtcSeconds()
+{
+  return traceStartRtcSeconds + now / 1000000;
+}
+
+int Simulator::pinLevel(uint8_t pin)
+{
+  for (const ButtonPress &press : presses)
+  {
+    if (press.pin == pin && press.startUs <= now && now < press.endUs)
+    {
+      return LOW;
+    }
+  }
+  return HIGH;
+}
+
+uint64_t Simulator::nextPinEdgeUs(uint8_t pin)
+{
+  uint64_t next = SimKernel::forever;
+  for (const ButtonPress &press : presses)
+  {
+    if (press.pin != pin)
+    {
+      continue;
+    }
+    if (press.startUs > now && press.startUs < next)
+    {
+      next = press.startUs;
+    }
+    else if (press.endUs > now && press.endUs < next)
+    {
+      next = press.endUs;
+    }
+  }
+  return next;
+}
+
+float Simulator::pinMillivolts(uint8_t pin)
+{
+  // the battery behind the 100k/100k divider of the LOLIN D32
+  return pin == 35 ? batteryVoltage * 1000 / 2 : 0;
+}
+
+bool Simulator::serialEnabled()
+{
+  return serialOutput;
+}
+
+bool Simulator::powerManagement()
+{
+  return pmSupported;
+}
+
+void Simulator::setCpuMhz(uint32_t mhz)
+{
+  if (mhz != clockMhz)
+  {
+    accountCpuClock();
+    clockMhz = mhz;
+  }
+}
+
+uint32_t Simulator::cpuMhz()
+{
+  return clockMhz;
+}
+
+uint64_t Simulator::cpuTime(uint64_t fullClockTime)
+{
+  return fullClockTime * 240 / clockMhz;
+}
+
+void Simulator::modeChanged(uint8_t from, uint8_t to)
+{
+  report.modeChanges++;
+  printf("[sim] %9.3f s  mode %u -> %u  (trace altitude %.0f m)\n", now / 1e6, from, to, traceAltitude());
+}
+
+void Simulator::jumpEvent(const char *name, uint32_t sinceOnsetUs)
+{
+  printf("[sim] %9.3f s  %s detected, onset %.3f s", now / 1e6, name, (now - sinceOnsetUs) / 1e6);
+  auto event = traceEvents.find(name);
+  if (event != traceEvents.end())
+  {
+    printf(", %.2f s after the %s of the trace", ((int64_t)now - (int64_t)event->second) / 1e6, name);
+  }
+  printf("\n");
+}
+
+void Simulator::displayTransfer(uint32_t bytes)
+{
+  report.displayFrames++;
+  report.displayBytes += bytes;
+}
+
+void Simulator::i2cTransfer(uint32_t bytes, uint32_t busUs)
+{
+  report.i2cTransactions++;
+  report.i2cBytes += bytes;
+  report.i2cBusUs += busUs;
+}
+
+void Simulator::setWakeupTimer(uint64_t us)
+{
+  report.wakeupTimerUs = us;
+}
+
+void Simulator::setWakeupPin(uint8_t pin, int level)
+{
+  report.wakeupPin = pin;
+  report.wakeupLevel = level;
+}
+
+void Simulator::setWakeupUlp()
+{
+  report.wakeupUlp = true;
+}
+
+void Simulator::setGpioWakeup(uint8_t pin, int level)
+{
+  if (level == LOW)
+  {
+    gpioWakeupLow |= 1ULL << pin;
+  }
+  else
+  {
+    gpioWakeupLow &= ~(1ULL << pin);
+  }
+}
+
+void Simulator::enableGpioWakeup(bool enabled)
+{
+  gpioWakeupEnabled = enabled;
+}
+
+int Simulator::wakeupCause()
+{
+  return cause;
+}
+
+void Simulator::lightSleep()
+{
+  uint64_t startUs = now;
+  uint64_t wakeAt = report.wakeupTimerUs ? now + report.wakeupTimerUs : trace.back().timeUs;
+  // buttons pull to ground, a pin that is already low wakes right away
+  for (const ButtonPress &press : presses)
+  {
+    bool wakes = (gpioWakeupEnabled && (gpioWakeupLow >> press.pin & 1)) ||
+                 (press.pin == report.wakeupPin && report.wakeupLevel == LOW);
+    if (wakes && press.endUs > now && press.startUs < wakeAt)
+    {
+      wakeAt = press.startUs > now ? press.startUs : now;
+    }
+  }
+  SimKernel::advanceTo(wakeAt);
+  report.lightSleeps++;
+  report.lightSleepUs += now - startUs;
+  loopIdle(now - startUs);
+}
+
+void Simulator::loopIdle(uint64_t us)
+{
+  report.loopIdleUs += us;
+}
+
+void Simulator::deepSleep()
+{
+  finishBoot(true);
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+  // glibc allocates the buffer at the first output otherwise, which may be a print of the
+  // simulator within loop() that the heap check would blame on the firmware
+  static char stdoutBuffer[BUFSIZ];
+  setvbuf(stdout, stdoutBuffer, isatty(STDOUT_FILENO) ? _IOLBF : _IOFBF, sizeof(stdoutBuffer));
+  const char *tracePath = defaultTrace;
+  if (!parseArguments(argc, argv, tracePath))
+  {
+    fprintf(stderr, "usage: %s [--quiet] [--no-pm] [--heap-check] [--step-ms <ms>] [--battery <volts>] [--press <s>:<pin>:<ms>] [--sensor-fault <s>:<sensor>:stuck|<Pa>:<ms>] [--flash <image>] [--logbook-fill <jumps>] [--logbook-check] [--track-csv <file>] [trace.csv]\n", argv[0]);
+    return 2;
+  }
+  if (!loadTrace(tracePath))
+  {
+    fprintf(stderr, "cannot read trace %s\n", tracePath);
+    return 1;
+  }
+
+  FILE *existingImage = flashImage ? fopen(flashImage, "rb") : nullptr;
+  if (existingImage)
+  {
+    fclose(existingImage);
+  }
+  if (!SimFlash::begin(partitionTable, existingImage ? flashImage : nullptr))
+  {
+    fprintf(stderr, "[sim] no data partitions in %s, running without flash\n", partitionTable);
+  }
+  if (logbookFill)
+  {
+    fillLogbook(logbookFill);
+  }
+
+  uint64_t traceEnd = trace.back().timeUs;
+  uint32_t boots = 0;
+  uint64_t loops = 0;
+  uint64_t loopNsTotal = 0;
+  uint64_t loopNsMax = 0;
+  uint32_t modeChanges = 0;
+  uint32_t displayFrames = 0;
+  uint64_t displayBytes = 0;
+  uint32_t i2cTransactions = 0;
+  uint64_t i2cBytes = 0;
+  uint64_t i2cBusUs = 0;
+  uint64_t setupUsMax = 0;
+  uint64_t setupFlashReadMax = 0;
+  uint32_t setupSleeps = 0;
+  uint64_t setupSleepUsTotal = 0;
+  uint64_t setupSleepUsMax = 0;
+  static uint32_t histogram[histogramBuckets];
+  static uint32_t busyHistogram[histogramBuckets];
+  uint64_t loopBusyUsTotal = 0;
+  uint64_t loopBusyUsMax = 0;
+  uint64_t loopUsTotal = 0;
+  uint64_t loopIdleUsTotal = 0;
+  uint32_t lightSleeps = 0;
+  uint64_t lightSleepUsTotal = 0;
+  uint64_t cpuClockUs[4] = {0};
+  uint32_t displayMismatches = 0;
+  uint32_t heapAllocations = 0;
+  static BootReport result;
+  auto wallStart = std::chrono::steady_clock::now();
+
+  now = trace.front().timeUs;
+  while (true)
+  {
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+      perror("pipe");
+      return 1;
+    }
+    fflush(stdout);
+    bootStart = now;
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      close(fds[0]);
+      reportFd = fds[1];
+      runBoot();
+    }
+    close(fds[1]);
+    uint8_t *data = (uint8_t *)&result;
+    size_t received = 0;
+    ssize_t n;
+    while (received < sizeof(result) && (n = read(fds[0], data + received, sizeof(result) - received)) > 0)
+    {
+      received += n;
+    }
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (received != sizeof(result))
+    {
+      fprintf(stderr, "[sim] boot %u crashed (status %d)\n", boots + 1, status);
+      return 1;
+    }
+
+    boots++;
+    loops += result.loops;
+    loopNsTotal += result.loopNsTotal;
+    loopNsMax = result.loopNsMax > loopNsMax ? result.loopNsMax : loopNsMax;
+    for (int i = 0; i < histogramBuckets; i++)
+    {
+      histogram[i] += result.loopHistogram[i];
+      busyHistogram[i] += result.loopBusyHistogram[i];
+    }
+    modeChanges += result.modeChanges;
+    displayFrames += result.displayFrames;
+    displayBytes += result.displayBytes;
+    displayMismatches += result.displayMismatches;
+    loopBusyUsTotal += result.loopBusyUsTotal;
+    loopBusyUsMax = result.loopBusyUsMax > loopBusyUsMax ? result.loopBusyUsMax : loopBusyUsMax;
+    if (result.loops)
+    {
+      loopUsTotal += result.endUs - bootStart - result.setupUs;
+    }
+    loopIdleUsTotal += result.loopIdleUs;
+    lightSleeps += result.lightSleeps;
+    lightSleepUsTotal += result.lightSleepUs;
+    for (int i = 0; i < 4; i++)
+    {
+      cpuClockUs[i] += result.cpuClockUs[i];
+    }
+    i2cTransactions += result.i2cTransactions;
+    i2cBytes += result.i2cBytes;
+    i2cBusUs += result.i2cBusUs;
+    heapAllocations += result.heapAllocations;
+    setupUsMax = result.setupUs > setupUsMax ? result.setupUs : setupUsMax;
+    setupFlashReadMax = result.setupFlashRead > setupFlashReadMax ? result.setupFlashRead : setupFlashReadMax;
+    if (result.slept && !result.loops)
+    {
+      setupSleeps++;
+      setupSleepUsTotal += result.setupUs;
+      setupSleepUsMax = result.setupUs > setupSleepUsMax ? result.setupUs : setupSleepUsMax;
+    }
+
+    if (!result.slept)
+    {
+      break;
+    }
+
+    // deep sleep: only RTC memory survives, wake on the timer or the ext0 button
+    memcpy(__start_rtc_slow_data, result.rtc, result.rtcSize);
+    uint64_t wakeAt = result.wakeupTimerUs ? result.endUs + result.wakeupTimerUs : traceEnd;
+    cause = ESP_SLEEP_WAKEUP_TIMER;
+    for (const ButtonPress &press : presses)
+    {
+      if (press.pin == result.wakeupPin && result.wakeupLevel == LOW && press.startUs >= result.endUs && press.startUs < wakeAt)
+      {
+        wakeAt = press.startUs;
+        cause = ESP_SLEEP_WAKEUP_EXT0;
+      }
+    }
+    if (result.wakeupUlp && runUlp(result.endUs, wakeAt))
+    {
+      wakeAt = now;
+      cause = ESP_SLEEP_WAKEUP_ULP;
+      printf("[sim] %9.3f s  ULP wake-up  (trace altitude %.0f m)\n", now / 1e6, traceAltitude());
+    }
+    if (wakeAt >= traceEnd)
+    {
+      break;
+    }
+    now = wakeAt;
+  }
+
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double simSeconds = (traceEnd - trace.front().timeUs) / 1e6;
+  printf("[sim] trace %s: %.1f s simulated in %.2f s (%.0fx real time)\n", tracePath, simSeconds, wallSeconds, simSeconds / wallSeconds);
+  printf("[sim] boots: %u, longest setup(): %.1f ms\n", boots, setupUsMax / 1e3);
+  if (setupSleeps)
+  {
+    printf("[sim] back to sleep from setup(): %u boots, avg %.2f ms, max %.2f ms\n", setupSleeps,
+           setupSleepUsTotal / 1e3 / setupSleeps, setupSleepUsMax / 1e3);
+  }
+  if (loops)
+  {
+    printf("[sim] loop(): %llu iterations, avg %.2f us, p50 %.2f us, p99 %.2f us, max %.2f us\n",
+           (unsigned long long)loops,
+           loopNsTotal / 1e3 / loops,
+           histogramPercentile(histogram, loops, 0.50) / 1e3,
+           histogramPercentile(histogram, loops, 0.99) / 1e3,
+           loopNsMax / 1e3);
+    printf("[sim] loop() virtual time: avg %.2f us, p99 %.2f us, max %.2f us, %.1f ms in total\n",
+           (double)loopBusyUsTotal / loops,
+           histogramPercentile(busyHistogram, loops, 0.99) / 1e3,
+           (double)loopBusyUsMax,
+           loopBusyUsTotal / 1e3);
+    printf("[sim] loop() idle: %.1f s of %.1f s (%.1f%%) waiting for the next job, %.1f s of it in %u light sleeps\n",
+           loopIdleUsTotal / 1e6, loopUsTotal / 1e6, loopUsTotal ? loopIdleUsTotal * 100.0 / loopUsTotal : 0.0,
+           lightSleepUsTotal / 1e6, lightSleeps);
+  }
+  printf("[sim] cpu clock:");
+  const char *separator = " ";
+  for (int i = 0; i < 4; i++)
+  {
+    if (cpuClockUs[i])
+    {
+      printf("%s%.1f s at %u MHz", separator, cpuClockUs[i] / 1e6, cpuClocks[i]);
+      separator = ", ";
+    }
+  }
+  printf("%s\n", pmSupported ? "" : " (no power management)");
+  printf("[sim] display: %u transfers, %llu bytes, %u frames not shown as drawn\n", displayFrames,
+         (unsigned long long)displayBytes, displayMismatches);
+  printf("[sim] i2c: %u transactions, %llu bytes, %.1f ms bus time (%.2f%% busy)\n",
+         i2cTransactions, (unsigned long long)i2cBytes, i2cBusUs / 1e3, i2cBusUs / 1e4 / simSeconds);
+  const SimUlp::Stats &ulp = SimUlp::stats();
+  if (ulp.runs)
+  {
+    printf("[sim] ulp: %u runs, %u wake-ups, %u i2c transactions, %.1f ms running\n", ulp.runs, ulp.wakes,
+           ulp.i2cTransactions, ulp.busyUs / 1e3);
+  }
+  printf("[sim] mode changes: %u\n", modeChanges);
+  printf("[sim] heap: %u allocations after setup()\n", heapAllocations);
+  for (int i = 0; SimFlash::partition(i); i++)
+  {
+    const esp_partition_t *partition = SimFlash::partition(i);
+    SimFlash::Usage usage = SimFlash::usage(partition);
+    if (usage.bytesRead || usage.bytesWritten || usage.erases)
+    {
+      printf("[sim] flash %s: %llu bytes read, %llu bytes written, %u sector erases (%u..%u per sector)\n",
+             partition->label, (unsigned long long)usage.bytesRead, (unsigned long long)usage.bytesWritten,
+             usage.erases, usage.minSectorErases, usage.maxSectorErases);
+    }
+  }
+  printf("[sim] flash read by setup(): at most %llu bytes\n", (unsigned long long)setupFlashReadMax);
+  printLogbook();
+  if (flashImage && !SimFlash::save(flashImage))
+  {
+    fprintf(stderr, "[sim] cannot write flash image %s\n", flashImage);
+  }
+  return (heapCheck && heapAllocations) || logbookFailures ? 1 : 0;
+}
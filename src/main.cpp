@@ -1,25 +1,67 @@
 #include <Arduino.h>
-#include <JC_Button.h> // https://github.com/JChristensen/JC_Button
+// messages compiled in, build with -DLOG_LEVEL=LOG_LEVEL_NONE for none at all
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#include <DebugLog.h>
 #include <Wire.h>
-#include <Adafruit_Sensor.h>
-#include <Adafruit_BMP280.h>
+#include <Bmp280.h>
 #include <RtcDS3231.h>
 #include <U8g2lib.h>
 #include <SPI.h>
-
-#define MODE_FREEFALL 0
-#define MODE_CANOPY 1
-#define MODE_AIRPLANE 2
-#define MODE_GROUND 3
-#define MODE_MENU 4
-#define MODE_UPDATE 5
+#include <DisplayDma.h>
+#include <GlyphCache.h>
+#include <RenderTask.h>
+#include <SensorTask.h>
+#include <AltitudeFilter.h>
+#include <SensorFusion.h>
+#include <JumpDetector.h>
+#include <JumpModes.h>
+#include <BaroAltitude.h>
+#include <JumpLog.h>
+#include <JumpTrack.h>
+#include <UlpWatch.h>
+#include <JobScheduler.h>
+#include <PowerManager.h>
+#include <Buttons.h>
+#include <SoftClock.h>
+#include <BatteryMonitor.h>
+#include <Units.h>
+
+#ifdef NATIVE_SIM
+#include <Simulator.h>
+#endif
+
+// nothing may allocate once setup() is done: a String does on every copy and fragments the heap
+// of a device that stays on all day, so it can't come back
+#pragma GCC poison String
+
+// FrameState::screen before deep sleep, switches the display off
+#define SCREEN_OFF 255
 
 #define PIN_BUTTON_UP 25
 #define PIN_BUTTON_DOWN 33
 #define PIN_BUTTON_ENTER 32
 
+// index in buttonPins
+#define BUTTON_UP 0
+#define BUTTON_DOWN 1
+#define BUTTON_ENTER 2
+
+// notification bits of the loop task
+#define NOTIFY_SAMPLES (1 << 0)
+#define NOTIFY_BUTTONS (1 << 1)
+// the render task drew every frame, a light sleep may be possible again
+#define NOTIFY_RENDERED (1 << 2)
+
+// the ULP altitude watch needs the sensor bus on RTC pads: build with -DULP_ALTITUDE_WATCH on boards wired that way
+#ifdef ULP_ALTITUDE_WATCH
+#define PIN_I2C_SDA 15
+#define PIN_I2C_SCL 4
+#else
 #define PIN_I2C_SDA 21
 #define PIN_I2C_SCL 22
+#endif
 
 #define PIN_DISPLAY_CLOCK 18
 #define PIN_DISPLAY_DATA 23
@@ -32,221 +74,370 @@
 #define uS_TO_S_FACTOR 1000000 //Conversion factor for micro seconds to seconds
 #define mS_TO_S_FACTOR 1000    //Conversion factor for milli seconds to seconds
 
-Adafruit_BMP280 pressureSensor1;
-Adafruit_BMP280 pressureSensor2;
+Bmp280 pressureSensor1;
+Bmp280 pressureSensor2;
 
+// the bit-banged transport stays available for comparison: build with -DDISPLAY_SW_SPI
+#ifdef DISPLAY_SW_SPI
 U8G2_SSD1309_128X64_NONAME2_F_4W_SW_SPI u8g2(U8G2_R0, /* clock=*/PIN_DISPLAY_CLOCK, /* data=*/PIN_DISPLAY_DATA, /* cs=*/PIN_DISPLAY_CS, /* dc=*/PIN_DISPLAY_DC, /* reset=*/PIN_DISPLAY_RESET);
+#else
+DisplayDma u8g2(U8G2_R0, /* clock=*/PIN_DISPLAY_CLOCK, /* data=*/PIN_DISPLAY_DATA, /* cs=*/PIN_DISPLAY_CS, /* dc=*/PIN_DISPLAY_DC, /* reset=*/PIN_DISPLAY_RESET);
+#endif
+
+// large altitude digits of freefall and canopy, at the baselines the modes draw them
+GlyphCache freefallDigits(u8g2_font_logisoso62_tn, 64);
+GlyphCache canopyDigits(u8g2_font_logisoso50_tn, 51);
+
+SensorTask sensorTask(pressureSensor1, pressureSensor2);
+SensorFusion sensorFusion;
+AltitudeFilter altitudeFilter;
+JumpDetector jumpDetector;
 
 RtcDS3231<TwoWire> rtc(Wire);
+SoftClock softClock;
+// PIN_BATTERY is ADC1 channel 7, behind the 100k/100k divider of the board, with the 2500 mAh LiPo
+BatteryMonitor battery(ADC1_CHANNEL_7, 2, 2500);
+
+JumpLog jumpLog;
+JumpTrack jumpTrack;
+
+#ifdef ULP_ALTITUDE_WATCH
+UlpWatch altitudeWatch;
+#endif
 
-Button buttonUp(PIN_BUTTON_UP);
-Button buttonDown(PIN_BUTTON_DOWN);
-Button buttonEnter(PIN_BUTTON_ENTER);
+JobScheduler scheduler;
+PowerManager power(scheduler);
+
+const uint8_t buttonPins[] = {PIN_BUTTON_UP, PIN_BUTTON_DOWN, PIN_BUTTON_ENTER};
+Buttons buttons(buttonPins, 3);
 
 // define constants
 const float softwareVersion = 0.01;
-const String otaUrl = "https://raw.githubusercontent.com/marcelverdult/diyaltimeter.de/master/ota/";
+const char otaUrl[] PROGMEM = "https://raw.githubusercontent.com/marcelverdult/diyaltimeter.de/master/ota/";
 
 const unsigned long LONG_PRESS = 1000;   // what counts as long press
-const unsigned long sleepTime = 30;      // after what time to sleep
-const unsigned long sleepForTime = 10;   // sleep for how long
-const int batteryCheckInterval = 300000; // in ms = every 5 min if not in freefall/canopy mode
-const int timeCheckInterval = 1000;
+const unsigned long ulpCheckInterval = 2; // s between two pressure checks of the ULP during deep sleep
+const int ulpChecksPerWakeup = 300;       // wake up every 10 min anyway, the ULP threshold does not follow temperature and weather
+const int batteryCheckInterval = 300000; // in ms = a new battery average every 5 min, from bursts spread over the 5 min
+const int clockSyncInterval = 600000; // in ms = every 10 min on the ground, the RTC only corrects the esp_timer drift
+const int freefallDisplayInterval = 200; // ms, only changed tiles are sent so 5 Hz costs about what 2 Hz full frames did
+
+// CPU clock per mode, indexed by MODE_*: freefall and canopy keep every sample and frame on time,
+// the rest runs at the low clock and sleeps between jobs
+const PowerManager::Profile powerProfiles[] = {
+    {240, false}, // freefall
+    {240, false}, // canopy
+    {80, true},   // airplane: 4 Hz samples and 1 Hz display
+    {80, true},   // ground
+    {80, true},   // menu
+    {240, false}, // update: WiFi
+};
+
+// seconds per mode of one jump for the jumps left, indexed by MODE_*: freefall, canopy, the ride up
+// and an hour on the ground until the next load
+const uint16_t jumpSeconds[] = {60, 240, 900, 3600};
 
 // define global variables
-bool debug = true; // debug mode? enables Serial Messages
 bool demo = false; // demo mode to disable actual altitude check
 bool buttonEnterActive = true;
 byte mode = 3; // current work mode
 byte lastMode = 254;
 unsigned long currentMillis = 0;
 
-int currentAltitude;
-int currentAltitudeChangeRate;
+// scheduler jobs
+int sampleJob;
+int buttonJob;
+int timeJob;
+int batteryJob;
 
-char currentDateTime[20];
+int currentAltitude;           // in the units of the display, see Units.h
+int currentAltitudeChangeRate; // m/s
+float currentTemperature;
+
+// formatted by formatDateTime() right before a screen shows them
 char currentTime[6];
 char currentDate[11];
 
 byte batteryLevel;
 
+// what a screen shows, filled by the mode functions and drawn by the render task on the other core
+struct FrameState
+{
+  byte screen;            // MODE_* of the screen or SCREEN_OFF
+  byte batteryLevel;
+  byte selectedItem;      // of the menu
+  int16_t temperature;    // °C
+  int32_t altitude;       // in the units of the display
+  int32_t rate;           // in the units of the display
+  int32_t timeToAltitude; // s until DisplayUnits::targetAltitude, 0 if not climbing
+  char time[6];
+  char date[11];
+};
+
+RenderTask<FrameState> renderTask;
+
+// what the wakeups that went straight back to sleep cost since power on
+struct WakeupStats
+{
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t totalUs;
+};
+
 // variables to keep during sleep
 RTC_DATA_ATTR float defaultPressure1;
 RTC_DATA_ATTR float defaultPressure2;
+RTC_DATA_ATTR WakeupStats fastWakeups;
+// per mode since power on, without the deep sleeps and the wakeups that went straight back to sleep
+RTC_DATA_ATTR PowerManager::Usage powerUsage[MODE_UPDATE + 1];
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-// function to display debug messages on the serial console if DEBUG == true
-void debugMessage(String message)
+// altitude in m above the reference pressure (hPa), same formula as Adafruit_BMP280::readAltitude()
+// but from a lookup table instead of pow()
+float pressureToAltitude(float pressure, float referencePressure)
 {
-  if (debug)
-  {
-    Serial.println(message);
-    delay(100);
-  }
-};
+  return BaroAltitude::fromPressure(pressure, referencePressure * 100);
+}
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-void readButtons()
+// Altitude check - filter - smoothen
+
+void updateAltitude(const AltitudeSample &sample)
+{
+  float altitude1;
+  float altitude2;
+
+  altitude1 = pressureToAltitude(sample.pressure1, defaultPressure1);
+  altitude2 = pressureToAltitude(sample.pressure2, defaultPressure2);
+  altitudeFilter.update(sensorFusion.update(altitude1, altitude2), sample.timeUs);
+  for (uint8_t _sensor = 0; sensorFusion.newFaults() && _sensor < SensorFusion::sensors; _sensor++)
+  {
+    if (sensorFusion.newFaults() >> _sensor & 1)
+    {
+      jumpLog.sensorFault(_sensor);
+      LOG_VALUES_AT(LOG_LEVEL_WARNING, "pressure sensor %d: fault %d", _sensor + 1, sensorFusion.fault(_sensor));
+    }
+  }
+  // only the modes of a jump look at the detector, changeModeTo() resets it for the climb
+  if (mode <= MODE_AIRPLANE)
+  {
+    JumpDetector::EventType _event =
+        jumpDetector.update(altitudeFilter.altitude(), altitudeFilter.verticalSpeed(), altitudeFilter.acceleration(), sample.timeUs);
+    if (_event != JumpDetector::NONE)
+    {
+      uint32_t _sinceOnsetUs = sample.timeUs - jumpDetector.event(_event).onsetUs;
+      LOG_VALUES_AT(LOG_LEVEL_INFO, "jump event %d, %u ms after its onset", _event, _sinceOnsetUs / 1000);
+#ifdef NATIVE_SIM
+      const char *_eventNames[] = {"", "exit", "deployment", "landing"};
+      Simulator::jumpEvent(_eventNames[_event], _sinceOnsetUs);
+#endif
+    }
+  }
+  currentAltitude = DisplayUnits::altitude(altitudeFilter.altitude());
+  currentAltitudeChangeRate = roundf(altitudeFilter.verticalSpeed());
+  currentTemperature = sample.temperature;
+  jumpTrack.add(sample.timeUs, altitudeFilter.altitude(), altitudeFilter.verticalSpeed());
+}
+
+// process all samples the sensor task collected since the last loop
+void checkAltitude()
 {
-  if (mode > 2)
+  AltitudeSample sample;
+
+  while (sensorTask.pop(sample))
   {
-    buttonEnter.read();
-    buttonUp.read();
-    buttonDown.read();
+    updateAltitude(sample);
   }
 };
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-void checkAltitudeChangeRate()
+// at boot, then every clockSyncInterval on the ground and in the menu; in between the software clock
+// keeps the RTC off the sensor bus
+void syncClock()
 {
-  static int _changeRate[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  static unsigned long _lastAltitudeUpdate = currentMillis;
-  static int _last_Altitude;
-  static unsigned long _timeDiff = 1;
-  static int _altitudeDiff = 0;
-  static int _counter = 0;
-  int _currentAltitudeChangeRate = 0;
+  RtcDateTime now;
 
-  // if (_lastAltitudeUpdate == 0 || _lastAltitudeUpdate + 1000 < currentMillis)
-  // {
-  _timeDiff = (currentMillis - _lastAltitudeUpdate) / 1000;
-  // avoid division by zero errors
-  if (_timeDiff == 0)
-  {
-    _timeDiff = 1;
-  }
-  _altitudeDiff = currentAltitude - _last_Altitude;
-  _changeRate[_counter] = _altitudeDiff / _timeDiff;
-  _lastAltitudeUpdate = currentMillis;
-  _last_Altitude = currentAltitude;
-  if (_counter == 9)
+  sensorTask.lockBus();
+  now = rtc.GetDateTime();
+  sensorTask.unlockBus();
+  int32_t _offset = softClock.sync(now.TotalSeconds());
+  if (_offset != 0)
   {
-    _counter = 0;
+    logDebug("clock sync: %d s off", _offset);
   }
-  else
+}
+
+// only when the minute changed since the last call
+void formatDateTime()
+{
+  static uint32_t _formattedMinute = UINT32_MAX;
+  uint32_t _seconds = softClock.seconds();
+
+  if (_seconds / 60 == _formattedMinute)
   {
-    _counter++;
+    return;
   }
+  _formattedMinute = _seconds / 60;
+  RtcDateTime now(_seconds);
+
+  snprintf_P(currentDate,
+             sizeof(currentDate),
+             PSTR("%02u.%02u.%04u"),
+             now.Day() % 100u, // bounded, so the compiler sees that the buffers fit
+             now.Month() % 100u,
+             now.Year() % 10000u);
+
+  snprintf_P(currentTime,
+             sizeof(currentTime),
+             PSTR("%02u:%02u"),
+             now.Hour() % 100u,
+             now.Minute() % 100u);
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
 
-  for (int i = 0; i < 9; i++)
+// from the average current of every mode so far. Before a mode ran, from the datasheet current of the CPU
+// waiting at its clock, or in light sleep: it runs well below 1% of the time in every mode.
+uint32_t remainingJumps()
+{
+  uint64_t _jumpNc = 0;
+  for (byte _mode = MODE_FREEFALL; _mode <= MODE_GROUND; _mode++)
   {
-    _currentAltitudeChangeRate = _currentAltitudeChangeRate + _changeRate[i];
+    const PowerManager::Usage &_usage = power.usage(_mode);
+    uint64_t _us = _usage.activeUs + _usage.idleUs + _usage.lightSleepUs;
+    uint64_t _ua = _us                              ? _usage.chargeNc * 1000 / _us
+                   : powerProfiles[_mode].lightSleep ? PowerManager::lightSleepUa
+                                                     : PowerManager::idleUa(powerProfiles[_mode].cpuMhz);
+    _jumpNc += _ua * jumpSeconds[_mode] * 1000;
   }
+  return battery.remainingMah() * 3600000000ULL / _jumpNc;
+}
 
-  currentAltitudeChangeRate = _currentAltitudeChangeRate / 10;
-  // }
-
-  // avoid division by zero errors
-  if (currentAltitudeChangeRate == 0)
+// a burst of ADC readings in every mode, a new average every batteryCheckInterval
+void checkBattery()
+{
+  if (!battery.update())
   {
-    currentAltitudeChangeRate = 1;
+    return;
   }
+  batteryLevel = battery.level(5);
+  logDebug("battery %u mV, %u%%, about %u jumps left", battery.millivolts(), battery.percent(), remainingJumps());
+  logDebug("Pressure samples / dropped / avg / max jitter us: %u / %u / %u / %u", sensorTask.samples(), sensorTask.dropped(),
+           sensorTask.jitterAvgUs(), sensorTask.jitterMaxUs());
 }
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-// Altitude check - filter - smoothen
+void logJobStats()
+{
+  for (int job = 0; job < scheduler.jobs(); job++)
+  {
+    const JobScheduler::Stats &stats = scheduler.stats(job);
+    if (stats.runs)
+    {
+      logDebug("job %-7s %6u runs, runtime avg %5u max %6u us, late avg %5u max %6u us", scheduler.name(job), stats.runs,
+               (uint32_t)(stats.runtimeTotalUs / stats.runs), stats.runtimeMaxUs, (uint32_t)(stats.latenessTotalUs / stats.runs),
+               stats.latenessMaxUs);
+    }
+  }
+  logDebug("display frames drawn / skipped: %u / %u, latency avg %u max %u us, drawing max %u us", renderTask.frames(),
+           renderTask.skipped(), renderTask.latencyAvgUs(), renderTask.latencyMaxUs(), renderTask.drawMaxUs());
+  logDebug("idle %u ms, %u ms of it in %u light sleeps", (uint32_t)(scheduler.idleUs() / 1000),
+           (uint32_t)(scheduler.lightSleepUs() / 1000), scheduler.lightSleeps());
+}
 
-void checkAltitude()
+// duty cycle and estimated CPU charge per mode since power on
+void logPowerUsage()
 {
-  static unsigned long lastAltiCheck = 0;
-  int altitude1;
-  int altitude2;
+  uint64_t _chargeNc = 0;
+  uint64_t _fullClockChargeNc = 0;
 
-  if (lastAltiCheck + 200 < currentMillis || lastAltiCheck == 0)
+  power.account();
+  for (byte i = 0; i <= MODE_UPDATE; i++)
   {
-    altitude1 = pressureSensor1.readAltitude(defaultPressure1);
-    altitude2 = pressureSensor2.readAltitude(defaultPressure2);
-    currentAltitude = (altitude1 + altitude2) / 2;
-    lastAltiCheck = currentMillis;
-    checkAltitudeChangeRate();
+    const PowerManager::Usage &usage = power.usage(i);
+    uint64_t _totalUs = usage.activeUs + usage.idleUs + usage.lightSleepUs;
+    if (_totalUs)
+    {
+      logDebug("power mode %u at %u MHz: %u s, running %.1f%%, light sleep %.1f%%, %.3f mAh (%.3f mAh at full clock)", i,
+               powerProfiles[i].cpuMhz, (uint32_t)(_totalUs / 1000000), usage.activeUs * 100.0 / _totalUs,
+               usage.lightSleepUs * 100.0 / _totalUs, usage.chargeNc / 3.6e9, usage.fullClockChargeNc / 3.6e9);
+    }
+    _chargeNc += usage.chargeNc;
+    _fullClockChargeNc += usage.fullClockChargeNc;
   }
-};
-
-/* -------------------------------------------------------------------------------------------------------- */
+  if (_chargeNc)
+  {
+    logDebug("power since power on: %.3f mAh, the CPU lasts %.1fx as long as at full clock without idling (%s)",
+             _chargeNc / 3.6e9, (double)_fullClockChargeNc / _chargeNc, power.dfs() ? "DFS" : "fixed clock");
+  }
+}
 
-void getTime()
+// light sleep where the power profile allows it, with every frame drawn and the display idle, the
+// sensor bus free and the buttons released: the bus lock keeps the sensor task off the bus until
+// resumeAfterLightSleep(), a button press wakes the chip
+bool prepareLightSleep()
 {
-  static unsigned long lastTimeCheck = 0;
-  RtcDateTime now;
-
-  if (lastTimeCheck + timeCheckInterval < currentMillis || lastTimeCheck == 0)
-  {
-    now = rtc.GetDateTime();
-
-    snprintf_P(currentDateTime,
-               sizeof(currentDateTime),
-               PSTR("%02u.%02u.%04u %02u:%02u:%02u"),
-               now.Day(),
-               now.Month(),
-               now.Year(),
-               now.Hour(),
-               now.Minute(),
-               now.Second());
-
-    snprintf_P(currentDate,
-               sizeof(currentDate),
-               PSTR("%02u.%02u.%04u"),
-               now.Day(),
-               now.Month(),
-               now.Year());
-
-    snprintf_P(currentTime,
-               sizeof(currentTime),
-               PSTR("%02u:%02u"),
-               now.Hour(),
-               now.Minute());
-    lastTimeCheck = currentMillis;
+  if (!power.lightSleepAllowed() || !renderTask.idle())
+  {
+    return false;
   }
+#ifndef DISPLAY_SW_SPI
+  if (u8g2.busy())
+  {
+    return false;
+  }
+#endif
+  if (!sensorTask.lockBus(0))
+  {
+    return false;
+  }
+  if (!buttons.prepareSleep())
+  {
+    sensorTask.unlockBus();
+    return false;
+  }
+  return true;
+}
+
+void resumeAfterLightSleep()
+{
+  buttons.resumeSleep();
+  sensorTask.unlockBus();
 }
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-void checkBattery()
+// configure both pressure sensors and the sample rate for a mode
+void applySensorProfile(byte newMode)
 {
-  static unsigned long _lastBatteryCheck = 0;
-  int vbat;
-  float voltage; // battery voltage
+  static const SensorProfile *_activeProfile = NULL;
+  const SensorProfile *_profile = &sensorProfiles[newMode];
 
-  if (mode > 2 || _lastBatteryCheck == 0)
+  if (_activeProfile != NULL && memcmp(_activeProfile, _profile, sizeof(SensorProfile)) == 0)
   {
-    if (_lastBatteryCheck + batteryCheckInterval < currentMillis || _lastBatteryCheck == 0)
-    {
-      vbat = analogRead(35);
-      voltage = 7.445 * vbat / 4096.0;
-      debugMessage("Battery voltage");
-      debugMessage((String)voltage);
-      _lastBatteryCheck = currentMillis;
+    return;
+  }
+  _activeProfile = _profile;
 
-      if (voltage > 4.0)
-      {
-        batteryLevel = 5;
-      }
-      else if (voltage > 3.9)
-      {
-        batteryLevel = 4;
-      }
-      else if (voltage > 3.8)
-      {
-        batteryLevel = 3;
-      }
-      else if (voltage > 3.7)
-      {
-        batteryLevel = 2;
-      }
-      else if (voltage > 3.6)
-      {
-        batteryLevel = 1;
-      }
-      else
-      {
-        batteryLevel = 0;
-      }
-    }
+  sensorTask.lockBus();
+  pressureSensor1.setSampling(_profile->temperatureSampling, _profile->pressureSampling, _profile->filter, _profile->standby);
+  pressureSensor2.setSampling(_profile->temperatureSampling, _profile->pressureSampling, _profile->filter, _profile->standby);
+  sensorTask.unlockBus();
+  sensorTask.setPeriod(_profile->samplePeriod);
+  // runs on every sample the sensor task notifies, the period only matters if none come
+  scheduler.setPeriod(sampleJob, 2 * _profile->samplePeriod);
+
+  if (pressureSensor1.measurementPeriodUs() > _profile->samplePeriod * 1000u)
+  {
+    logWarning("sensor profile: a conversion every %u us, samples every %u ms read some twice", pressureSensor1.measurementPeriodUs(),
+               _profile->samplePeriod);
   }
+  logDebug("sensor profile: %d Hz, conversion %u us every %u us, noise %.2f Pa", 1000 / _profile->samplePeriod,
+           pressureSensor1.conversionTimeUs(), pressureSensor1.measurementPeriodUs(), pressureSensor1.noisePa());
 }
 
 /* -------------------------------------------------------------------------------------------------------- */
@@ -255,19 +446,124 @@ void checkBattery()
 void changeModeTo(byte newMode)
 {
   lastMode = mode;
-  debugMessage("switching to mode:" + (String)newMode);
+  // binary record, formatted by the log task: a mode change must not wait for the log
+  LOG_VALUES_AT(LOG_LEVEL_INFO, "switching to mode: %d", newMode);
+#ifdef NATIVE_SIM
+  Simulator::modeChanged(lastMode, newMode);
+#endif
   mode = newMode;
+  if (newMode == MODE_AIRPLANE)
+  {
+    jumpDetector.reset();
+  }
+  applySensorProfile(newMode);
+  power.apply(newMode, powerProfiles[newMode]);
+  scheduler.enable(buttonJob, newMode > 2);
+  scheduler.enable(timeJob, newMode > 2);
+  // presses from the previous mode, and from the air where nobody reads them
+  buttons.clear();
 };
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-void displayBatteryLevel()
+// the values all screens draw from, the mode functions add their own before they publish it
+FrameState currentFrame(byte screen)
+{
+  FrameState _frame;
+
+  formatDateTime();
+  _frame.screen = screen;
+  _frame.batteryLevel = batteryLevel;
+  _frame.selectedItem = 0;
+  _frame.temperature = roundf(currentTemperature);
+  _frame.altitude = currentAltitude;
+  _frame.rate = DisplayUnits::rate(altitudeFilter.verticalSpeed());
+  _frame.timeToAltitude = 0;
+  memcpy(_frame.time, currentTime, sizeof(_frame.time));
+  memcpy(_frame.date, currentDate, sizeof(_frame.date));
+  return _frame;
+}
+
+// the draw*() functions run in the render task, after setup() nothing else touches u8g2
+void drawBatteryLevel(const FrameState &frame)
 {
   // display battery level
   u8g2.setFontDirection(1);
   u8g2.setCursor(106, 0);
   u8g2.setFont(u8g2_font_battery19_tn);
-  u8g2.print(batteryLevel);
+  u8g2.print(frame.batteryLevel);
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+#ifdef ULP_ALTITUDE_WATCH
+// hands the climb check to the ULP, at the temperature of the last reading of sensor 1: the ULP
+// only sees its raw values. Falls back to the wakeup timer if the program cannot be started.
+bool startAltitudeWatch()
+{
+  float _climbPressure = defaultPressure1 * 100 * pow(1 - climbAltitude / 44330.0, 1 / 0.1903);
+  uint16_t _threshold = altitudeWatch.threshold(pressureSensor1, _climbPressure);
+
+  pressureSensor1.sleep();
+  if (!altitudeWatch.start(0x76, _threshold, ulpCheckInterval * mS_TO_S_FACTOR, ulpChecksPerWakeup))
+  {
+    esp_sleep_enable_timer_wakeup(sleepForTime * uS_TO_S_FACTOR);
+    return false;
+  }
+  return true;
+}
+#endif
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+// deep sleep until the wakeup timer or the enter button, with the ULP watch until a climb
+void goToSleep()
+{
+#ifdef ULP_ALTITUDE_WATCH
+  sensorTask.lockBus();
+  pressureSensor2.sleep();
+  bool _watching = startAltitudeWatch();
+  sensorTask.unlockBus();
+  if (!_watching)
+  {
+    logWarning("ULP watch failed, waking up on the timer");
+  }
+#else
+  // light sleep clears the timer wakeup
+  esp_sleep_enable_timer_wakeup(sleepForTime * uS_TO_S_FACTOR);
+#endif
+  debugLog.flush();
+  esp_deep_sleep_start();
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+// wakeup on the ground without a climb from the ULP: one forced conversion of sensor 1 against
+// the reference and straight back to sleep, before Serial, display, buttons and RTC are set up.
+// Returns only on a climb or when the sensor does not answer, then the full setup() takes over.
+void checkAltitudeFast()
+{
+  if (!pressureSensor1.attach(0x76) || !pressureSensor1.readForced(Bmp280::SAMPLING_X1, Bmp280::SAMPLING_X1))
+  {
+    return;
+  }
+  if (BaroAltitude::fromPressure(pressureSensor1.pressure(), defaultPressure1 * 100) > climbAltitude)
+  {
+    return;
+  }
+
+  esp_sleep_enable_ext0_wakeup(GPIO_NUM_32, 0);
+#ifdef ULP_ALTITUDE_WATCH
+  startAltitudeWatch();
+#else
+  esp_sleep_enable_timer_wakeup(sleepForTime * uS_TO_S_FACTOR);
+#endif
+  // micros() starts with the app, the ROM and second stage bootloader come on top
+  uint32_t _wakeUs = micros();
+  fastWakeups.count++;
+  fastWakeups.totalUs += _wakeUs;
+  fastWakeups.maxUs = _wakeUs > fastWakeups.maxUs ? _wakeUs : fastWakeups.maxUs;
+  esp_deep_sleep_start();
 }
 
 /* -------------------------------------------------------------------------------------------------------- */
@@ -277,36 +573,55 @@ void displayBatteryLevel()
 // no -> sleep again
 void checkAltitudeAfterWakeup()
 {
-  checkAltitude();
-  debugMessage("check alti after wakeup");
-  debugMessage((String)defaultPressure1);
-  debugMessage((String)defaultPressure2);
-  debugMessage("current altitude");
-  debugMessage((String)currentAltitude);
+  updateAltitude(sensorTask.read());
+  logDebug("check alti after wakeup, reference %.2f / %.2f hPa, current altitude %d %s", defaultPressure1, defaultPressure2,
+           currentAltitude, DisplayUnits::altitudeSymbol);
 
-  if (currentAltitude > 50)
+  if (nextMode(MODE_GROUND, jumpDetector, altitudeFilter.altitude()) == MODE_AIRPLANE)
   {
-    debugMessage("Altitude change! Switching to planeMode");
+    logInfo("Altitude change! Switching to planeMode");
     changeModeTo(MODE_AIRPLANE);
   }
   else
   {
-    debugMessage("no altitude change going to sleep again...");
-    esp_deep_sleep_start();
+    logDebug("no altitude change going to sleep again...");
+    goToSleep();
   }
 };
 
 /* -------------------------------------------------------------------------------------------------------- */
 
+void drawGround(const FrameState &frame)
+{
+  u8g2.setFontDirection(0);
+  u8g2.setFont(u8g2_font_courR08_tf);
+  u8g2.setCursor(0, 8);
+  u8g2.print("diyaltimeter.de");
+  u8g2.drawHLine(0, 10, 128);
+
+  drawBatteryLevel(frame);
+
+  u8g2.setFontDirection(0);
+  u8g2.setFont(u8g2_font_courB24_tn);
+  u8g2.setCursor(0, 35);
+  u8g2.print(frame.time);
+
+  u8g2.setFont(u8g2_font_courB10_tn);
+  u8g2.setCursor(0, 47);
+  u8g2.print(frame.date);
+
+  u8g2.setFont(u8g2_font_courR08_tf);
+
+  u8g2.setCursor(90, 60);
+  u8g2.print(frame.temperature);
+  u8g2.print("°C");
+}
+
 void groundMode()
 {
   static unsigned long _groundTime = currentMillis;
   static unsigned long _lastDisplayUpdate = 0;
-
-  if (buttonEnter.isReleased() && !buttonEnterActive)
-  {
-    buttonEnterActive = true;
-  }
+  Buttons::Event _event;
 
   if (mode != lastMode)
   {
@@ -315,14 +630,25 @@ void groundMode()
   }
   else
   {
-    // check Enter Button to enter Menu
-    if (buttonEnter.pressedFor(1000) && buttonEnterActive)
+    while (buttons.read(_event))
     {
-      buttonEnterActive = false;
-      changeModeTo(MODE_MENU); // change Mode to menuMode
+      if (_event.button != BUTTON_ENTER)
+      {
+        continue;
+      }
+      if (_event.type == Buttons::RELEASE)
+      {
+        buttonEnterActive = true;
+      }
+      // hold Enter to enter the Menu
+      else if (_event.type == Buttons::LONG_PRESS && _event.heldMs >= LONG_PRESS && buttonEnterActive)
+      {
+        buttonEnterActive = false;
+        changeModeTo(MODE_MENU); // change Mode to menuMode
+      }
     }
   }
-  if (currentAltitude > 50)
+  if (nextMode(MODE_GROUND, jumpDetector, altitudeFilter.altitude()) == MODE_AIRPLANE)
   {
     changeModeTo(MODE_AIRPLANE);
   }
@@ -330,123 +656,154 @@ void groundMode()
   // 30 seconds without action passed?
   else if (_groundTime + (sleepTime * mS_TO_S_FACTOR) < currentMillis)
   {
-    debugMessage("going to sleep...");
-    u8g2.setPowerSave(1);
+    logInfo("going to sleep...");
+    logJobStats();
+    logPowerUsage();
+    renderTask.publish(currentFrame(SCREEN_OFF));
+    renderTask.flush();
     delay(100);
-    esp_deep_sleep_start();
+    goToSleep();
   }
 
   // display
   if (_lastDisplayUpdate + 5000 < currentMillis || _lastDisplayUpdate == 0)
   {
-    u8g2.clearBuffer();
-    u8g2.setFontDirection(0);
-    u8g2.setFont(u8g2_font_courR08_tf);
-    u8g2.setCursor(0, 8);
-    u8g2.print("diyaltimeter.de");
-    u8g2.drawHLine(0, 10, 128);
-
-    displayBatteryLevel();
-
-    u8g2.setFontDirection(0);
-    u8g2.setFont(u8g2_font_courB24_tn);
-    u8g2.setCursor(0, 35);
-    u8g2.print(currentTime);
-
-    u8g2.setFont(u8g2_font_courB10_tn);
-    u8g2.setCursor(0, 47);
-    u8g2.print(currentDate);
-
-    u8g2.setFont(u8g2_font_courR08_tf);
-
-    int temp = roundf(pressureSensor1.readTemperature());
-    u8g2.setCursor(90, 60);
-    u8g2.print(temp);
-    u8g2.print("°C");
-
-    u8g2.sendBuffer();
+    renderTask.publish(currentFrame(MODE_GROUND));
     _lastDisplayUpdate = currentMillis;
   }
 };
 
 /* -------------------------------------------------------------------------------------------------------- */
 
+void drawAirplane(const FrameState &frame)
+{
+  u8g2.setFontDirection(0);
+  u8g2.setFont(u8g2_font_courR08_tf);
+  u8g2.setCursor(0, 8);
+  u8g2.print(frame.date);
+  u8g2.print(" ");
+  u8g2.print(frame.time);
+  u8g2.drawHLine(0, 10, 128);
+
+  drawBatteryLevel(frame);
+
+  u8g2.setFontDirection(0);
+  u8g2.setFont(u8g2_font_courB24_tr);
+  u8g2.setCursor(0, 35);
+  u8g2.print(frame.altitude);
+  u8g2.print(DisplayUnits::altitudeSymbol);
+  u8g2.setFont(u8g2_font_courR08_tr);
+  if (frame.timeToAltitude > 0)
+  {
+    u8g2.setCursor(0, 47);
+    u8g2.print(DisplayUnits::targetLabel);
+    u8g2.print(" in ");
+    u8g2.print(frame.timeToAltitude / 60);
+    u8g2.print("min ");
+    u8g2.print(frame.timeToAltitude % 60);
+    u8g2.print("sec");
+  }
+  u8g2.setCursor(0, 60);
+  u8g2.print("climb rate: ");
+  u8g2.print(frame.rate);
+  u8g2.print(DisplayUnits::rateSymbol);
+}
+
 void airplaneMode()
 {
   static int _timeToAltitude = 0;
   static unsigned long _lastDisplayUpdate = currentMillis;
+  byte _nextMode = nextMode(MODE_AIRPLANE, jumpDetector, altitudeFilter.altitude());
 
-  _timeToAltitude = (4000 - currentAltitude) / currentAltitudeChangeRate;
+  if (currentAltitudeChangeRate > 0)
+  {
+    _timeToAltitude = DisplayUnits::toMeters(DisplayUnits::targetAltitude - currentAltitude) / currentAltitudeChangeRate;
+  }
+  else
+  {
+    _timeToAltitude = 0;
+  }
 
-  if (currentAltitudeChangeRate < -15)
+  if (_nextMode == MODE_FREEFALL)
   {
+    jumpLog.start(softClock.seconds(), roundf(jumpDetector.event(JumpDetector::EXIT).altitude));
+    // a sensor that is left out already counts for this jump too
+    for (uint8_t _sensor = 0; _sensor < SensorFusion::sensors; _sensor++)
+    {
+      if (sensorFusion.fault(_sensor) != SensorFusion::FAULT_NONE)
+      {
+        jumpLog.sensorFault(_sensor);
+      }
+    }
+    jumpTrack.start();
     changeModeTo(MODE_FREEFALL);
   }
+  else if (_nextMode == MODE_GROUND)
+  {
+    logInfo("landed with the plane");
+    changeModeTo(MODE_GROUND);
+  }
 
   // display
   if (_lastDisplayUpdate + 1000 < currentMillis || _lastDisplayUpdate == 0)
   {
-    u8g2.clearBuffer();
-    u8g2.setFontDirection(0);
-    u8g2.setFont(u8g2_font_courR08_tf);
-    u8g2.setCursor(0, 8);
-    u8g2.print(currentDate);
-    u8g2.print(" ");
-    u8g2.print(currentTime);
-    u8g2.drawHLine(0, 10, 128);
-
-    displayBatteryLevel();
-
-    u8g2.setFontDirection(0);
-    u8g2.setFont(u8g2_font_courB24_tr);
-    u8g2.setCursor(0, 35);
-    u8g2.print(currentAltitude);
-    u8g2.print("m");
-    u8g2.setFont(u8g2_font_courR08_tr);
-    if (_timeToAltitude > 0)
-    {
-      u8g2.setCursor(0, 47);
-      u8g2.print("4km in ");
-      u8g2.print((int)_timeToAltitude / 60);
-      u8g2.print("min ");
-      u8g2.print((int)_timeToAltitude % 60);
-      u8g2.print("sec");
-    }
-    u8g2.setCursor(0, 60);
-    u8g2.print("climb rate: ");
-    u8g2.print(currentAltitudeChangeRate);
-    u8g2.print("m/s");
-
-    u8g2.sendBuffer();
+    FrameState _frame = currentFrame(MODE_AIRPLANE);
+    _frame.timeToAltitude = _timeToAltitude;
+    renderTask.publish(_frame);
     _lastDisplayUpdate = currentMillis;
   }
 };
 
 /* -------------------------------------------------------------------------------------------------------- */
 
+void drawFreefall(const FrameState &frame)
+{
+  freefallDigits.print(u8g2, 0, DisplayUnits::freefallAltitude(frame.altitude), DisplayUnits::freefallDecimals);
+}
+
 void freefallMode()
 {
   static unsigned long _lastDisplayUpdate = 0;
 
-  if (currentAltitudeChangeRate < 15)
+  jumpLog.verticalSpeed(currentAltitudeChangeRate);
+
+  if (nextMode(MODE_FREEFALL, jumpDetector, altitudeFilter.altitude()) == MODE_CANOPY)
   {
+    jumpLog.canopy(roundf(jumpDetector.event(JumpDetector::DEPLOYMENT).altitude));
     changeModeTo(MODE_CANOPY);
   }
 
   // display
-  if (_lastDisplayUpdate + 500 < currentMillis || _lastDisplayUpdate == 0)
+  if (_lastDisplayUpdate + freefallDisplayInterval < currentMillis || _lastDisplayUpdate == 0)
   {
-    u8g2.clearBuffer();
-    u8g2.setFontDirection(0);
-    u8g2.setFont(u8g2_font_logisoso62_tn);
-    u8g2.setCursor(0, 64);
-    u8g2.print(currentAltitude);
-    u8g2.sendBuffer();
+    renderTask.publish(currentFrame(MODE_FREEFALL));
     _lastDisplayUpdate = currentMillis;
   }
 }
 /* -------------------------------------------------------------------------------------------------------- */
 
+void drawCanopy(const FrameState &frame)
+{
+  char _rate[16];
+
+  u8g2.setFontDirection(0);
+  if (frame.altitude > 9999)
+  {
+    // five digits after a high opening in feet: 128 px only fit four of the large font
+    u8g2.setFont(u8g2_font_logisoso38_tn);
+    u8g2.setCursor(0, 51);
+    u8g2.print(frame.altitude);
+  }
+  else
+  {
+    canopyDigits.print(u8g2, 0, frame.altitude);
+  }
+  u8g2.setFont(u8g2_font_courR08_tf);
+  u8g2.setCursor(0, 64);
+  snprintf_P(_rate, sizeof(_rate), PSTR("%d %s"), frame.rate, DisplayUnits::rateSymbol);
+  u8g2.print(_rate);
+}
+
 void canopyMode()
 {
   static unsigned long _lastDisplayUpdate = 0;
@@ -454,22 +811,27 @@ void canopyMode()
   // display
   if (_lastDisplayUpdate + 500 < currentMillis || _lastDisplayUpdate == 0)
   {
-    u8g2.clearBuffer();
-    u8g2.setFontDirection(0);
-    u8g2.setFont(u8g2_font_logisoso50_tn);
-    u8g2.setCursor(0, 51);
-    u8g2.print(currentAltitude);
-    u8g2.setFont(u8g2_font_courR08_tf);
-    u8g2.setCursor(0, 64);
-    u8g2.print((String)currentAltitudeChangeRate);
-    u8g2.print(" m/s");
-    u8g2.sendBuffer();
-
+    renderTask.publish(currentFrame(MODE_CANOPY));
     _lastDisplayUpdate = currentMillis;
   }
 
-  if (currentAltitude < 4)
+  if (nextMode(MODE_CANOPY, jumpDetector, altitudeFilter.altitude()) == MODE_GROUND)
   {
+    jumpLog.stop();
+    jumpTrack.stop();
+    // flash is only written once the jump is over
+    jumpTrack.save(jumpLog.lastJumpNumber());
+    logInfo("logbook: saved jump %u, track %u samples in %u bytes", jumpLog.lastJumpNumber(), jumpTrack.samples(),
+            (unsigned)jumpTrack.length());
+    for (uint8_t _sensor = 0; _sensor < SensorFusion::sensors; _sensor++)
+    {
+      const SensorFusion::Stats &_stats = sensorFusion.stats(_sensor);
+      logDebug("pressure sensor %u: noise %.2f m, %u invalid, %u stuck, %u outliers, %u samples left out", _sensor + 1,
+               sensorFusion.noise(_sensor), _stats.invalid, _stats.stuck, _stats.outliers, _stats.excludedSamples);
+    }
+#ifndef DISPLAY_SW_SPI
+    logDebug("display bytes sent / saved: %u / %u", (unsigned)u8g2.bytesSent(), (unsigned)u8g2.bytesSaved());
+#endif
     changeModeTo(MODE_GROUND);
   }
 };
@@ -481,88 +843,101 @@ typedef void (*function)();
 void firstFunction()
 {
   // whatever
-  debugMessage("First function call");
+  logDebug("First function call");
 }
 
 void secondFunction()
 {
   // whatever
-  debugMessage("Second function call");
+  logDebug("Second function call");
 }
 
-void menuMode()
-{
-  static byte _selectedItem = 0;
-  const String _menuItems[] = {"Dropzones", "Planes", "Update", "Item 4", "Item 5"};
-  const function arrayOfFunctions[] = {firstFunction, secondFunction};
-
-  static bool _displayNeedUpdate = true;
-  byte _numberOfItems = 5;
+// fixed size entries, so the texts sit in flash next to the table instead of behind pointers
+const char menuItems[][10] PROGMEM = {"Dropzones", "Planes", "Update", "Item 4", "Item 5"};
+const function menuFunctions[] = {firstFunction, secondFunction};
+const byte menuItemCount = sizeof(menuItems) / sizeof(menuItems[0]);
 
-  if (buttonEnter.isReleased() && !buttonEnterActive)
-  {
-    buttonEnterActive = true;
-  }
+void drawMenu(const FrameState &frame)
+{
+  u8g2.setFontDirection(0);
+  u8g2.setFont(u8g2_font_courR08_tf);
+  u8g2.setCursor(0, 8);
+  u8g2.print("Menu");
+  u8g2.drawHLine(0, 10, 128);
 
-  if (lastMode != mode)
-  {
-    _displayNeedUpdate = true;
-    lastMode = mode;
-  }
-  else
+  for (byte i = 0; i < menuItemCount; i++)
   {
-
-    if (buttonDown.wasReleased() && _selectedItem < 4)
+    if (i == 0)
     {
-      _selectedItem++;
-      _displayNeedUpdate = true;
+      u8g2.setCursor(0, 20);
     }
-    if (buttonUp.wasReleased() && _selectedItem > 0)
+    else
     {
-      _selectedItem--;
-      _displayNeedUpdate = true;
+      u8g2.setCursor(0, 20 + (i * 10));
     }
-    if (buttonEnter.wasPressed())
-    {
-      arrayOfFunctions[_selectedItem]();
-      _displayNeedUpdate = true;
-    }
-    else if (buttonEnterActive && buttonEnter.pressedFor(2000))
+
+    if (frame.selectedItem == i)
     {
-      buttonEnterActive = false;
-      changeModeTo(MODE_GROUND);
+      u8g2.print(">");
     }
+    u8g2.print(menuItems[i]);
   }
+}
 
-  if (_displayNeedUpdate)
-  {
-
-    u8g2.clearBuffer();
-    u8g2.setFontDirection(0);
-    u8g2.setFont(u8g2_font_courR08_tf);
-    u8g2.setCursor(0, 8);
-    u8g2.print("Menu");
-    u8g2.drawHLine(0, 10, 128);
+void menuMode()
+{
+  static byte _selectedItem = 0;
+  static bool _displayNeedUpdate = true;
+  const byte _numberOfItems = menuItemCount;
+  Buttons::Event _event;
 
-    for (byte i = 0; i < _numberOfItems; i++)
+  if (lastMode != mode)
+  {
+    _displayNeedUpdate = true;
+    lastMode = mode;
+  }
+  else
+  {
+    while (buttons.read(_event))
     {
-      if (i == 0)
+      if (_event.button == BUTTON_DOWN && _event.type == Buttons::RELEASE && _selectedItem < _numberOfItems - 1)
       {
-        u8g2.setCursor(0, 20);
+        _selectedItem++;
+        _displayNeedUpdate = true;
       }
-      else
+      else if (_event.button == BUTTON_UP && _event.type == Buttons::RELEASE && _selectedItem > 0)
       {
-        u8g2.setCursor(0, 20 + (i * 10));
+        _selectedItem--;
+        _displayNeedUpdate = true;
       }
-
-      if (_selectedItem == i)
+      // the items without a function yet do nothing
+      else if (_event.button == BUTTON_ENTER && _event.type == Buttons::PRESS)
       {
-        u8g2.print(">");
+        if (_selectedItem < sizeof(menuFunctions) / sizeof(menuFunctions[0]))
+        {
+          menuFunctions[_selectedItem]();
+        }
+        _displayNeedUpdate = true;
+      }
+      else if (_event.button == BUTTON_ENTER && _event.type == Buttons::RELEASE)
+      {
+        buttonEnterActive = true;
+      }
+      // hold Enter to leave the Menu
+      else if (_event.button == BUTTON_ENTER && _event.type == Buttons::LONG_PRESS && _event.heldMs >= 2 * LONG_PRESS &&
+               buttonEnterActive)
+      {
+        buttonEnterActive = false;
+        changeModeTo(MODE_GROUND);
       }
-      u8g2.print(_menuItems[i]);
     }
+  }
 
-    u8g2.sendBuffer();
+  if (_displayNeedUpdate)
+  {
+    FrameState _frame = currentFrame(MODE_MENU);
+    _frame.selectedItem = _selectedItem;
+    renderTask.publish(_frame);
     _displayNeedUpdate = false;
   }
 };
@@ -575,56 +950,48 @@ void updateMode(){
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-void setup()
+// the render task draws every published frame with this, at its own pace on core 0
+void drawFrame(const FrameState &frame)
 {
-  if (debug)
+  if (frame.screen == SCREEN_OFF)
   {
-    Serial.begin(115200);
+    u8g2.setPowerSave(1);
+    return;
   }
-  Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
-  pressureSensor1.begin(0x76);
-  pressureSensor2.begin(0x77);
-  u8g2.begin();
-  u8g2.enableUTF8Print();
-  u8g2.setFlipMode(0);
-
-  esp_sleep_enable_timer_wakeup(sleepForTime * uS_TO_S_FACTOR);
-  esp_sleep_enable_ext0_wakeup(GPIO_NUM_32, 0);
-  esp_sleep_wakeup_cause_t wakeup_reason;
-  wakeup_reason = esp_sleep_get_wakeup_cause();
-  if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER)
+  u8g2.clearBuffer();
+  switch (frame.screen)
   {
-    checkAltitudeAfterWakeup();
-  }
+  case MODE_FREEFALL:
+    drawFreefall(frame);
+    break;
 
-  debugMessage("Startdruck:");
-  defaultPressure1 = pressureSensor1.readPressure() / 100;
-  defaultPressure2 = pressureSensor2.readPressure() / 100;
-  debugMessage((String)defaultPressure1);
-  debugMessage((String)defaultPressure2);
-  debugMessage("Starthöhe:");
-  checkAltitude();
-  debugMessage((String)currentAltitude);
-
-  buttonUp.begin();
-  buttonDown.begin();
-  buttonEnter.begin();
-  debugMessage("Uhrzeit:");
-  RtcDateTime now_test;
-  now_test = rtc.GetDateTime();
-  debugMessage((String)now_test);
+  case MODE_CANOPY:
+    drawCanopy(frame);
+    break;
+
+  case MODE_AIRPLANE:
+    drawAirplane(frame);
+    break;
+
+  case MODE_GROUND:
+    drawGround(frame);
+    break;
+
+  case MODE_MENU:
+    drawMenu(frame);
+    break;
+  }
+  u8g2.sendBuffer();
+#ifndef DISPLAY_SW_SPI
+  // on the panel before the frame counts as drawn, the latency includes the transfer
+  u8g2.wait();
+#endif
 }
 
 /* -------------------------------------------------------------------------------------------------------- */
 
-void loop()
+void runMode()
 {
-  currentMillis = millis();
-  checkAltitude();
-  readButtons();
-  getTime();
-  checkBattery();
-
   switch (mode)
   {
   case MODE_FREEFALL:
@@ -651,4 +1018,126 @@ void loop()
     updateMode();
     break;
   }
-}
\ No newline at end of file
+}
+
+// the mode logic runs on every new sample, and on the ground and in the menu also for every button event
+void onSamples()
+{
+  checkAltitude();
+  runMode();
+}
+
+void onButtons()
+{
+  runMode();
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void setup()
+{
+  esp_sleep_wakeup_cause_t wakeup_reason;
+  wakeup_reason = esp_sleep_get_wakeup_cause();
+#ifdef ULP_ALTITUDE_WATCH
+  altitudeWatch.stop();
+  bool _ulpClimb = wakeup_reason == ESP_SLEEP_WAKEUP_ULP && altitudeWatch.climbed();
+#else
+  bool _ulpClimb = false;
+#endif
+  Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
+  Wire.setClock(400000); // fast mode, supported by both BMP280 and the DS3231
+  if ((wakeup_reason == ESP_SLEEP_WAKEUP_TIMER || wakeup_reason == ESP_SLEEP_WAKEUP_ULP) && !_ulpClimb)
+  {
+    checkAltitudeFast();
+  }
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+  Serial.begin(115200);
+  // prints from core 0 whenever the sensor task waits
+  debugLog.begin(Serial, 0);
+#endif
+  sampleJob = scheduler.add("samples", 2 * sensorProfiles[mode].samplePeriod, onSamples);
+  buttonJob = scheduler.add("buttons", 0, onButtons);
+  timeJob = scheduler.add("clock", clockSyncInterval, syncClock);
+  batteryJob = scheduler.add("battery", batteryCheckInterval / BatteryMonitor::window, checkBattery);
+  scheduler.notifyOn(sampleJob, NOTIFY_SAMPLES);
+  scheduler.notifyOn(buttonJob, NOTIFY_BUTTONS);
+  scheduler.setLightSleepCheck(prepareLightSleep, resumeAfterLightSleep);
+  power.begin(powerUsage, MODE_UPDATE + 1);
+  power.apply(mode, powerProfiles[mode]);
+  pressureSensor1.begin(0x76);
+  pressureSensor2.begin(0x77);
+  u8g2.begin();
+  u8g2.enableUTF8Print();
+  u8g2.setFlipMode(0);
+  // the large digits are decoded here and not in the first frame after the exit
+  freefallDigits.begin(u8g2);
+  canopyDigits.begin(u8g2);
+  // drawing and the display transfer run next to the sensor task, which preempts them
+  renderTask.notifyWhenIdle(xTaskGetCurrentTaskHandle(), NOTIFY_RENDERED);
+  renderTask.begin(drawFrame, 0);
+
+  esp_sleep_enable_ext0_wakeup(GPIO_NUM_32, 0);
+  logDebug("fast wakeups: %u, avg %u us, max %u us", fastWakeups.count,
+           fastWakeups.count ? (uint32_t)(fastWakeups.totalUs / fastWakeups.count) : 0, fastWakeups.maxUs);
+#ifdef ULP_ALTITUDE_WATCH
+  if (wakeup_reason == ESP_SLEEP_WAKEUP_ULP)
+  {
+    logDebug("ULP watch: %s after %u checks, raw pressure %u", altitudeWatch.climbed() ? "climb" : "no climb",
+             altitudeWatch.checks(), altitudeWatch.lastRaw());
+  }
+#endif
+  if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER || wakeup_reason == ESP_SLEEP_WAKEUP_ULP)
+  {
+    checkAltitudeAfterWakeup();
+  }
+
+  // after a climb woke us up the ground reference from before the sleep stays
+  if (mode != MODE_AIRPLANE)
+  {
+    pressureSensor1.read();
+    pressureSensor2.read();
+    defaultPressure1 = pressureSensor1.pressure() / 100;
+    defaultPressure2 = pressureSensor2.pressure() / 100;
+    logDebug("Startdruck: %.2f / %.2f hPa", defaultPressure1, defaultPressure2);
+  }
+  // the reference changed, don't read the jump in altitude as speed
+  sensorFusion.reset();
+  altitudeFilter.reset();
+  updateAltitude(sensorTask.read());
+  logDebug("Starthöhe: %d %s", currentAltitude, DisplayUnits::altitudeSymbol);
+
+  jumpLog.begin();
+  jumpTrack.begin();
+  logDebug("logbook: last jump %u", jumpLog.lastJumpNumber());
+
+  // the loop wakes up for every button event, a press also ends a light sleep between two jobs
+  buttons.begin(xTaskGetCurrentTaskHandle(), NOTIFY_BUTTONS);
+  esp_sleep_enable_gpio_wakeup();
+  syncClock();
+  RtcDateTime now_test(softClock.seconds());
+  logDebug("Uhrzeit: %02u.%02u.%04u %02u:%02u:%02u", now_test.Day(), now_test.Month(), now_test.Year(), now_test.Hour(),
+           now_test.Minute(), now_test.Second());
+
+  esp_adc_cal_value_t _calibration = battery.begin();
+  batteryLevel = battery.level(5);
+  logDebug("battery %u mV (%s), %u%%, about %u jumps left", battery.millivolts(),
+           _calibration == ESP_ADC_CAL_VAL_EFUSE_TP     ? "eFuse two point"
+           : _calibration == ESP_ADC_CAL_VAL_EFUSE_VREF ? "eFuse Vref"
+                                                        : "default Vref",
+           battery.percent(), remainingJumps());
+
+  // sample on core 0, the Arduino loop runs on core 1 and wakes up for every sample
+  applySensorProfile(mode);
+  sensorTask.setConsumer(xTaskGetCurrentTaskHandle(), NOTIFY_SAMPLES);
+  sensorTask.begin(sensorProfiles[mode].samplePeriod, 0);
+}
+
+/* -------------------------------------------------------------------------------------------------------- */
+
+void loop()
+{
+  currentMillis = millis();
+  scheduler.runDue();
+  scheduler.idle();
+}